@@ -20,6 +20,7 @@
 #include "../include/awkccc_ast.hpp"
 #include "../include/awkccc_lexer.hpp"
 #include "../include/generate_cpp.h++"
+#include "../include/awkccc_analysis.h++"
 #include "../include/jString.hpp"
 #include "../include/jcargs.hpp"
 #include "../src/parser.h++"
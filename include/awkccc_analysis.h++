@@ -0,0 +1,174 @@
+/***
+**
+** AWKCCC: Analysis passes over the AST
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+
+
+/*
+ * File:   awkccc_analysis.h++
+ * Author: Julia Clement <Julia at Clement dot nz>
+ *
+ * Part of the awkccc project https://github.com/juliaclement/awkccc
+ *
+ * Created on 17 October 2026, 11:20
+ */
+#ifndef AWKCCC_ANALYSIS_HPP
+#define AWKCCC_ANALYSIS_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/awkccc_ast.hpp"
+#include "../include/awkccc_fields.h++"
+#include "../include/awkccc_reduction.h++"
+
+namespace awkccc {
+    /**
+     * Visits every node in a tree, including the dependant nodes of
+     * functions, loops & ternaries. Analysis passes derive from this &
+     * override the visit_ routines they care about, calling the base class
+     * version to carry on down the tree.
+    */
+    class ast_walker: public ast_node_visitor {
+        public:
+            void walk( ast_node * node ) {
+                if( node != nullptr )
+                    node->accept( this );
+            }
+            void walk_children( ast_node * node ) {
+                for( auto child : node->child_nodes_ )
+                    walk( child );
+            }
+            void walk_siblings( ast_node * node ) {
+                for( auto sibling : node->sibling_nodes_ )
+                    walk( sibling );
+            }
+            virtual void visit_ast_node( ast_node * node );
+            virtual void visit_ast_empty_node( ast_empty_node * node );
+            virtual void visit_ast_statement_node( ast_statement_node * node );
+            virtual void visit_ast_op_node( ast_op_node * node );
+            virtual void visit_ast_left_unary_op_node( ast_left_unary_op_node * node );
+            virtual void visit_ast_right_unary_op_node( ast_right_unary_op_node * node );
+            virtual void visit_ast_bin_op_node( ast_bin_op_node * node );
+            virtual void visit_ast_function_node( ast_function_node * node );
+            virtual void visit_ast_branch_loop_node( ast_branch_loop_node * node );
+            virtual void visit_ast_for_loop_node( ast_for_loop_node * node );
+            virtual void visit_ast_ternary_op_node( ast_ternary_op_node * node );
+            virtual ~ast_walker() {}
+    };
+
+    /// True if node is the operator node for op, e.g. "$" or "++"
+    bool is_operator( ast_node * node, const char * op );
+
+    /// True if node is a NUMBER token. If so, value is set to its value
+    bool is_number_constant( ast_node * node, double & value );
+
+    /// The operator token of an operator node, nullptr for other nodes
+    ast_node * operator_of( ast_node * node );
+
+    /// True if two expressions are written identically, as in the two $3s of
+    /// if( $3 > max ) max = $3
+    bool same_expression( ast_node * left, ast_node * right );
+
+    /**
+     * Rewrite each chain of concatenations, which the grammar builds as
+     * nested pairs joined by the dummy @@@ operator, as one ast_op_node
+     * with an operand per piece so a b c d can be built in one go. Chains
+     * carrying a pattern's action & the getline forms the parser also
+     * writes with @@@ are left alone.
+    */
+    void flatten_concatenations( ast_node * root );
+
+    /**
+     * Find which fields the program uses: the highest constant $n and
+     * whether NF or a computed field number appears anywhere.
+     * The result tells the runtime how far it needs to split each record.
+    */
+    Awkccc_field_usage analyse_field_usage( ast_node * root );
+
+    /// True if node is an ERE token such as /ab+c/
+    bool is_ere_literal( ast_node * node );
+
+    /// The regex of an ERE token, without its slashes
+    std::string_view ere_text( ast_node * node );
+
+    /// Every distinct constant ERE in the program, in the order first seen
+    std::vector<std::string> find_ere_literals( ast_node * root );
+
+    /// True if the program names variable anywhere, as SUBSEP might be
+    bool uses_variable( ast_node * root, const char * name );
+
+    /// True if the program keeps a field as an array key or in a variable,
+    /// as in count[$1]++, so sharing repeated field values saves memory
+    bool keeps_fields( ast_node * root );
+
+    /// A variable updated by the main rules & how shards' copies combine
+    struct Awkccc_reducer {
+        jclib::jString name_;
+        jclib::jString c_name_;
+        Awkccc_reduction reduction_;
+        bool is_array_;
+    };
+
+    /// Whether the main rules may run on several shards of the input at once
+    struct Awkccc_parallel_plan {
+        bool safe_ = false;
+        /// The main rules print, so each shard's output must be kept in input order
+        bool ordered_output_ = false;
+        /// Why not, when safe_ is false
+        jclib::jString reason_;
+        std::vector<Awkccc_reducer> reducers_;
+    };
+
+    /**
+     * Decide whether --parallel can be used: every record must be processed
+     * independently of the others, apart from variables updated by a
+     * reduction (++, +=, the max/min idiom or plain assignment of a variable
+     * the main rules never read). Printing to standard output is allowed;
+     * the driver keeps it in input order. Redirected output, getline, user
+     * functions, NR & any variable read after an earlier record may have
+     * changed it all refuse.
+    */
+    Awkccc_parallel_plan analyse_parallel( ast_node * root );
+
+    /// What a variable is proved to hold, & so how the generator declares it
+    enum Awkccc_static_type {
+        Static_Unset,       ///< Only while analysing: nothing assigned yet
+        Static_Integer,     ///< Whole numbers from bounded sources: int64_t
+        Static_Number,      ///< double
+        Static_String,      ///< jclib::jString
+        Static_Dynamic,     ///< Awkccc_variable
+        Static_Array        ///< Awkccc_array
+    };
+    struct Awkccc_variable_type {
+        jclib::jString name_;
+        jclib::jString c_name_;
+        Awkccc_static_type type_;
+    };
+
+    /**
+     * Infer a static type for every user variable from the values assigned
+     * to it. A variable only ever assigned numbers, or only strings, can be
+     * a native double, int64_t or jString provided nothing can read it
+     * before its first assignment in a way that would tell awk's
+     * uninitialised value, both "" & 0, from the native one. The rest are
+     * Static_Dynamic. Variables are listed in the order first seen.
+    */
+    std::vector<Awkccc_variable_type> analyse_variable_types( ast_node * root );
+}
+
+#endif
@@ -0,0 +1,110 @@
+/***
+**
+** AWKCCC Runtime per-record arena for temporary strings
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_ARENA_HPP
+#define AWKCCC_ARENA_HPP 1
+#include <cstddef>
+#include <memory>
+#include <vector>
+namespace awkccc {
+/** Memory for values that die with the record they were made from, such
+ *  as $3 in $3 > max or the string built by $1 ":" $2 in a lookup.
+ *
+ *  Allocation bumps a pointer through a chunk; reset() rewinds to the
+ *  first chunk without freeing any, so once the chunks have grown to fit
+ *  the largest record the per-record loop never calls malloc or free.
+ *  Nothing is destroyed, so only trivially destructible data belongs here.
+ **/
+class Awkccc_arena {
+    public:
+        static constexpr size_t default_chunk_size_ = 64 * 1024;
+        static constexpr size_t alignment_ = alignof( std::max_align_t );
+
+        explicit Awkccc_arena( size_t chunk_size = default_chunk_size_ )
+            : chunk_size_( chunk_size )
+            {}
+        /** A runtime copied for a parallel shard gets an empty arena of
+         *  its own: the temporaries in the original aren't copied */
+        Awkccc_arena( const Awkccc_arena & other )
+            : chunk_size_( other.chunk_size_ )
+            {}
+        Awkccc_arena & operator = ( const Awkccc_arena & ) {
+            return *this;
+        }
+
+        /** size bytes, suitably aligned for anything */
+        void * allocate( size_t size ) {
+            size = ( size + alignment_ - 1 ) & ~( alignment_ - 1 );
+            if( size > size_t( end_ - next_ ) )
+                next_chunk( size );
+            void * answer = next_;
+            next_ += size;
+            return answer;
+        }
+        /** Everything allocated so far may be reused */
+        void reset() {
+            current_ = 0;
+            if( chunks_.empty() ) {
+                next_ = end_ = nullptr;
+            } else {
+                next_ = chunks_[0].memory_.get();
+                end_ = next_ + chunks_[0].size_;
+            }
+        }
+        /** Bytes of memory held, used or not */
+        size_t capacity() const {
+            size_t answer = 0;
+            for( auto & chunk : chunks_ )
+                answer += chunk.size_;
+            return answer;
+        }
+    private:
+        struct chunk {
+            std::unique_ptr<char[]> memory_;
+            size_t size_;
+        };
+        size_t chunk_size_;
+        std::vector<chunk> chunks_;
+        /// The chunk being allocated from
+        size_t current_ = 0;
+        char * next_ = nullptr;
+        char * end_ = nullptr;
+
+        /** Move on to a chunk of at least size bytes, reusing the chunks
+         *  left from earlier records before making a new one */
+        void next_chunk( size_t size ) {
+            size_t start = chunks_.empty() || next_ == nullptr ? 0 : current_ + 1;
+            for( size_t i = start; i < chunks_.size(); ++i ) {
+                if( chunks_[i].size_ >= size ) {
+                    // A chunk too small for this request is skipped, not lost:
+                    // the next reset() starts from the first one again
+                    current_ = i;
+                    next_ = chunks_[i].memory_.get();
+                    end_ = next_ + chunks_[i].size_;
+                    return;
+                }
+            }
+            size_t bytes = size > chunk_size_ ? size : chunk_size_;
+            chunks_.push_back( chunk{ std::unique_ptr<char[]>( new char[bytes] ), bytes } );
+            current_ = chunks_.size() - 1;
+            next_ = chunks_.back().memory_.get();
+            end_ = next_ + bytes;
+        }
+};
+}
+#endif
@@ -0,0 +1,479 @@
+/***
+**
+** AWKCCC Runtime associative arrays
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_ARRAY_HPP
+#define AWKCCC_ARRAY_HPP 1
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "../include/awkccc_variable.h++"
+namespace awkccc {
+/** The subscripts of arr[i,j,...] as text, kept apart rather than joined
+ *  with SUBSEP. Awkccc_array hashes & compares them a piece at a time, so
+ *  finding an element that already exists never builds the joined string;
+ *  it is only made when a new element needs its key stored.
+ *
+ *  The parts may point into the object itself, so it can't be copied:
+ *  build it where it is used, as in arr[ subscripts( SUBSEP, i, j ) ].
+ **/
+template< size_t Arity >
+class Awkccc_subscripts {
+    public:
+        std::string_view separator_;
+        std::string_view parts_[Arity];
+
+        template< typename... Parts >
+        explicit Awkccc_subscripts( std::string_view separator, const Parts &... parts )
+            : separator_( separator ) {
+            static_assert( sizeof...( Parts ) == Arity, "one part per subscript" );
+            size_t i = 0;
+            ( ( parts_[i] = as_text( parts, buffers_[i] ), ++i ), ... );
+        }
+        Awkccc_subscripts( const Awkccc_subscripts & ) = delete;
+        Awkccc_subscripts & operator = ( const Awkccc_subscripts & ) = delete;
+
+        /** Length of the joined key */
+        size_t size() const {
+            size_t answer = separator_.size() * ( Arity - 1 );
+            for( auto & text : parts_ )
+                answer += text.size();
+            return answer;
+        }
+        /** Write the key as for( k in arr ) sees it to out, size() chars */
+        void copy_to( char * out ) const {
+            for( size_t i = 0; i < Arity; ++i ) {
+                if( i > 0 ) {
+                    std::memcpy( out, separator_.data(), separator_.size() );
+                    out += separator_.size();
+                }
+                std::memcpy( out, parts_[i].data(), parts_[i].size() );
+                out += parts_[i].size();
+            }
+        }
+        std::string joined() const {
+            std::string answer( size(), '\0' );
+            copy_to( answer.data() );
+            return answer;
+        }
+        /** Only a SUBSEP of digits can join parts into a key like "12" */
+        bool may_be_integer() const {
+            for( char c : separator_ )
+                if( c < '0' || c > '9' )
+                    return false;
+            return true;
+        }
+    private:
+        Awkccc_number_format::text buffers_[Arity];
+};
+
+/** Awkccc_subscripts for arr[i,j,...], deducing the arity */
+template< typename... Parts >
+inline Awkccc_subscripts<sizeof...( Parts )> subscripts( std::string_view separator, const Parts &... parts ) {
+    return Awkccc_subscripts<sizeof...( Parts )>( separator, parts... );
+}
+
+/** An AWK array: subscripts are strings, values Awkccc_variables.
+ *
+ *  Subscripts that are small non-negative integers in canonical form,
+ *  "0", "1", "42" but not "01" or "-1", are held in a vector indexed by
+ *  their value while it stays at least half full. Everything else goes
+ *  in an open-addressing table with linear probing. Each slot's hash is
+ *  kept alongside it so a probe only compares keys whose hashes match &
+ *  growing the table never rehashes a key. Keys are hashed a piece at a
+ *  time so arr[i,j] can be found from its Awkccc_subscripts.
+ *
+ *  References returned by operator[] are only good until the next
+ *  element is added. Iteration order is unspecified, as in awk.
+ **/
+class Awkccc_array {
+    public:
+        /// Integer subscripts below this are always held in the vector
+        static constexpr size_t dense_floor_ = 64;
+        static constexpr size_t initial_slots_ = 16;
+
+        /** arr[key], creating the element if it doesn't exist */
+        Awkccc_variable & operator[]( std::string_view key ) {
+            size_t index;
+            if( dense_index( key, index ) && ( index < dense_.size() || grow_dense( index ) ) )
+                return dense_at( index );
+            return hashed_at( key, hash( key ) );
+        }
+        Awkccc_variable & operator[]( const char * key ) {
+            return (*this)[ std::string_view( key ) ];
+        }
+        Awkccc_variable & operator[]( const std::string & key ) {
+            return (*this)[ std::string_view( key ) ];
+        }
+        Awkccc_variable & operator[]( const jclib::jString & key ) {
+            return (*this)[ std::string_view( key ) ];
+        }
+        Awkccc_variable & operator[]( double key ) {
+            size_t index;
+            if( dense_index( key, index ) && ( index < dense_.size() || grow_dense( index ) ) )
+                return dense_at( index );
+            Awkccc_number_format::text buf;
+            std::string_view text = number_key( key, buf );
+            return hashed_at( text, hash( text ) );
+        }
+        template< typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer> > >
+        Awkccc_variable & operator[]( Integer key ) {
+            return (*this)[ double( key ) ];
+        }
+        template< typename Variable, typename = std::enable_if_t<std::is_same_v<Variable, Awkccc_variable> > >
+        Awkccc_variable & operator[]( const Variable & key ) {
+            if( ! key.string_is_valid() )
+                return (*this)[ key.number_ ];
+            shared_key text{ key, key.string_value() };
+            size_t index;
+            if( dense_index( text.text_, index ) && ( index < dense_.size() || grow_dense( index ) ) )
+                return dense_at( index );
+            return hashed_at( text, hash( text.text_ ) );
+        }
+
+        /** arr[i,j,...] */
+        template< size_t Arity >
+        Awkccc_variable & operator[]( const Awkccc_subscripts<Arity> & key ) {
+            if( key.may_be_integer() )
+                return (*this)[ std::string_view( key.joined() ) ];
+            return hashed_at( key, hash( key ) );
+        }
+
+        /** The element, nullptr if there is none. Never creates one */
+        const Awkccc_variable * find( std::string_view key ) const {
+            size_t index;
+            if( dense_index( key, index ) && index < dense_.size() )
+                return present_[index] ? &dense_[index] : nullptr;
+            size_t slot = find_slot( key, hash( key ) );
+            return slot == npos_ ? nullptr : &slots_[slot].value_;
+        }
+        const Awkccc_variable * find( double key ) const {
+            size_t index;
+            if( dense_index( key, index ) && index < dense_.size() )
+                return present_[index] ? &dense_[index] : nullptr;
+            Awkccc_number_format::text buf;
+            return find( number_key( key, buf ) );
+        }
+        template< typename Variable, typename = std::enable_if_t<std::is_same_v<Variable, Awkccc_variable> > >
+        const Awkccc_variable * find( const Variable & key ) const {
+            return key.string_is_valid() ? find( key.string_value() ) : find( key.number_ );
+        }
+        template< size_t Arity >
+        const Awkccc_variable * find( const Awkccc_subscripts<Arity> & key ) const {
+            if( key.may_be_integer() )
+                return find( std::string_view( key.joined() ) );
+            size_t slot = find_slot( key, hash( key ) );
+            return slot == npos_ ? nullptr : &slots_[slot].value_;
+        }
+        /** key in arr, & ( i, j ) in arr */
+        template< typename Key >
+        inline bool contains( const Key & key ) const {
+            return find( key ) != nullptr;
+        }
+        /** delete arr[key]. Returns false if there was no such element */
+        bool erase( std::string_view key ) {
+            size_t index;
+            if( dense_index( key, index ) && index < dense_.size() )
+                return erase_dense( index );
+            size_t slot = find_slot( key, hash( key ) );
+            if( slot == npos_ )
+                return false;
+            if( dense_index( key, index ) )
+                --hashed_integers_;
+            hashes_[slot] = deleted_;
+            slots_[slot] = slot_entry();
+            --hashed_count_;
+            ++deleted_count_;
+            return true;
+        }
+        bool erase( double key ) {
+            size_t index;
+            if( dense_index( key, index ) && index < dense_.size() )
+                return erase_dense( index );
+            Awkccc_number_format::text buf;
+            return erase( number_key( key, buf ) );
+        }
+        template< typename Variable, typename = std::enable_if_t<std::is_same_v<Variable, Awkccc_variable> > >
+        bool erase( const Variable & key ) {
+            return key.string_is_valid() ? erase( key.string_value() ) : erase( key.number_ );
+        }
+        template< size_t Arity >
+        bool erase( const Awkccc_subscripts<Arity> & key ) {
+            if( key.may_be_integer() )
+                return erase( std::string_view( key.joined() ) );
+            size_t slot = find_slot( key, hash( key ) );
+            if( slot == npos_ )
+                return false;
+            hashes_[slot] = deleted_;
+            slots_[slot] = slot_entry();
+            --hashed_count_;
+            ++deleted_count_;
+            return true;
+        }
+        /** delete arr */
+        void clear() {
+            dense_.clear();
+            present_.clear();
+            hashes_.clear();
+            slots_.clear();
+            dense_count_ = hashed_count_ = deleted_count_ = hashed_integers_ = 0;
+        }
+        /** length( arr ) */
+        inline size_t size() const {
+            return dense_count_ + hashed_count_;
+        }
+        inline bool empty() const {
+            return size() == 0;
+        }
+        /** Call action( std::string_view key, const Awkccc_variable & value ) for every element */
+        template< typename Action >
+        void for_each( Action action ) const {
+            Awkccc_number_format::text buf;
+            for( size_t index = 0; index < dense_.size(); ++index )
+                if( present_[index] )
+                    action( number_key( double( index ), buf ), dense_[index] );
+            for( size_t slot = 0; slot < hashes_.size(); ++slot )
+                if( hashes_[slot] > deleted_ )
+                    action( slots_[slot].key_.string_value(), slots_[slot].value_ );
+        }
+        /** The subscripts for for( key in arr ), taken before the loop body
+         *  can add or delete elements */
+        std::vector<std::string> keys() const {
+            std::vector<std::string> answer;
+            answer.reserve( size() );
+            for_each( [&]( std::string_view key, const Awkccc_variable & ) {
+                answer.emplace_back( key );
+            } );
+            return answer;
+        }
+    private:
+        static constexpr size_t npos_ = size_t( -1 );
+        /// A string subscript held in a variable. A new element's key
+        /// shares the variable's text instead of copying it
+        struct shared_key {
+            const Awkccc_variable & variable_;
+            std::string_view text_;
+        };
+        /// Hash values marking empty & deleted slots. Real hashes are moved above them
+        static constexpr uint64_t empty_ = 0;
+        static constexpr uint64_t deleted_ = 1;
+        /// Keys are held as string variables so they can share text, with
+        /// each other & with interned field values
+        struct slot_entry {
+            Awkccc_variable key_;
+            Awkccc_variable value_;
+        };
+        std::vector<Awkccc_variable> dense_;
+        std::vector<char> present_;
+        std::vector<uint64_t> hashes_;
+        std::vector<slot_entry> slots_;
+        size_t dense_count_ = 0;
+        size_t hashed_count_ = 0;
+        size_t deleted_count_ = 0;
+        /// Canonical integer keys in the table, that grow_dense() must move
+        size_t hashed_integers_ = 0;
+
+        /// FNV-1a, which can be fed a key in pieces
+        static constexpr uint64_t hash_basis_ = 14695981039346656037ull;
+        static inline uint64_t hash_more( uint64_t answer, std::string_view text ) {
+            for( unsigned char c : text )
+                answer = ( answer ^ c ) * 1099511628211ull;
+            return answer;
+        }
+        /** Fold the high bits, which FNV mixes best, into the low ones the
+         *  table indexes by */
+        static inline uint64_t hash_done( uint64_t answer ) {
+            answer ^= answer >> 32;
+            return answer > deleted_ ? answer : answer + 2;
+        }
+        static inline uint64_t hash( std::string_view key ) {
+            return hash_done( hash_more( hash_basis_, key ) );
+        }
+        template< size_t Arity >
+        static uint64_t hash( const Awkccc_subscripts<Arity> & key ) {
+            uint64_t answer = hash_more( hash_basis_, key.parts_[0] );
+            for( size_t i = 1; i < Arity; ++i )
+                answer = hash_more( hash_more( answer, key.separator_ ), key.parts_[i] );
+            return hash_done( answer );
+        }
+        static inline bool same_key( const Awkccc_variable & stored, std::string_view key ) {
+            return stored.string_value() == key;
+        }
+        static inline bool same_key( const Awkccc_variable & stored, const shared_key & key ) {
+            return stored.same_text( key.variable_ ) || stored.string_value() == key.text_;
+        }
+        template< size_t Arity >
+        static bool same_key( const Awkccc_variable & stored, const Awkccc_subscripts<Arity> & key ) {
+            std::string_view rest( stored.string_value() );
+            if( rest.size() != key.size() )
+                return false;
+            for( size_t i = 0; i < Arity; ++i ) {
+                if( i > 0 ) {
+                    if( rest.substr( 0, key.separator_.size() ) != key.separator_ )
+                        return false;
+                    rest.remove_prefix( key.separator_.size() );
+                }
+                if( rest.substr( 0, key.parts_[i].size() ) != key.parts_[i] )
+                    return false;
+                rest.remove_prefix( key.parts_[i].size() );
+            }
+            return true;
+        }
+        static inline void store_key( Awkccc_variable & stored, std::string_view key ) {
+            stored = Awkccc_variable( key );
+        }
+        static inline void store_key( Awkccc_variable & stored, const shared_key & key ) {
+            stored = key.variable_;
+        }
+        template< size_t Arity >
+        static void store_key( Awkccc_variable & stored, const Awkccc_subscripts<Arity> & key ) {
+            stored = Awkccc_variable::filled( key.size(), [&key]( char * out ) { key.copy_to( out ); } );
+        }
+        /** Is key a canonical non-negative integer that could be a vector index */
+        static bool dense_index( std::string_view key, size_t & index ) {
+            if( key.empty() || key.size() > 9 || ( key[0] == '0' && key.size() > 1 ) )
+                return false;
+            size_t value = 0;
+            for( char c : key ) {
+                if( c < '0' || c > '9' )
+                    return false;
+                value = value * 10 + ( c - '0' );
+            }
+            index = value;
+            return true;
+        }
+        static bool dense_index( double key, size_t & index ) {
+            if( ! ( key >= 0 && key < 1e9 ) || key != std::trunc( key ) )
+                return false;
+            index = size_t( key );
+            return true;
+        }
+        /** A numeric subscript as a string, through CONVFMT */
+        static inline std::string_view number_key( double key, Awkccc_number_format::text & buf ) {
+            return conversion_format().format( key, buf );
+        }
+
+        inline Awkccc_variable & dense_at( size_t index ) {
+            if( ! present_[index] ) {
+                present_[index] = true;
+                ++dense_count_;
+            }
+            return dense_[index];
+        }
+        /** Extend the vector to cover index if it would still be half full.
+         *  Integer keys already in the table for the new range move across */
+        bool grow_dense( size_t index ) {
+            if( index >= dense_floor_ && index >= 2 * ( dense_count_ + 1 ) )
+                return false;
+            size_t old_size = dense_.size();
+            dense_.resize( index + 1 );
+            present_.resize( index + 1, false );
+            Awkccc_number_format::text buf;
+            for( size_t moving = old_size; hashed_integers_ > 0 && moving < dense_.size(); ++moving ) {
+                std::string_view key = number_key( double( moving ), buf );
+                size_t slot = find_slot( key, hash( key ) );
+                if( slot == npos_ )
+                    continue;
+                dense_[moving] = slots_[slot].value_;
+                present_[moving] = true;
+                ++dense_count_;
+                hashes_[slot] = deleted_;
+                slots_[slot] = slot_entry();
+                --hashed_count_;
+                ++deleted_count_;
+                --hashed_integers_;
+            }
+            return true;
+        }
+        bool erase_dense( size_t index ) {
+            if( ! present_[index] )
+                return false;
+            present_[index] = false;
+            dense_[index] = Awkccc_variable();
+            --dense_count_;
+            return true;
+        }
+
+        template< typename Key >
+        size_t find_slot( const Key & key, uint64_t hash_value ) const {
+            if( hashes_.empty() )
+                return npos_;
+            const size_t mask = hashes_.size() - 1;
+            for( size_t slot = hash_value & mask; ; slot = ( slot + 1 ) & mask ) {
+                if( hashes_[slot] == empty_ )
+                    return npos_;
+                if( hashes_[slot] == hash_value && same_key( slots_[slot].key_, key ) )
+                    return slot;
+            }
+        }
+        template< typename Key >
+        Awkccc_variable & hashed_at( const Key & key, uint64_t hash_value ) {
+            size_t slot = find_slot( key, hash_value );
+            if( slot != npos_ )
+                return slots_[slot].value_;
+            // The key may be text held in this table, as in a[a["x"]], which
+            // rehash() moves, so it's stored before the table grows
+            Awkccc_variable stored;
+            store_key( stored, key );
+            // Keep at most three quarters of the slots in use, counting deleted ones
+            if( ( hashed_count_ + deleted_count_ + 1 ) * 4 > hashes_.size() * 3 )
+                rehash( ( hashed_count_ + 1 ) * 2 );
+            const size_t mask = hashes_.size() - 1;
+            for( slot = hash_value & mask; hashes_[slot] > deleted_; slot = ( slot + 1 ) & mask )
+                ;
+            if( hashes_[slot] == deleted_ )
+                --deleted_count_;
+            hashes_[slot] = hash_value;
+            slots_[slot].key_ = std::move( stored );
+            ++hashed_count_;
+            size_t index;
+            if( dense_index( slots_[slot].key_.string_value(), index ) )
+                ++hashed_integers_;
+            return slots_[slot].value_;
+        }
+        /** Move every element to a table of at least wanted slots, dropping deleted ones */
+        void rehash( size_t wanted ) {
+            size_t size = initial_slots_;
+            while( size < wanted )
+                size *= 2;
+            std::vector<uint64_t> old_hashes( size, empty_ );
+            std::vector<slot_entry> old_slots( size );
+            old_hashes.swap( hashes_ );
+            old_slots.swap( slots_ );
+            const size_t mask = size - 1;
+            for( size_t old = 0; old < old_hashes.size(); ++old ) {
+                if( old_hashes[old] <= deleted_ )
+                    continue;
+                size_t slot = old_hashes[old] & mask;
+                while( hashes_[slot] != empty_ )
+                    slot = ( slot + 1 ) & mask;
+                hashes_[slot] = old_hashes[old];
+                slots_[slot].key_ = std::move( old_slots[old].key_ );
+                slots_[slot].value_ = std::move( old_slots[old].value_ );
+            }
+            deleted_count_ = 0;
+        }
+};
+}
+#endif
@@ -30,6 +30,10 @@
 #define AWKCCC_AST_HPP
 #include "countedPointer.hpp"
 #include "jString.hpp"
+#include "awkccc_arena.h++"
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace {
@@ -155,6 +159,9 @@ namespace awkccc {
 
         virtual Symbol * find( jclib::jString &awk_namespace, jclib::jString &awk_name) = 0;
 
+        /// As above, without making strings of namespace & name
+        virtual Symbol * find( std::string_view awk_namespace, std::string_view awk_name) = 0;
+
         /**
          * return existing Symbol or create a new one
         */
@@ -165,6 +172,14 @@ namespace awkccc {
                 bool namespace_required, /// true if forced by code
                 SymbolType type = VARIABLE ) = 0;
 
+        /// As above, making strings of namespace & name only for a new Symbol
+        virtual Symbol * get( 
+                std::string_view awk_namespace,
+                std::string_view awk_name,
+                int token,
+                bool namespace_required,
+                SymbolType type = VARIABLE ) = 0;
+
         virtual void load(std::initializer_list<struct _Symbol_loader>) = 0;
         
         virtual void loadnamespace(const jclib::jString &namespace_name,
@@ -206,7 +221,112 @@ namespace awkccc {
             virtual void visit_ast_ternary_op_node(class ast_ternary_op_node *)=0;
     };
 
-    class ast_node: public jclib::CountedPointerTarget {
+    class ast_node;
+
+    /**
+     * A pointer to a node in an ast_arena. Nodes aren't counted or deleted
+     * one at a time: the arena that made them destroys them all at once.
+     * Has the interface of the CountedPointer it replaces.
+    */
+    template< typename Node >
+    class ast_ptr {
+        public:
+            ast_ptr() {}
+            ast_ptr( Node * node )
+                : node_( node )
+                {}
+            template< typename Other >
+            ast_ptr( const ast_ptr<Other> & other )
+                : node_( other.get() )
+                {}
+            inline Node * get() const { return node_; }
+            inline Node * operator -> () const { return node_; }
+            inline Node & operator * () const { return *node_; }
+            inline operator Node * () const { return node_; }
+            inline bool isset() const { return node_ != nullptr; }
+        private:
+            Node * node_ = nullptr;
+    };
+    typedef ast_ptr<ast_node> ast_node_ptr;
+
+    /**
+     * A node's children or siblings: a run of pointers in the ast_arena,
+     * moved to a run twice the size when it fills. Half the size of the
+     * std::vector it replaces & never touches the heap.
+    */
+    class ast_node_list {
+        public:
+            typedef ast_node_ptr * iterator;
+            typedef const ast_node_ptr * const_iterator;
+            ast_node_list() {}
+            ast_node_list( const ast_node_list & other ) {
+                *this = other;
+            }
+            /// Copies the pointers into a run of this list's own
+            ast_node_list & operator = ( const ast_node_list & other );
+            inline size_t size() const { return size_; }
+            inline bool empty() const { return size_ == 0; }
+            inline ast_node_ptr & operator[]( size_t i ) { return items_[i]; }
+            inline const ast_node_ptr & operator[]( size_t i ) const { return items_[i]; }
+            inline iterator begin() { return items_; }
+            inline iterator end() { return items_ + size_; }
+            inline const_iterator begin() const { return items_; }
+            inline const_iterator end() const { return items_ + size_; }
+            inline void push_back( ast_node_ptr node ) {
+                if( size_ == capacity_ )
+                    grow( capacity_ ? capacity_ * 2 : 2 );
+                items_[size_++] = node;
+            }
+            inline void clear() { size_ = 0; }
+        private:
+            ast_node_ptr * items_ = nullptr;
+            uint32_t size_ = 0;
+            uint32_t capacity_ = 0;
+            void grow( uint32_t capacity );
+    };
+
+    /**
+     * Owns every node made while it is current, & the runs of their
+     * child & sibling lists, for one compilation. Nodes are bump allocated
+     * & destroyed together when the arena is, so building the tree costs
+     * no malloc per node & no reference counting.
+     *
+     * Constructing an arena makes it current until it is destroyed. Nodes
+     * made with no arena current belong to one that lasts the process.
+     * Tokens that carry nothing but their symbol, such as ( ; or a
+     * newline, are made once per arena & shared: token() returns them.
+    */
+    class ast_arena {
+        public:
+            ast_arena();
+            ast_arena( const ast_arena & ) = delete;
+            ast_arena & operator = ( const ast_arena & ) = delete;
+            ~ast_arena();
+
+            static ast_arena & current();
+            /// Memory for a node, destroyed with the arena
+            void * allocate_node( size_t size );
+            /// Give back the last node's memory when its constructor throws
+            void abandon_node( void * memory );
+            /// Memory for anything with no destructor to run
+            inline void * allocate( size_t size ) {
+                return memory_.allocate( size );
+            }
+            /// The node for a token: shared if it is punctuation
+            ast_node * token( Symbol * sym, node_types type = Expression );
+            static bool is_shared_token( const jclib::jString & name );
+            inline size_t node_count() const {
+                return nodes_.size();
+            }
+        private:
+            Awkccc_arena memory_;
+            std::vector<ast_node *> nodes_;
+            std::unordered_map<Symbol *, ast_node *> shared_tokens_;
+            ast_arena * previous_;
+            static ast_arena * current_;
+    };
+
+    class ast_node {
         public:
             node_types type_;
             jclib::jString name_;
@@ -215,11 +335,21 @@ namespace awkccc {
             bool extra_children_allowed_;
             bool dummy_;
             jclib::CountedPointer<Symbol> sym_;
-            std::vector<jclib::CountedPointer<ast_node> > sibling_nodes_;
-            std::vector<jclib::CountedPointer<ast_node> > child_nodes_;
+            ast_node_list sibling_nodes_;
+            ast_node_list child_nodes_;
+            /// Nodes live in the current ast_arena
+            static void * operator new( size_t size ) {
+                return ast_arena::current().allocate_node( size );
+            }
+            static void operator delete( void * memory ) {
+                ast_arena::current().abandon_node( memory );
+            }
+            virtual ~ast_node() {}
             // Despatcher for Visitors
             virtual void accept( ast_node_visitor * visitor ){
                 visitor->visit_ast_node( this );}
+            /// A node for a grammar rule such as item_list. Only tokens have
+            /// symbols: rule names are never looked up or added to the table
             ast_node(   node_types type,
                         jclib::jString name,
                         int rule_nr = -1,
@@ -234,7 +364,6 @@ namespace awkccc {
             , sibling_nodes_()
             , child_nodes_()
             {
-                sym_ = SymbolTable::instance().get(Empty_String, name_, false, 0, VARIABLE );
             }
             ast_node(   node_types type,
                         jclib::jString awk_namespace,
@@ -252,7 +381,6 @@ namespace awkccc {
             , sibling_nodes_()
             , child_nodes_()
             {
-                sym_ = SymbolTable::instance().get(awk_namespace, name_, namespace_required, 0, VARIABLE );
             }
             ast_node( char * full_name, node_types type, Symbol *sym, int rule_nr = -1, bool dummy = false)
             : type_( type )
@@ -278,7 +406,7 @@ namespace awkccc {
             , child_nodes_()
             {
             }
-            ast_node * add_sibling(jclib::CountedPointer<ast_node> adoptee) {
+            ast_node * add_sibling(ast_node_ptr adoptee) {
                 if( rule_nr_ == -1 )
                     rule_nr_ = adoptee->rule_nr_;
                 if( ! has_sym_ && adoptee->has_sym_ ) {
@@ -288,7 +416,7 @@ namespace awkccc {
                 sibling_nodes_.push_back(adoptee);
                 return this;
             }
-            ast_node * add_child(jclib::CountedPointer<ast_node> adoptee) {
+            ast_node * add_child(ast_node_ptr adoptee) {
                 if( rule_nr_ == -1 )
                     rule_nr_ = adoptee->rule_nr_;
                 if( ! has_sym_ && adoptee->has_sym_ ) {
@@ -298,12 +426,11 @@ namespace awkccc {
                 child_nodes_.push_back(adoptee);
                 return this;
             }
-            ast_node * add_children( std::initializer_list< jclib::CountedPointer<ast_node> > adoptees);
+            ast_node * add_children( std::initializer_list< ast_node_ptr > adoptees);
 
             /*** Recursively promote siblings to parent (if allowed) */
             virtual void clean_tree(ast_node * parent);
     };
-    typedef  jclib::CountedPointer<awkccc::ast_node> ast_node_ptr;
 
     void print_ast( std::ostream & out, 
                     ast_node * node,
@@ -324,17 +451,17 @@ namespace awkccc {
             {}
     };
 
-    inline jclib::CountedPointer<ast_node> empty_node( jclib::jString rulename, int rule_nr = -1, bool dummy = true ) {
+    inline ast_node_ptr empty_node( jclib::jString rulename, int rule_nr = -1, bool dummy = true ) {
         return new ast_empty_node( Empty, rulename, rule_nr, dummy);
     }
 
-    inline jclib::CountedPointer<ast_node> empty_node( const char * rulename, int rule_nr = -1 ) {
+    inline ast_node_ptr empty_node( const char * rulename, int rule_nr = -1 ) {
         return new ast_empty_node( Empty, jclib::jString(rulename), rule_nr);
     }
     
     class ast_statement_node: public ast_node {
         public:
-            jclib::CountedPointer< ast_node > kw_node_;
+            ast_node_ptr kw_node_;
             virtual void accept( ast_node_visitor * visitor ){
                 visitor->visit_ast_statement_node( this );}
             ast_statement_node( ast_node * kw_node, awkccc::node_types type, jclib::jString name, int rule_nr = -1)
@@ -342,18 +469,18 @@ namespace awkccc {
                 , kw_node_( kw_node )
                 {
                 }
-            ast_statement_node( jclib::CountedPointer< ast_node > kw_node, awkccc::node_types type, jclib::jString name, int rule_nr = -1)
+            ast_statement_node( ast_node_ptr kw_node, awkccc::node_types type, jclib::jString name, int rule_nr = -1)
                 : ast_node( type, Empty_String, name, false, rule_nr )
                 , kw_node_( kw_node )
                 {
                 }
     };
 
-    inline jclib::CountedPointer<ast_node> statement_node( ast_node * kw_node, int rule_nr = -1 ) {
+    inline ast_node_ptr statement_node( ast_node * kw_node, int rule_nr = -1 ) {
         return new ast_statement_node( kw_node, Statement, kw_node->sym_->awk_name_, rule_nr);
     }
 
-    inline jclib::CountedPointer<ast_node> statement_node( ast_node * kw_node, std::initializer_list< jclib::CountedPointer<ast_node> > children, int rule_nr = -1 ) {
+    inline ast_node_ptr statement_node( ast_node * kw_node, std::initializer_list< ast_node_ptr > children, int rule_nr = -1 ) {
         auto answer = new ast_statement_node( kw_node, Statement, kw_node->sym_->awk_name_, rule_nr);
         answer->add_children( children);
         return answer;
@@ -361,7 +488,7 @@ namespace awkccc {
 
     class ast_op_node: public ast_node {
         public:
-            jclib::CountedPointer< ast_node > op_node_;
+            ast_node_ptr op_node_;
             virtual void accept( ast_node_visitor * visitor ){
                 visitor->visit_ast_op_node( this );
             }
@@ -370,7 +497,7 @@ namespace awkccc {
                 , op_node_( op )
                 {
                 }
-            ast_op_node( jclib::CountedPointer< ast_node > op, awkccc::node_types type, jclib::jString name, int rule_nr = -1)
+            ast_op_node( ast_node_ptr op, awkccc::node_types type, jclib::jString name, int rule_nr = -1)
                 : ast_node( type, Empty_String, name, false, rule_nr )
                 , op_node_( op )
                 {
@@ -387,13 +514,13 @@ namespace awkccc {
             {
                 add_child(right);
             }
-            ast_left_unary_op_node( jclib::CountedPointer<ast_node> op, jclib::CountedPointer<ast_node> right, int rule_nr = -1)
+            ast_left_unary_op_node( ast_node_ptr op, ast_node_ptr right, int rule_nr = -1)
                 : ast_op_node( op, Expression, "LEFT UNARY_OP", rule_nr )
             {
                 add_child(right);
             }
     };
-    inline jclib::CountedPointer<ast_node> ast_left_unary_op( jclib::CountedPointer<ast_node> op, jclib::CountedPointer<ast_node> right, int rule_nr = -1) {
+    inline ast_node_ptr ast_left_unary_op( ast_node_ptr op, ast_node_ptr right, int rule_nr = -1) {
         return new ast_left_unary_op_node( op, right, rule_nr);
     }
 
@@ -408,7 +535,7 @@ namespace awkccc {
                 add_child(left);
             }
     };
-    inline jclib::CountedPointer<ast_node> ast_right_unary_op( ast_node * left, ast_node * op, int rule_nr = -1 ) {
+    inline ast_node_ptr ast_right_unary_op( ast_node * left, ast_node * op, int rule_nr = -1 ) {
         return new ast_right_unary_op_node( left, op, rule_nr);
     }
 
@@ -422,7 +549,7 @@ namespace awkccc {
                 add_child(left);
                 add_child(right);
             }
-            ast_bin_op_node( jclib::CountedPointer<ast_node> left,  jclib::CountedPointer<ast_node> op, jclib::CountedPointer<ast_node> right, int rule_nr = -1)
+            ast_bin_op_node( ast_node_ptr left,  ast_node_ptr op, ast_node_ptr right, int rule_nr = -1)
                 : ast_op_node( op, Expression,  jclib::jString("BIN_OP "), rule_nr )
             {
                 add_child(left);
@@ -430,29 +557,28 @@ namespace awkccc {
             }
     };
 
-    inline jclib::CountedPointer<ast_node> ast_bin_op( jclib::CountedPointer<ast_node> left,  jclib::CountedPointer<ast_node> op, jclib::CountedPointer<ast_node> right, int rule_nr = -1) {
+    inline ast_node_ptr ast_bin_op( ast_node_ptr left,  ast_node_ptr op, ast_node_ptr right, int rule_nr = -1) {
         return new ast_bin_op_node( left,  op, right, rule_nr);
     }
 
-    inline jclib::CountedPointer<ast_node> ast_concatenate_expr( jclib::CountedPointer<ast_node> left, jclib::CountedPointer<ast_node> right, int rule_nr = -1) {
-        auto kw = jclib::jString("@@@");
-        Symbol * op_sym = SymbolTable::instance().find( Empty_String,kw);
-        jclib::CountedPointer<ast_node> op = new ast_node( Operator, op_sym);
+    inline ast_node_ptr ast_concatenate_expr( ast_node_ptr left, ast_node_ptr right, int rule_nr = -1) {
+        Symbol * op_sym = SymbolTable::instance().find( std::string_view(), "@@@" );
+        ast_node_ptr op = ast_arena::current().token( op_sym, Operator );
         return new ast_bin_op_node( left,  op, right, rule_nr);
     }
 
     class ast_function_node: public ast_node {
         public:
-            jclib::CountedPointer<ast_node> function_;
-            jclib::CountedPointer<ast_node> parameters_;
-            jclib::CountedPointer<ast_node> body_;
+            ast_node_ptr function_;
+            ast_node_ptr parameters_;
+            ast_node_ptr body_;
             virtual void accept( ast_node_visitor * visitor ){
                 visitor->visit_ast_function_node( this ); }
             ast_function_node( node_types type,
                     jclib::jString name,
-                    jclib::CountedPointer<ast_node> function,
-                    jclib::CountedPointer<ast_node> parameters,
-                    jclib::CountedPointer<ast_node> body,
+                    ast_node_ptr function,
+                    ast_node_ptr parameters,
+                    ast_node_ptr body,
                     int rule_nr = -1)
                 : ast_node( type, Empty_String, name, false, rule_nr, false)
                 , function_(function)
@@ -466,10 +592,10 @@ namespace awkccc {
             virtual void clean_tree(ast_node * parent);
     };
 
-    inline jclib::CountedPointer<ast_node> function_node( jclib::jString rulename,
-                    jclib::CountedPointer<ast_node> function,
-                    jclib::CountedPointer<ast_node> parameters,
-                    jclib::CountedPointer<ast_node> body,
+    inline ast_node_ptr function_node( jclib::jString rulename,
+                    ast_node_ptr function,
+                    ast_node_ptr parameters,
+                    ast_node_ptr body,
                     int rule_nr = -1 ) {
         return new ast_function_node( Function, rulename, function, parameters, body, rule_nr);
     }
@@ -477,9 +603,9 @@ namespace awkccc {
 
     class ast_branch_loop_node: public ast_statement_node {
         public:
-            jclib::CountedPointer<ast_node> question_;
-            jclib::CountedPointer<ast_node> if_true_;
-            jclib::CountedPointer<ast_node> if_false_;
+            ast_node_ptr question_;
+            ast_node_ptr if_true_;
+            ast_node_ptr if_false_;
             virtual void accept( ast_node_visitor * visitor ){
                 visitor->visit_ast_branch_loop_node( this );  }
             ast_branch_loop_node( node_types type,
@@ -498,10 +624,10 @@ namespace awkccc {
             };
             ast_branch_loop_node(
                     node_types type,
-                    jclib::CountedPointer<ast_node> op,
-                    jclib::CountedPointer<ast_node> question,
-                    jclib::CountedPointer<ast_node> if_true,
-                    jclib::CountedPointer<ast_node> if_false,
+                    ast_node_ptr op,
+                    ast_node_ptr question,
+                    ast_node_ptr if_true,
+                    ast_node_ptr if_false,
                     int rule_nr = -1)
                 : ast_statement_node( op, type,  jclib::jString("Branch_Loop"), rule_nr )
                 , question_(question)
@@ -514,26 +640,26 @@ namespace awkccc {
             /*** Recursively promote siblings to parent (if allowed) */
             virtual void clean_tree(ast_node * parent);
     };
-    inline jclib::CountedPointer<ast_node> ast_if_statement( ast_node * op, 
+    inline ast_node_ptr ast_if_statement( ast_node * op, 
                                                              ast_node * question, 
                                                              ast_node * if_true, 
                                                              int rule_nr = -1) {
         return new ast_branch_loop_node( If, op, question, if_true, nullptr, rule_nr);
     }
-    inline jclib::CountedPointer<ast_node> ast_if_else_statement( ast_node * op, 
+    inline ast_node_ptr ast_if_else_statement( ast_node * op, 
                                                                   ast_node * question, 
                                                                   ast_node * if_true, 
                                                                   ast_node * if_false,
                                                                   int rule_nr = -1) {
         return new ast_branch_loop_node( If, op, question, if_true, if_false, rule_nr);
     }
-    inline jclib::CountedPointer<ast_node> ast_while_statement( ast_node * op, 
+    inline ast_node_ptr ast_while_statement( ast_node * op, 
                                                              ast_node * question, 
                                                              ast_node * if_true, 
                                                              int rule_nr = -1) {
         return new ast_branch_loop_node( While, op, question, if_true, nullptr, rule_nr);
     }
-    inline jclib::CountedPointer<ast_node> ast_do_statement( ast_node * op, 
+    inline ast_node_ptr ast_do_statement( ast_node * op, 
                                                              ast_node * body, 
                                                              ast_node * question, 
                                                              int rule_nr = -1) {
@@ -542,10 +668,10 @@ namespace awkccc {
 
     class ast_for_loop_node: public ast_statement_node {
         public:
-            jclib::CountedPointer<ast_node> initialise_;
-            jclib::CountedPointer<ast_node> question_;
-            jclib::CountedPointer<ast_node> increment_;
-            jclib::CountedPointer<ast_node> loop_body_;
+            ast_node_ptr initialise_;
+            ast_node_ptr question_;
+            ast_node_ptr increment_;
+            ast_node_ptr loop_body_;
             virtual void accept( ast_node_visitor * visitor ){
                 visitor->visit_ast_for_loop_node( this );   }
             ast_for_loop_node(
@@ -565,11 +691,11 @@ namespace awkccc {
                 extra_children_allowed_ = false;
             }
             ast_for_loop_node(
-                    jclib::CountedPointer<ast_node> op,
-                    jclib::CountedPointer<ast_node> initialise,
-                    jclib::CountedPointer<ast_node> question,
-                    jclib::CountedPointer<ast_node> increment,
-                    jclib::CountedPointer<ast_node> loop_body,
+                    ast_node_ptr op,
+                    ast_node_ptr initialise,
+                    ast_node_ptr question,
+                    ast_node_ptr increment,
+                    ast_node_ptr loop_body,
                     int rule_nr = -1)
                 : ast_statement_node( op, For_C,  jclib::jString("Branch_Loop"), rule_nr )
                 , initialise_(initialise)
@@ -583,7 +709,7 @@ namespace awkccc {
             /*** Recursively promote siblings to parent (if allowed) */
             virtual void clean_tree(ast_node * parent);
     };
-    inline jclib::CountedPointer<ast_node> ast_for_C_statement( ast_node * op, 
+    inline ast_node_ptr ast_for_C_statement( ast_node * op, 
                                                                 ast_node * initialise, 
                                                                 ast_node * question,
                                                                 ast_node * increment, 
@@ -595,9 +721,9 @@ namespace awkccc {
 
     class ast_ternary_op_node: public ast_op_node {
         public:
-            jclib::CountedPointer<ast_node> question_;
-            jclib::CountedPointer<ast_node> if_true_;
-            jclib::CountedPointer<ast_node> if_false_;
+            ast_node_ptr question_;
+            ast_node_ptr if_true_;
+            ast_node_ptr if_false_;
             virtual void accept( ast_node_visitor * visitor ){
                 visitor->visit_ast_ternary_op_node( this );   }
             ast_ternary_op_node( jclib::jString name,
@@ -614,10 +740,10 @@ namespace awkccc {
                 extra_children_allowed_ = false;
             };
             ast_ternary_op_node(
-                    jclib::CountedPointer<ast_node> op,
-                    jclib::CountedPointer<ast_node> question,
-                    jclib::CountedPointer<ast_node> if_true,
-                    jclib::CountedPointer<ast_node> if_false,
+                    ast_node_ptr op,
+                    ast_node_ptr question,
+                    ast_node_ptr if_true,
+                    ast_node_ptr if_false,
                     int rule_nr = -1)
                 : ast_op_node( op, Expression,  jclib::jString("TERNARY_OP "), rule_nr )
                 , question_(question)
@@ -630,15 +756,15 @@ namespace awkccc {
             /*** Recursively promote siblings to parent (if allowed) */
             virtual void clean_tree(ast_node * parent);
     };
-    inline jclib::CountedPointer<ast_node> ast_ternary_op(  ast_node * question, ast_node * op, ast_node * if_true, ast_node * if_false, int rule_nr = -1) {
+    inline ast_node_ptr ast_ternary_op(  ast_node * question, ast_node * op, ast_node * if_true, ast_node * if_false, int rule_nr = -1) {
         return new ast_ternary_op_node( op, question, if_true, if_false, rule_nr);
     }
 
-    inline jclib::CountedPointer<ast_node> ast_ternary_op(
-                jclib::CountedPointer<ast_node> question,
-                jclib::CountedPointer<ast_node> op,
-                jclib::CountedPointer<ast_node> if_true,
-                jclib::CountedPointer<ast_node> if_false,
+    inline ast_node_ptr ast_ternary_op(
+                ast_node_ptr question,
+                ast_node_ptr op,
+                ast_node_ptr if_true,
+                ast_node_ptr if_false,
                 int rule_nr = -1) {
         return new ast_ternary_op_node( op, question, if_true, if_false, rule_nr);
     }
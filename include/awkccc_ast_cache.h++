@@ -0,0 +1,133 @@
+/***
+**
+** AWKCCC: On-disk cache of the parsed AST of @include files
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+
+
+/*
+ * File:   awkccc_ast_cache.h++
+ * Author: Julia Clement <Julia at Clement dot nz>
+ *
+ * Part of the awkccc project https://github.com/juliaclement/awkccc
+ *
+ * Created on 17 October 2026, 15:40
+ */
+#ifndef AWKCCC_AST_CACHE_HPP
+#define AWKCCC_AST_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/jString.hpp"
+#include "../include/awkccc_ast.hpp"
+#include "../src/parser.h++"
+
+/// Cache files written by any other version are parsed again
+#ifndef AWKCCC_VERSION
+#define AWKCCC_VERSION "0.1"
+#endif
+
+namespace awkccc {
+    class Lexer;
+
+    /**
+     * The parsed items of each @include file, kept in a directory between
+     * runs so the large function libraries scripts include over & over
+     * are lexed & parsed once rather than every time they are translated.
+     *
+     * A file's entry is named for a hash of its text & of AWKCCC_VERSION,
+     * so an edited library or a new awkccc simply misses. As the entry
+     * also holds the items of the files it @includes, it lists them with
+     * the keys their texts had & is passed over once any of them changes.
+     * The entry holds the nodes in a compact binary form, each referring
+     * to the nodes & symbols it uses by number, & is loaded straight into
+     * the current ast_arena with its symbols found or made in the symbol
+     * table, as parsing the file would have left them.
+     *
+     * Anything that goes wrong with the cache itself, an unwritable
+     * directory or a damaged entry, just means the file is parsed.
+    */
+    class ast_cache {
+        public:
+            /// Bumped whenever the layout of an entry changes
+            static constexpr uint32_t format_version_ = 2;
+
+            /// A file @included, directly or not, by one being cached, as
+            /// its @include named it, & the key of its text then. 0 if
+            /// there was no such file
+            struct nested_include {
+                jclib::jString name_;
+                uint64_t key_;
+            };
+
+            explicit ast_cache( jclib::jString directory,
+                                PARSER_Parser * (*create_parser)() = &PARSER_Parser::Create )
+                : directory_( directory )
+                , create_parser_( create_parser )
+                {}
+            ast_cache( const ast_cache & ) = delete;
+            ast_cache & operator = ( const ast_cache & ) = delete;
+
+            /**
+             * The item_list of the @include file name, or name.awk, from
+             * the cache or parsed & then cached, for the program including
+             * lexes. The files it includes are lexed once for the whole
+             * program, as they are without the cache. nullptr if it can't
+             * be read or parsed.
+            */
+            ast_node_ptr include( const jclib::jString & name, Lexer & including );
+
+            /// The key of a file's entry: its text & the awkccc that parsed it
+            static uint64_t key( std::string_view text );
+            /// Where the entry for key is kept
+            jclib::jString entry_name( uint64_t key ) const;
+
+            /// The key of the file an @include of name reads now, 0 if none
+            static uint64_t current_key( const jclib::jString & name );
+
+            /// items as an entry for text, which @included nested
+            static std::string save( ast_node * items, uint64_t key, size_t text_size,
+                                     const std::vector<nested_include> & nested = {} );
+            /// The items of an entry made by save(), nullptr if it isn't one
+            /// for this key, is damaged or a file it @included has changed.
+            /// Those files are added to nested
+            static ast_node_ptr load( std::string_view entry, uint64_t key, size_t text_size,
+                                      SymbolTable & symbol_table,
+                                      std::vector<nested_include> * nested = nullptr );
+
+            /// The files an entry made by save() lists as @included, false
+            /// if it isn't one
+            static bool nested_includes( std::string_view entry, std::vector<nested_include> & nested );
+
+            /// Entries loaded & files parsed
+            size_t hits_ = 0;
+            size_t misses_ = 0;
+        private:
+            jclib::jString directory_;
+            PARSER_Parser * (*create_parser_)();
+            /// Files being parsed, to refuse an @include of one of them
+            std::vector<jclib::jString> parsing_;
+            /// Where the files @included by the one being parsed are noted
+            std::vector<nested_include> * nested_ = nullptr;
+
+            ast_node_ptr parse( const jclib::jString & path, const std::string & text,
+                                Lexer & includer );
+    };
+}
+
+#endif
@@ -0,0 +1,83 @@
+/***
+**
+** AWKCCC Runtime concatenation of several values at once
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_CONCATENATE_HPP
+#define AWKCCC_CONCATENATE_HPP 1
+#include <cstring>
+#include <string_view>
+#include "../include/awkccc_variable.h++"
+namespace awkccc {
+/** a b c d: every piece of a concatenation chain, as flatten_concatenations()
+ *  leaves it, rather than a temporary string for each pair.
+ *
+ *  Each piece's text is found once, numbers formatted through CONVFMT into
+ *  the object's own buffers. value() then allocates the result once, at its
+ *  full length, & Awkccc_writer::print copies the pieces straight into its
+ *  buffer without making a string at all.
+ *
+ *  The pieces may point into the object itself, so it can't be copied:
+ *  build it where it is used, as in print( ..., concatenate( a, " ", b ) ).
+ **/
+template< size_t Count >
+class Awkccc_concatenation {
+    public:
+        std::string_view pieces_[Count];
+        size_t size_ = 0;
+
+        template< typename... Pieces >
+        explicit Awkccc_concatenation( const Pieces &... pieces ) {
+            static_assert( sizeof...( Pieces ) == Count, "one text per piece" );
+            size_t i = 0;
+            ( ( pieces_[i] = as_text( pieces, buffers_[i] ), size_ += pieces_[i].size(), ++i ), ... );
+        }
+        Awkccc_concatenation( const Awkccc_concatenation & ) = delete;
+        Awkccc_concatenation & operator = ( const Awkccc_concatenation & ) = delete;
+
+        /** The joined string, allocated once */
+        Awkccc_variable value() const {
+            return Awkccc_variable::filled( size_, [this]( char * out ) {
+                for( auto & piece : pieces_ ) {
+                    std::memcpy( out, piece.data(), piece.size() );
+                    out += piece.size();
+                }
+            } );
+        }
+        /** The joined string as a temporary in arena, as for a key
+         *  looked up & not stored */
+        Awkccc_variable value( Awkccc_arena & arena ) const {
+            return Awkccc_variable::filled( size_, [this]( char * out ) {
+                for( auto & piece : pieces_ ) {
+                    std::memcpy( out, piece.data(), piece.size() );
+                    out += piece.size();
+                }
+            }, arena );
+        }
+        inline operator Awkccc_variable() const {
+            return value();
+        }
+    private:
+        Awkccc_number_format::text buffers_[Count];
+};
+
+/** Awkccc_concatenation of the pieces, deducing how many */
+template< typename... Pieces >
+inline Awkccc_concatenation<sizeof...( Pieces )> concatenate( const Pieces &... pieces ) {
+    return Awkccc_concatenation<sizeof...( Pieces )>( pieces... );
+}
+}
+#endif
@@ -0,0 +1,88 @@
+/***
+**
+** AWKCCC: Translation of constant EREs to re2c matchers
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+
+
+/*
+ * File:   awkccc_ere.h++
+ * Author: Julia Clement <Julia at Clement dot nz>
+ *
+ * Part of the awkccc project https://github.com/juliaclement/awkccc
+ *
+ * Created on 17 October 2026, 16:40
+ */
+#ifndef AWKCCC_ERE_HPP
+#define AWKCCC_ERE_HPP
+
+#include <string>
+#include <string_view>
+
+namespace awkccc {
+    /// A constant ERE rewritten in re2c's regular expression syntax
+    struct Awkccc_re2c_regex {
+        /// The regex for a re2c rule, without any anchors
+        std::string regex_;
+        /// ^ at the start: only match at the start of the text
+        bool anchored_start_ = false;
+        /// $ at the end: only match at the end of the text
+        bool anchored_end_ = false;
+    };
+
+    /// EREs that need no automaton: a string search or compare will do
+    enum Awkccc_ere_shape {
+        Ere_General,    ///< Needs the DFA
+        Ere_Literal,    ///< /ERROR/ : the literal anywhere
+        Ere_Prefix,     ///< /^GET / : the literal at the start
+        Ere_Suffix,     ///< /\.gz$/ : the literal at the end
+        Ere_Exact       ///< /^yes$/ : the literal & nothing else
+    };
+    struct Awkccc_ere_literal {
+        Awkccc_ere_shape shape_ = Ere_General;
+        /// The whole match for the literal shapes. For Ere_General the
+        /// longest text every match must contain, empty if there is none
+        std::string literal_;
+    };
+
+    /**
+     * Find the literal shape of an ERE, or the literal every match of a
+     * general ERE contains so the DFA need only run on text containing it.
+     * Returns false if the ERE has an escape awk doesn't define.
+    */
+    bool ere_literal( std::string_view ere, Awkccc_ere_literal & answer );
+
+    /**
+     * Rewrite the text of an ERE, without its surrounding slashes, for re2c.
+     * Returns false, with why set, for what re2c can't express: anchors
+     * other than a leading ^ & trailing $ outside alternation, & escapes
+     * awk doesn't define. Those EREs are left to the runtime.
+    */
+    bool ere_to_re2c( std::string_view ere, Awkccc_re2c_regex & answer, std::string & why );
+
+    /**
+     * A matcher function for ere as C++ with an embedded re2c block, or
+     * a plain string search when ere_literal() finds a literal shape.
+     * Compiled without running re2c, the block is a comment & the
+     * function asks the runtime's regex_cache() instead.
+     * The function is bool name( std::string_view text ) & is true if
+     * text contains a match. Returns false, with why set, if ere can't
+     * be translated.
+    */
+    bool ere_matcher( std::string_view ere, const std::string & name, std::string & code, std::string & why );
+}
+
+#endif
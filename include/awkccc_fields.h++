@@ -0,0 +1,220 @@
+/***
+**
+** AWKCCC Runtime field splitting
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_FIELDS_HPP
+#define AWKCCC_FIELDS_HPP 1
+#include <cstdint>
+#include <cstring>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/awkccc_number.h++"
+#include "../include/awkccc_split_simd.h++"
+#include "../include/awkccc_regex_cache.h++"
+namespace awkccc {
+/** What the program does with fields, worked out at translate time by
+ *  analyse_field_usage() & emitted into the generated program.
+ *  The defaults are the safe choice for code that wasn't analysed.
+ **/
+struct Awkccc_field_usage {
+    /// Highest constant field number, as in $3
+    int max_field_ = 0;
+    /// NF is referenced, so every record must be split completely
+    bool uses_nf_ = true;
+    /// A field is selected by an expression, as in $i or $(NF-1)
+    bool dynamic_field_ = true;
+};
+
+/** A field's value as a number, worked out once per record */
+struct Awkccc_field_number {
+    double value_ = 0.0;
+    /// A numeric string, so compared as a number
+    bool numeric_ = false;
+    /// Beyond NF: uninitialised, also compared as a number
+    bool missing_ = false;
+    /// The record this was worked out for
+    uint64_t record_ = 0;
+};
+
+/** Splits $0 into fields on demand.
+ *  Nothing is split when a record arrives. A request for $n splits just far
+ *  enough to find field n, continuing from where any earlier request stopped,
+ *  so programs that only look at the first few fields of a wide record never
+ *  scan the rest of it. Asking for NF splits the whole record.
+ *  FS=" " & single character FS use the SIMD kernels in awkccc_split_simd.h++.
+ **/
+class Awkccc_fields {
+    public:
+        Awkccc_fields()
+            : usage_()
+            , mode_( Default_FS )
+            , separator_( ' ' )
+            , pending_FS_( " " )
+            , FS_changed_( false )
+            , kernels_( Awkccc_split_kernels::selected() )
+            , next_start_( 0 )
+            , complete_( true )
+            {}
+        /** Install the translator's view of field use */
+        void set_usage( const Awkccc_field_usage & usage ) {
+            usage_ = usage;
+        }
+        inline const Awkccc_field_usage & usage() const {
+            return usage_;
+        }
+        /** Change FS. As POSIX requires, this applies from the next record */
+        void set_separator( std::string_view FS ) {
+            pending_FS_ = FS;
+            FS_changed_ = true;
+        }
+        /** Start on a new record. Nothing is split until it is asked for */
+        void reset( std::string_view record ) {
+            if( FS_changed_ )
+                apply_separator();
+            record_ = record;
+            ++record_number_;
+            spans_.clear();
+            next_start_ = 0;
+            complete_ = false;
+            if( usage_.uses_nf_ )
+                split_to( SIZE_MAX );
+            else if( ! usage_.dynamic_field_ && usage_.max_field_ > 0 )
+                split_to( usage_.max_field_ );
+        }
+        /** $n for n >= 1, the empty string beyond NF */
+        std::string_view get( size_t n ) {
+            if( n == 0 )
+                return record_;
+            if( n > spans_.size() && ! split_to( n ) )
+                return std::string_view();
+            const Awkccc_field_span & span = spans_[n - 1];
+            return record_.substr( span.start_, span.length_ );
+        }
+        /** $n as a number. However often a field is used, it is only
+         *  scanned & classified once per record */
+        const Awkccc_field_number & number( size_t n ) {
+            if( n >= numbers_.size() )
+                numbers_.resize( n + 1 );
+            Awkccc_field_number & cached = numbers_[n];
+            if( cached.record_ != record_number_ ) {
+                cached.record_ = record_number_;
+                cached.missing_ = n > spans_.size() && ! split_to( n );
+                if( cached.missing_ ) {
+                    cached.value_ = 0.0;
+                    cached.numeric_ = false;
+                } else {
+                    cached.numeric_ = scan_number( get( n ), cached.value_ );
+                }
+            }
+            return cached;
+        }
+        /** NF. Splits the remainder of the record */
+        size_t count() {
+            split_to( SIZE_MAX );
+            return spans_.size();
+        }
+        /** Fields found so far, without splitting any further */
+        inline size_t split_so_far() const {
+            return spans_.size();
+        }
+        /** Override the CPU's choice of kernels, for testing & benchmarks */
+        void set_kernels( Awkccc_split_isa isa ) {
+            kernels_ = Awkccc_split_kernels::for_isa( isa );
+        }
+        inline Awkccc_split_isa kernel_isa() const {
+            return kernels_.isa_;
+        }
+    private:
+        enum split_mode {
+            Default_FS,     // FS=" ": runs of blanks & newlines, trimmed
+            Single_Char_FS, // any other single character
+            Regex_FS        // anything longer is an ERE
+        };
+        Awkccc_field_usage usage_;
+        split_mode mode_;
+        char separator_;
+        std::string pending_FS_;
+        bool FS_changed_;
+        std::regex regex_;
+        Awkccc_split_kernels kernels_;
+        std::string_view record_;
+        std::vector<Awkccc_field_span> spans_;
+        size_t next_start_;
+        bool complete_;
+        /// Counts records, so a cached number from an earlier one is never used
+        uint64_t record_number_ = 0;
+        std::vector<Awkccc_field_number> numbers_;
+
+        void apply_separator() {
+            FS_changed_ = false;
+            if( pending_FS_ == " " ) {
+                mode_ = Default_FS;
+            } else if( pending_FS_.size() == 1 ) {
+                mode_ = Single_Char_FS;
+                separator_ = pending_FS_[0];
+            } else {
+                mode_ = Regex_FS;
+                regex_ = compile_ere( pending_FS_ );
+            }
+        }
+        inline void add_span( size_t start, size_t end ) {
+            spans_.push_back( { uint32_t( start ), uint32_t( end - start ) } );
+        }
+        /** Split until at least n fields are known.
+         *  Returns false if the record has fewer than n fields */
+        bool split_to( size_t n ) {
+            const char * data = record_.data();
+            const size_t size = record_.size();
+            while( ! complete_ && spans_.size() < n ) {
+                switch( mode_ ) {
+                    case Default_FS:
+                        complete_ = kernels_.default_fs_( data, size, next_start_, n, spans_, next_start_ );
+                        break;
+                    case Single_Char_FS:
+                        if( size == 0 )
+                            complete_ = true;
+                        else
+                            complete_ = kernels_.char_fs_( data, size, next_start_, separator_, n,
+                                                           spans_, next_start_ );
+                        break;
+                    case Regex_FS: {
+                        if( size == 0 ) {
+                            complete_ = true;
+                            break;
+                        }
+                        std::cmatch match;
+                        if( next_start_ < size
+                         && search_ere( data + next_start_, data + size, match, regex_ )
+                         && match.length( 0 ) > 0 ) {
+                            size_t found = next_start_ + match.position( 0 );
+                            add_span( next_start_, found );
+                            next_start_ = found + match.length( 0 );
+                        } else {
+                            add_span( next_start_, size );
+                            complete_ = true;
+                        }
+                        break;
+                    }
+                }
+            }
+            return spans_.size() >= n;
+        }
+};
+}
+#endif
@@ -0,0 +1,142 @@
+/***
+**
+** AWKCCC Runtime table of interned input strings
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_INTERN_HPP
+#define AWKCCC_INTERN_HPP 1
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "../include/awkccc_variable.h++"
+namespace awkccc {
+/** One shared copy of each long field value the program keeps, as in
+ *  count[$1]++ or last = $3, so a key seen on a million records is stored
+ *  once rather than a million times. Every value interned from the same
+ *  text shares one heap string, so Awkccc_variable::same_text() tells two
+ *  of them are equal without comparing a byte, & an array finds its own
+ *  key that way before it compares any text.
+ *
+ *  Texts short enough to be held inline in a variable gain nothing & are
+ *  never interned. The table is split into shards, each with its own
+ *  lock, so parallel shards of the input rarely wait for each other. A
+ *  shard that fills up stops interning rather than growing without limit
+ *  on input where no key repeats: values are then made as if there were
+ *  no table.
+ **/
+class Awkccc_intern_table {
+    public:
+        static constexpr size_t shard_count_ = 16;
+        static constexpr size_t default_shard_capacity_ = size_t( 1 ) << 16;
+
+        explicit Awkccc_intern_table( size_t shard_capacity = default_shard_capacity_ )
+            : shard_capacity_( shard_capacity )
+            {}
+        Awkccc_intern_table( const Awkccc_intern_table & ) = delete;
+        Awkccc_intern_table & operator = ( const Awkccc_intern_table & ) = delete;
+
+        /** The shared value for text, as Awkccc_variable::from_input would
+         *  make it from text, number & numeric */
+        Awkccc_variable intern( std::string_view text, double number, bool numeric ) {
+            if( text.size() <= Awkccc_variable::inline_size_ )
+                return Awkccc_variable::from_input( text, number, numeric );
+            uint64_t hash = hash_text( text );
+            shard & in = shards_[hash % shard_count_];
+            std::lock_guard<std::mutex> lock( in.lock_ );
+            if( in.hashes_.empty() )
+                in.grow();
+            size_t mask = in.hashes_.size() - 1;
+            for( size_t slot = ( hash / shard_count_ ) & mask; ; slot = ( slot + 1 ) & mask ) {
+                if( in.hashes_[slot] == 0 ) {
+                    if( in.used_ >= shard_capacity_ )
+                        return Awkccc_variable::from_input( text, number, numeric );
+                    in.hashes_[slot] = hash;
+                    in.values_[slot] = Awkccc_variable::from_input( text, number, numeric );
+                    if( ++in.used_ * 4 > in.hashes_.size() * 3 )
+                        in.grow();
+                    return *in.find( hash, text );
+                }
+                if( in.hashes_[slot] == hash && in.values_[slot].string_value() == text )
+                    return in.values_[slot];
+            }
+        }
+        /** As above, classifying text on the way in */
+        Awkccc_variable intern( std::string_view text ) {
+            double number;
+            bool numeric = scan_number( text, number );
+            return intern( text, number, numeric );
+        }
+        /** How many strings are held */
+        size_t size() {
+            size_t answer = 0;
+            for( auto & each : shards_ ) {
+                std::lock_guard<std::mutex> lock( each.lock_ );
+                answer += each.used_;
+            }
+            return answer;
+        }
+    private:
+        /// Open addressing, 0 marking an empty slot
+        struct shard {
+            std::mutex lock_;
+            std::vector<uint64_t> hashes_;
+            std::vector<Awkccc_variable> values_;
+            size_t used_ = 0;
+
+            Awkccc_variable * find( uint64_t hash, std::string_view text ) {
+                size_t mask = hashes_.size() - 1;
+                for( size_t slot = ( hash / shard_count_ ) & mask; hashes_[slot] != 0; slot = ( slot + 1 ) & mask )
+                    if( hashes_[slot] == hash && values_[slot].string_value() == text )
+                        return &values_[slot];
+                return nullptr;
+            }
+            void grow() {
+                std::vector<uint64_t> old_hashes( hashes_.empty() ? 64 : hashes_.size() * 2, 0 );
+                std::vector<Awkccc_variable> old_values( old_hashes.size() );
+                old_hashes.swap( hashes_ );
+                old_values.swap( values_ );
+                size_t mask = hashes_.size() - 1;
+                for( size_t i = 0; i < old_hashes.size(); ++i ) {
+                    if( old_hashes[i] == 0 )
+                        continue;
+                    size_t slot = ( old_hashes[i] / shard_count_ ) & mask;
+                    while( hashes_[slot] != 0 )
+                        slot = ( slot + 1 ) & mask;
+                    hashes_[slot] = old_hashes[i];
+                    values_[slot] = std::move( old_values[i] );
+                }
+            }
+        };
+        size_t shard_capacity_;
+        shard shards_[shard_count_];
+
+        /// FNV-1a, never 0
+        static uint64_t hash_text( std::string_view text ) {
+            uint64_t hash = 14695981039346656037ull;
+            for( unsigned char c : text )
+                hash = ( hash ^ c ) * 1099511628211ull;
+            return hash ? hash : 1;
+        }
+};
+
+/** The table every runtime interns fields into */
+inline Awkccc_intern_table & intern_table() {
+    static Awkccc_intern_table table;
+    return table;
+}
+}
+#endif
@@ -20,12 +20,53 @@
 #include "../include/jString.hpp"
 #include "../src/parser.h++"
 #include "awkccc_ast.hpp"
+#include <cstdio>
 #include <cstdlib>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <initializer_list>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
 
 namespace awkccc {
 
+  /**
+   * A file or string being lexed & the buffer it is read into a piece at a
+   * time, so a script of any size is lexed in memory bounded by its longest
+   * token. An @include pushes a source of its own on top of the one that
+   * named it; the including source's place is kept here until it resumes.
+  */
+  class Lexer_source {
+    private:
+      Lexer_source(const Lexer_source &) = delete;
+      Lexer_source& operator =(const Lexer_source &) = delete;
+    public:
+      jclib::jString name_;
+      std::FILE * file_ = nullptr;
+      /// What is left of a source given as a string
+      const char * text_ = nullptr;
+      size_t text_left_ = 0;
+      std::vector<char> buffer_;
+      /// Everything has been read & the padding added after it
+      bool eof_ = false;
+      /// Where this source had got to when an @include was pushed on it
+      char * resume_cursor_ = nullptr;
+      char * resume_limit_ = nullptr;
+
+      Lexer_source( jclib::jString name, std::FILE * file, size_t buffer_size )
+      : name_( name ), file_( file ), buffer_( buffer_size )
+      {}
+      Lexer_source( const char * text, size_t buffer_size );
+      /// Up to size more bytes into into, fewer only at the end
+      size_t read( char * into, size_t size );
+      ~Lexer_source() {
+          if( file_ )
+              std::fclose( file_ );
+      }
+  };
+
   class Lexer {
     private:
       Lexer(const Lexer &) = delete;
@@ -34,7 +75,6 @@ namespace awkccc {
       char *buf_;
       char *lim_, *cur_, *mar_, *tok_;
       int line_;
-      class jclib::jString token_;
       class awkccc::SymbolTable * symbol_table_;
       jclib::CountedPointer<class PARSER_Parser> parser_; 
       // Part of determining if a token starting / should be
@@ -48,14 +88,70 @@ namespace awkccc {
       // the awk namespace is magicish, or is it?
       // currently making it prefix with "" looks sensible
       class jclib::jString awk_namespace_prefix_ = jclib::jString::get_empty();
-      static jclib::CountedPointer<awkccc::ast_node> ast_out;
+      static awkccc::ast_node_ptr ast_out;
+      /// The source being lexed is the last, those that @included it before it
+      std::vector< std::unique_ptr<Lexer_source> > sources_;
+      /// Size each source's buffer starts at; it grows only for a longer token
+      size_t buffer_size_ = 64 * 1024;
+      /// \0s put after the end of a source, at least YYMAXFILL so re2c can
+      /// look ahead without checking for the end
+      static constexpr size_t padding_ = 32;
+      /// Each file lexed so far, by device & inode. As in gawk, a file
+      /// is lexed once however often it is @included, so a cycle ends
+      std::vector< std::pair<dev_t, ino_t> > included_;
+      /// @includes of a file lexed already, & so skipped
+      size_t skipped_includes_ = 0;
+      /// The Lexer of the program whose @include file this one lexes for
+      /// the ast_cache. Its included_ covers the whole program
+      Lexer * including_ = nullptr;
+      /// When set, each @include is parsed on its own, or found already
+      /// parsed in the cache, & handed to the parser as one token
+      class ast_cache * ast_cache_ = nullptr;
 
+      /// The token just matched. Valid until the next token is scanned,
+      /// which may refill the buffer
+      std::string_view token_text() const {
+          return std::string_view( tok_, buf_ - tok_ );
+      }
+      /// re2c's YYFILL: at least need more bytes after lim_, false if the
+      /// source has ended
+      bool fill( size_t need );
+      /// Lex text, ahead of what is being lexed now
+      void push_text( const char * text );
+      /// Lex the file name, or name.awk, ahead of what is being lexed now,
+      /// unless it has been already. False if neither can be opened
+      bool include_file( const jclib::jString & name );
+      /// The file name, or name.awk, open for reading, with path set to
+      /// whichever it was. nullptr if neither can be opened
+      static std::FILE * open_include( const jclib::jString & name, jclib::jString & path );
+      /// The Lexer of the whole program, whose included_ is the one kept
+      Lexer & program_lexer() {
+          Lexer * lexer = this;
+          while( lexer->including_ )
+              lexer = lexer->including_;
+          return *lexer;
+      }
+      /// Note file as lexed. False, the @include being skipped, if it was already
+      bool first_inclusion( std::FILE * file );
+      /// Whether the file an @include of name reads has been lexed already
+      bool was_included( const jclib::jString & name );
+      /// Note the file an @include of name reads as lexed
+      void note_included( const jclib::jString & name );
+      /// Lex source, which the Lexer then owns, ahead of what is being lexed now
+      void push_source( Lexer_source * source );
+      /// A \0 has ended the current source. True if it was an @include &
+      /// the source that included it carries on
+      bool end_of_source();
+
+      /// Hand the token for sym to the parser. Its text is found in the
+      /// symbol table as a string_view: no string is made for a name seen before
+      void pass_to_parser( Symbol * sym );
       void parse(int token_code, SymbolType type);
       void include_filename(int token_code, SymbolType type);
       void parse_string(int token_code, SymbolType type);
       void start_namespace(int token_code, SymbolType type);
       void parsequalified(int token_code, SymbolType type); // "@"identifier"::"identifier
-      Symbol * unqualified_to_sym(int token_code, jclib::jString & token); // identifier
+      Symbol * unqualified_to_sym(int token_code, std::string_view token); // identifier
       void parseunqualified(int token_code, SymbolType type); // identifier
       void parsechr(char char_code);
       void maybe_parse_regex(int token_code);
@@ -75,7 +171,8 @@ namespace awkccc {
             // , token_("")
             // , allow_regex_
       {
-
+          if( buf_ )
+              push_text( buf_ );
       }
   };
 };
\ No newline at end of file
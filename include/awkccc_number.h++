@@ -0,0 +1,277 @@
+/***
+**
+** AWKCCC Runtime conversions between strings & numbers
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_NUMBER_HPP
+#define AWKCCC_NUMBER_HPP 1
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+namespace awkccc {
+/** Eight ASCII digits to their value, without a loop.
+ *  The first digit is the lowest byte, as loaded on a little-endian CPU */
+inline uint32_t eight_digits( uint64_t chunk ) {
+    chunk = ( chunk & 0x0F0F0F0F0F0F0F0F ) * 2561 >> 8;
+    chunk = ( chunk & 0x00FF00FF00FF00FF ) * 6553601 >> 16;
+    return uint32_t( ( chunk & 0x0000FFFF0000FFFF ) * 42949672960001 >> 32 );
+}
+/** Are all eight bytes ASCII digits */
+inline bool all_digits( uint64_t chunk ) {
+    return ( chunk & 0xF0F0F0F0F0F0F0F0 ) == 0x3030303030303030
+        && ( ( chunk + 0x0606060606060606 ) & 0xF0F0F0F0F0F0F0F0 ) == 0x3030303030303030;
+}
+inline bool is_number_blank( char c ) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+/** awk's string to number conversion.
+ *  value is the number at the start of text, after any blanks, or 0 if
+ *  there is none. Returns true if text is a numeric string as POSIX
+ *  defines it: nothing but blanks around the number.
+ *
+ *  Integers of up to 19 digits fit in 64 bits, so are converted here,
+ *  eight digits at a time while there are eight, & rounded to double
+ *  once. Anything with a fraction, an exponent or more digits goes to
+ *  std::from_chars.
+ **/
+inline bool scan_number( std::string_view text, double & value ) {
+    const char * p = text.data();
+    const char * const end = p + text.size();
+    while( p < end && is_number_blank( *p ) )
+        ++p;
+    bool negative = false;
+    if( p < end && ( *p == '+' || *p == '-' ) )
+        negative = *p++ == '-';
+    const char * const digits = p;
+    uint64_t integer = 0;
+    if( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ) {
+        for( int chunks = 0; chunks < 2 && end - p >= 8; ++chunks ) {
+            uint64_t chunk;
+            std::memcpy( &chunk, p, 8 );
+            if( ! all_digits( chunk ) )
+                break;
+            integer = integer * 100000000 + eight_digits( chunk );
+            p += 8;
+        }
+    }
+    while( p < end && unsigned( *p - '0' ) < 10 && p - digits < 19 ) {
+        integer = integer * 10 + unsigned( *p - '0' );
+        ++p;
+    }
+    if( p < end && ( *p == '.' || *p == 'e' || *p == 'E' || unsigned( *p - '0' ) < 10 ) ) {
+        double parsed = 0.0;
+        auto result = std::from_chars( digits, end, parsed );
+        if( result.ec == std::errc::invalid_argument ) {
+            value = 0.0;
+            return false;
+        }
+        // Out of range leaves parsed alone: strtod gives infinity or 0 as awk does
+        if( result.ec == std::errc::result_out_of_range )
+            parsed = std::strtod( std::string( digits, result.ptr ).c_str(), nullptr );
+        p = result.ptr;
+        value = negative ? -parsed : parsed;
+    } else {
+        if( p == digits ) {
+            value = 0.0;
+            return false;
+        }
+        value = negative ? -double( integer ) : double( integer );
+    }
+    while( p < end && is_number_blank( *p ) )
+        ++p;
+    return p == end;
+}
+
+/** A CONVFMT or OFMT string, parsed once into what std::to_chars needs.
+ *  Integral values ignore the format & are written as integers, as awk
+ *  does. %.Ng, %.Nf & %.Ne, the formats people use, go to std::to_chars,
+ *  which writes the same text as printf without its parsing & locale
+ *  work. Anything else with one conversion, flags or a width is left to
+ *  snprintf, given a long long for an integer conversion & an int for
+ *  %c. A spec without exactly one numeric conversion, such as "%s" or
+ *  "abc", is taken to be "%.6g" rather than passed a double it can't take.
+ **/
+class Awkccc_number_format {
+    public:
+        /// Room for any number in a sensible format
+        static constexpr size_t text_size_ = 400;
+        using text = char[text_size_];
+
+        Awkccc_number_format( std::string_view spec = "%.6g" ) {
+            set( spec );
+        }
+        Awkccc_number_format( const char * spec )
+            : Awkccc_number_format( std::string_view( spec ) )
+            {}
+        void set( std::string_view spec ) {
+            spec_ = spec;
+            kind_ = General;
+            precision_ = 6;
+            printf_spec_.clear();
+            // Find the one conversion: %, flags, width, precision, letter
+            size_t start = 0, letter = 0;
+            bool plain = true;
+            int precision = -1;
+            for( size_t pos = 0; pos < spec.size(); ++pos ) {
+                if( spec[pos] != '%' )
+                    continue;
+                if( pos + 1 < spec.size() && spec[pos + 1] == '%' ) {
+                    ++pos;
+                    continue;
+                }
+                if( letter != 0 )
+                    return;
+                start = pos++;
+                for( ; pos < spec.size() && is_one_of( spec[pos], "-+ #0" ); ++pos )
+                    plain = false;
+                for( ; pos < spec.size() && is_digit( spec[pos] ); ++pos )
+                    plain = false;
+                if( pos < spec.size() && spec[pos] == '.' ) {
+                    precision = 0;
+                    for( ++pos; pos < spec.size() && is_digit( spec[pos] ); ++pos )
+                        precision = precision * 10 + ( spec[pos] - '0' );
+                    if( precision >= 100 )
+                        return;
+                }
+                if( pos == spec.size() || ! is_one_of( spec[pos], "diouxXceEfFgGaA" ) )
+                    return;
+                letter = pos;
+            }
+            if( letter == 0 )
+                return;
+            const char conversion = spec[letter];
+            if( plain && start == 0 && letter + 1 == spec.size() ) {
+                if( precision >= 0 )
+                    precision_ = precision;
+                switch( conversion ) {
+                    case 'g': kind_ = General; return;
+                    case 'f': kind_ = Fixed; return;
+                    case 'e': kind_ = Scientific; return;
+                    case 'd':
+                    case 'i':
+                        if( precision < 0 ) {
+                            kind_ = Integer;
+                            return;
+                        }
+                }
+            }
+            kind_ = conversion == 'c' ? Printf_Char
+                  : is_one_of( conversion, "diouxX" ) ? Printf_Integer : Printf;
+            printf_spec_ = spec;
+            if( kind_ == Printf_Integer )
+                printf_spec_.insert( letter, "ll" );
+        }
+        /** Parse spec only if it differs from the one in use */
+        inline void update( std::string_view spec ) {
+            if( spec != spec_ )
+                set( spec );
+        }
+        inline const std::string & spec() const {
+            return spec_;
+        }
+        /** Write value to out. Returns its length, which is more than
+         *  capacity if it didn't fit & was cut short */
+        size_t format( double value, char * out, size_t capacity ) const {
+            if( value == std::trunc( value ) && std::fabs( value ) < ( kind_ == Integer ? 9e18 : 1e16 ) ) {
+                auto result = std::to_chars( out, out + capacity, (long long) value );
+                if( result.ec == std::errc() )
+                    return result.ptr - out;
+            } else if( kind_ == General || kind_ == Fixed || kind_ == Scientific ) {
+                auto result = std::to_chars( out, out + capacity, value,
+                                             kind_ == General ? std::chars_format::general
+                                             : kind_ == Fixed ? std::chars_format::fixed
+                                             : std::chars_format::scientific,
+                                             precision_ );
+                if( result.ec == std::errc() )
+                    return result.ptr - out;
+            }
+            return snprintf_format( value, out, capacity );
+        }
+        inline std::string_view format( double value, text & buf ) const {
+            size_t length = format( value, buf, text_size_ );
+            return std::string_view( buf, length < text_size_ ? length : text_size_ - 1 );
+        }
+    private:
+        enum kind {
+            General,
+            Fixed,
+            Scientific,
+            Integer,
+            /// printf_spec_ takes a double, a long long or an int
+            Printf,
+            Printf_Integer,
+            Printf_Char
+        };
+        std::string spec_;
+        /// spec_ as snprintf is given it, with ll added for a long long
+        std::string printf_spec_;
+        kind kind_;
+        int precision_;
+
+        static inline bool is_digit( char c ) {
+            return unsigned( c - '0' ) < 10;
+        }
+        static inline bool is_one_of( char c, const char * set ) {
+            return c != '\0' && std::strchr( set, c ) != nullptr;
+        }
+        /** value truncated to a long long, saturating beyond its range */
+        static long long whole( double value ) {
+            if( std::isnan( value ) )
+                return 0;
+            if( value >= 9.2e18 )
+                return INT64_MAX;
+            if( value <= -9.2e18 )
+                return INT64_MIN;
+            return (long long) value;
+        }
+        size_t snprintf_format( double value, char * out, size_t capacity ) const {
+            int length;
+            switch( kind_ ) {
+                case Integer:
+                    length = std::snprintf( out, capacity, "%.0f", std::trunc( value ) );
+                    break;
+                case Printf:
+                    length = std::snprintf( out, capacity, printf_spec_.c_str(), value );
+                    break;
+                case Printf_Integer:
+                    length = std::snprintf( out, capacity, printf_spec_.c_str(), whole( value ) );
+                    break;
+                case Printf_Char:
+                    length = std::snprintf( out, capacity, printf_spec_.c_str(), int( whole( value ) & 0xFF ) );
+                    break;
+                default:
+                    length = std::snprintf( out, capacity, "%.*g", precision_, value );
+                    break;
+            }
+            return length < 0 ? 0 : size_t( length );
+        }
+};
+
+/** CONVFMT, used by every number to string conversion. The runtime
+ *  updates it when the program changes CONVFMT. Each thread has its own,
+ *  so a parallel shard follows its own runtime's CONVFMT */
+inline Awkccc_number_format & conversion_format() {
+    thread_local Awkccc_number_format format;
+    return format;
+}
+}
+#endif
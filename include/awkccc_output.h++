@@ -0,0 +1,237 @@
+/***
+**
+** AWKCCC Runtime buffered output for print & printf
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_OUTPUT_HPP
+#define AWKCCC_OUTPUT_HPP 1
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "../include/awkccc_variable.h++"
+#include "../include/awkccc_concatenate.h++"
+namespace awkccc {
+/** Buffered writer behind print & printf.
+ *  Text, OFS & ORS are copied straight into one reusable buffer & numbers
+ *  are formatted in place through a prepared OFMT, so a print costs no
+ *  virtual stream calls & no locale work. The buffer goes to the file descriptor with write(), or
+ *  writev() alongside a string too big to be worth copying, only when it
+ *  fills or flush() is called.
+ *
+ *  A writer made with memory_ as its descriptor never writes: its buffer
+ *  grows to hold everything, for a parallel chunk's output. An unbuffered
+ *  writer writes each print & printf out as soon as it is complete.
+ **/
+class Awkccc_writer {
+    public:
+        static constexpr size_t default_buffer_size_ = 64 * 1024;
+        static constexpr int memory_ = -1;
+        explicit Awkccc_writer( int fd = STDOUT_FILENO, size_t buffer_size = default_buffer_size_,
+                                bool unbuffered = false )
+            : buffer_( new char[buffer_size] )
+            , capacity_( buffer_size )
+            , used_( 0 )
+            , fd_( fd )
+            , failed_( false )
+            , unbuffered_( unbuffered )
+            {}
+        Awkccc_writer( const Awkccc_writer & ) = delete;
+        Awkccc_writer & operator = ( const Awkccc_writer & ) = delete;
+        ~Awkccc_writer() {
+            flush();
+        }
+
+        inline void write( std::string_view text ) {
+            if( text.size() <= capacity_ - used_ ) {
+                std::memcpy( buffer_.get() + used_, text.data(), text.size() );
+                used_ += text.size();
+            } else {
+                write_long( text );
+            }
+        }
+        inline void put( char c ) {
+            if( used_ == capacity_ )
+                make_room( 1 );
+            buffer_[used_++] = c;
+        }
+        /** A number as print writes it: integral values as integers,
+         *  anything else through OFMT */
+        void write_number( double value, const Awkccc_number_format & OFMT ) {
+            make_room( 32 );
+            size_t length = OFMT.format( value, buffer_.get() + used_, capacity_ - used_ );
+            if( length >= capacity_ - used_ ) {
+                make_room( length + 1 );
+                length = OFMT.format( value, buffer_.get() + used_, capacity_ - used_ );
+            }
+            used_ += length;
+        }
+        /** printf style formatting straight into the buffer.
+         *  The arguments must already be C types: double, long long, const char *... */
+        template< typename... Args >
+        void format( const char * format_string, Args... args ) {
+            make_room( 64 );
+            int length = std::snprintf( buffer_.get() + used_, capacity_ - used_, format_string, args... );
+            if( length < 0 )
+                return;
+            if( size_t( length ) >= capacity_ - used_ ) {
+                make_room( size_t( length ) + 1 );
+                std::snprintf( buffer_.get() + used_, capacity_ - used_, format_string, args... );
+            }
+            used_ += length;
+            if( unbuffered_ )
+                flush();
+        }
+        /** print item, item, ...: the items separated by OFS & followed by ORS */
+        template< typename Item, typename... Items >
+        void print( [[maybe_unused]] std::string_view OFS, std::string_view ORS,
+                    const Awkccc_number_format & OFMT, const Item & item, const Items &... items ) {
+            write_item( item, OFMT );
+            ( ( write( OFS ), write_item( items, OFMT ) ), ... );
+            write( ORS );
+            if( unbuffered_ )
+                flush();
+        }
+
+        inline void write_item( std::string_view text, const Awkccc_number_format & ) {
+            write( text );
+        }
+        inline void write_item( const char * text, const Awkccc_number_format & ) {
+            write( std::string_view( text ) );
+        }
+        inline void write_item( const jclib::jString & text, const Awkccc_number_format & ) {
+            write( std::string_view( (const char *) text, text.len() ) );
+        }
+        inline void write_item( double value, const Awkccc_number_format & OFMT ) {
+            write_number( value, OFMT );
+        }
+        inline void write_item( const Awkccc_variable & value, const Awkccc_number_format & OFMT ) {
+            if( value.string_is_valid() )
+                write( value.string_value() );
+            else
+                write_number( value.number_, OFMT );
+        }
+        /** a b c as a print item: the pieces go straight into the buffer.
+         *  Numbers in it were converted by CONVFMT, not OFMT, as awk requires */
+        template< size_t Count >
+        inline void write_item( const Awkccc_concatenation<Count> & pieces, const Awkccc_number_format & ) {
+            for( auto & piece : pieces.pieces_ )
+                write( piece );
+        }
+
+        /** Write out what has been buffered. False once any write has failed */
+        bool flush() {
+            if( fd_ != memory_ && used_ > 0 ) {
+                iovec part = { buffer_.get(), used_ };
+                write_all( &part, 1 );
+                used_ = 0;
+            }
+            return ! failed_;
+        }
+        inline int fd() const {
+            return fd_;
+        }
+        /** Flush, then send later output to another descriptor.
+         *  Lets a stream keep its buffer while its file is closed & reopened */
+        void attach( int fd ) {
+            flush();
+            fd_ = fd;
+        }
+        /** Everything written so far to an in-memory writer */
+        inline std::string_view text() const {
+            return std::string_view( buffer_.get(), used_ );
+        }
+        inline void clear() {
+            used_ = 0;
+        }
+    private:
+        std::unique_ptr<char[]> buffer_;
+        size_t capacity_;
+        size_t used_;
+        int fd_;
+        bool failed_;
+        bool unbuffered_;
+
+        /** Ensure at least size bytes are free, flushing or growing the buffer */
+        void make_room( size_t size ) {
+            if( size <= capacity_ - used_ )
+                return;
+            if( fd_ != memory_ ) {
+                flush();
+                if( size <= capacity_ )
+                    return;
+            }
+            size_t capacity = capacity_ * 2;
+            while( capacity - used_ < size )
+                capacity *= 2;
+            std::unique_ptr<char[]> bigger( new char[capacity] );
+            std::memcpy( bigger.get(), buffer_.get(), used_ );
+            buffer_ = std::move( bigger );
+            capacity_ = capacity;
+        }
+        /** Text that doesn't fit. Big text goes out beside the buffer in one writev() */
+        void write_long( std::string_view text ) {
+            if( fd_ == memory_ || text.size() < capacity_ / 2 ) {
+                make_room( text.size() );
+                std::memcpy( buffer_.get() + used_, text.data(), text.size() );
+                used_ += text.size();
+                return;
+            }
+            iovec parts[2] = { { buffer_.get(), used_ },
+                               { const_cast<char *>( text.data() ), text.size() } };
+            write_all( parts, 2 );
+            used_ = 0;
+        }
+        void write_all( iovec * parts, int count ) {
+            while( count > 0 ) {
+                ssize_t written = ::writev( fd_, parts, count );
+                if( written < 0 ) {
+                    if( errno == EINTR )
+                        continue;
+                    failed_ = true;
+                    return;
+                }
+                while( count > 0 && size_t( written ) >= parts->iov_len ) {
+                    written -= parts->iov_len;
+                    ++parts;
+                    --count;
+                }
+                if( count > 0 ) {
+                    parts->iov_base = static_cast<char *>( parts->iov_base ) + written;
+                    parts->iov_len -= written;
+                }
+            }
+        }
+};
+
+/** The writer for standard output, shared by every copy of the runtime */
+inline Awkccc_writer & standard_output() {
+    static Awkccc_writer writer( STDOUT_FILENO );
+    return writer;
+}
+
+/** The writer for standard error, unbuffered as stderr is */
+inline Awkccc_writer & standard_error() {
+    static Awkccc_writer writer( STDERR_FILENO, 4 * 1024, true );
+    return writer;
+}
+}
+#endif
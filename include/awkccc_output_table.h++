@@ -0,0 +1,246 @@
+/***
+**
+** AWKCCC Runtime table of redirected output streams
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_OUTPUT_TABLE_HPP
+#define AWKCCC_OUTPUT_TABLE_HPP 1
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../include/awkccc_output.h++"
+namespace awkccc {
+/** The output_redirection forms: print > name, print >> name & print | command */
+enum Awkccc_redirection {
+    Redirect_Truncate,
+    Redirect_Append,
+    Redirect_Pipe
+};
+
+/** The destinations of redirected print & printf, keyed by the string
+ *  the program wrote after >, >> or |.
+ *  Each destination has its own buffered writer. Lookups are a hash probe,
+ *  short-circuited when a program keeps writing to the same destination.
+ *  When the process runs out of file descriptors the least recently used
+ *  file is closed, keeping its buffer & its place in the table, & is
+ *  reopened for appending when next written to. Pipes can't be reopened so
+ *  are never evicted.
+ **/
+class Awkccc_output_table {
+    public:
+        static constexpr size_t stream_buffer_size_ = 8 * 1024;
+        /// Descriptors left for input files, pipes & the program's own use
+        static constexpr size_t reserved_fds_ = 16;
+
+        /** max_open limits how many files are open at once, 0 takes it from RLIMIT_NOFILE */
+        explicit Awkccc_output_table( size_t max_open = 0 )
+            : max_open_( max_open ? max_open : limit_from_rlimit() )
+            {}
+        Awkccc_output_table( const Awkccc_output_table & ) = delete;
+        Awkccc_output_table & operator = ( const Awkccc_output_table & ) = delete;
+        ~Awkccc_output_table() {
+            close_all();
+        }
+
+        /** The writer for a destination, opening it on first use.
+         *  Returns nullptr if it can't be opened */
+        Awkccc_writer * get( std::string_view name, Awkccc_redirection how ) {
+            if( last_ != nullptr && last_->name_ == name && last_->is_open() )
+                return last_->writer_.get();
+            stream * found;
+            auto existing = streams_.find( name );
+            if( existing != streams_.end() ) {
+                found = existing->second.get();
+            } else {
+                auto added = std::make_unique<stream>( name, how );
+                found = added.get();
+                streams_.emplace( std::string_view( found->name_ ), std::move( added ) );
+            }
+            if( ! found->is_open() && ! open( *found ) ) {
+                if( ! found->opened_before_ )
+                    streams_.erase( std::string_view( found->name_ ) );
+                return nullptr;
+            }
+            touch( *found );
+            last_ = found;
+            return found->writer_.get();
+        }
+        /** close( name ). Returns 0, a pipe's exit status, or -1 if nothing by that name is open */
+        int close( std::string_view name ) {
+            auto found = streams_.find( name );
+            if( found == streams_.end() )
+                return -1;
+            int status = shut( *found->second );
+            if( last_ == found->second.get() )
+                last_ = nullptr;
+            streams_.erase( found );
+            return status;
+        }
+        /** fflush() with no argument: write out every stream's buffer */
+        bool flush_all() {
+            bool ok = true;
+            for( auto & entry : streams_ )
+                if( entry.second->is_open() )
+                    ok = entry.second->writer_->flush() && ok;
+            return ok;
+        }
+        void close_all() {
+            for( auto & entry : streams_ )
+                shut( *entry.second );
+            streams_.clear();
+            lru_.clear();
+            last_ = nullptr;
+        }
+        /** How many files & pipes are open now */
+        inline size_t open_count() const {
+            return open_files_ + open_pipes_;
+        }
+    private:
+        struct stream {
+            std::string name_;
+            Awkccc_redirection how_;
+            std::unique_ptr<Awkccc_writer> writer_;
+            FILE * pipe_ = nullptr;
+            int fd_ = -1;
+            /// Once open, later opens append rather than truncate
+            bool opened_before_ = false;
+            /// Place in lru_, for open files only
+            std::list<stream *>::iterator lru_;
+            stream( std::string_view name, Awkccc_redirection how )
+                : name_( name )
+                , how_( how )
+                {}
+            inline bool is_open() const {
+                return fd_ >= 0;
+            }
+        };
+        std::unordered_map<std::string_view, std::unique_ptr<stream> > streams_;
+        /// Open files, most recently used first
+        std::list<stream *> lru_;
+        stream * last_ = nullptr;
+        size_t max_open_;
+        size_t open_files_ = 0;
+        size_t open_pipes_ = 0;
+
+        static size_t limit_from_rlimit() {
+            rlimit limit;
+            if( getrlimit( RLIMIT_NOFILE, &limit ) != 0 || limit.rlim_cur == RLIM_INFINITY )
+                return 1024 - reserved_fds_;
+            return limit.rlim_cur > 2 * reserved_fds_ ? size_t( limit.rlim_cur ) - reserved_fds_ : reserved_fds_;
+        }
+        bool open( stream & target ) {
+            if( target.how_ == Redirect_Pipe ) {
+                // The command comes after everything printed so far, as
+                // Awkccc_runtime::flush_output() arranges before system()
+                std::fflush( nullptr );
+                standard_output().flush();
+                flush_all();
+                target.pipe_ = popen( target.name_.c_str(), "w" );
+                if( target.pipe_ == nullptr )
+                    return false;
+                target.fd_ = fileno( target.pipe_ );
+                ++open_pipes_;
+            } else {
+                while( open_files_ >= max_open_ && evict() )
+                    ;
+                const int flags = O_WRONLY | O_CREAT | O_CLOEXEC
+                                | ( target.how_ == Redirect_Append || target.opened_before_ ? O_APPEND : O_TRUNC );
+                int fd;
+                while( ( fd = ::open( target.name_.c_str(), flags, 0666 ) ) < 0 ) {
+                    if( ( errno != EMFILE && errno != ENFILE ) || ! evict() )
+                        return false;
+                }
+                target.fd_ = fd;
+                target.lru_ = lru_.insert( lru_.begin(), &target );
+                ++open_files_;
+            }
+            if( target.writer_ )
+                target.writer_->attach( target.fd_ );
+            else
+                target.writer_ = std::make_unique<Awkccc_writer>( target.fd_, stream_buffer_size_ );
+            target.opened_before_ = true;
+            return true;
+        }
+        /** Close the least recently used file. False if there is none */
+        bool evict() {
+            if( lru_.empty() )
+                return false;
+            stream & victim = *lru_.back();
+            // Nothing is written to an evicted stream before open() reattaches it
+            victim.writer_->attach( Awkccc_writer::memory_ );
+            ::close( victim.fd_ );
+            victim.fd_ = -1;
+            lru_.pop_back();
+            --open_files_;
+            if( last_ == &victim )
+                last_ = nullptr;
+            return true;
+        }
+        inline void touch( stream & target ) {
+            if( target.how_ != Redirect_Pipe && target.lru_ != lru_.begin() )
+                lru_.splice( lru_.begin(), lru_, target.lru_ );
+        }
+        int shut( stream & target ) {
+            if( ! target.is_open() )
+                return 0;
+            target.writer_->flush();
+            int status = 0;
+            if( target.pipe_ != nullptr ) {
+                status = pclose( target.pipe_ );
+                if( status != -1 && WIFEXITED( status ) )
+                    status = WEXITSTATUS( status );
+                target.pipe_ = nullptr;
+                --open_pipes_;
+            } else {
+                status = ::close( target.fd_ );
+                lru_.erase( target.lru_ );
+                --open_files_;
+            }
+            target.writer_->attach( Awkccc_writer::memory_ );
+            target.fd_ = -1;
+            return status;
+        }
+};
+
+/** The redirected output streams, shared by every copy of the runtime */
+inline Awkccc_output_table & output_table() {
+    static Awkccc_output_table table;
+    return table;
+}
+
+/** An error the program can't carry on from, such as a dynamic regular
+ *  expression that isn't valid. As in gawk, what was printed so far is
+ *  written, the message goes to standard error & the exit status is 2 */
+[[noreturn]] inline void fatal_error( std::string_view message ) {
+    standard_output().flush();
+    output_table().flush_all();
+    standard_error().write( "awkccc: fatal: " );
+    standard_error().write( message );
+    standard_error().put( '\n' );
+    standard_error().flush();
+    std::exit( 2 );
+}
+}
+#endif
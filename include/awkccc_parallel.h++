@@ -0,0 +1,402 @@
+/***
+**
+** AWKCCC Runtime parallel execution of reduction-style programs
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_PARALLEL_HPP
+#define AWKCCC_PARALLEL_HPP 1
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../include/awkccc_reduction.h++"
+#include "../include/awkccc_runtime.h++"
+namespace awkccc {
+/** A byte range of the input holding whole records */
+struct Awkccc_shard {
+    size_t begin_;
+    size_t end_;
+};
+
+/** Cut input into up to count shards of about equal size.
+ *  Each cut is moved forward to just after a record separator so that
+ *  no record straddles two shards. Empty shards are dropped.
+ **/
+inline std::vector<Awkccc_shard> plan_shards( std::string_view input, char separator, unsigned count ) {
+    std::vector<Awkccc_shard> shards;
+    const size_t size = input.size();
+    size_t begin = 0;
+    for( unsigned i = 1; i <= count && begin < size; ++i ) {
+        size_t end = i == count ? size : size / count * i;
+        if( end < begin )
+            end = begin;
+        if( end < size && ( end == 0 || input[end - 1] != separator ) ) {
+            auto found = static_cast<const char *>(
+                    std::memchr( input.data() + end, separator, size - end ) );
+            end = found ? found - input.data() + 1 : size;
+        }
+        if( end > begin )
+            shards.push_back( { begin, end } );
+        begin = end;
+    }
+    return shards;
+}
+
+/** A variable --parallel reduces to its value from the last record to
+ *  assign it. assigned_ says whether this copy has been assigned since
+ *  start_reduction(), which its value can't: a shard may well assign an
+ *  uninitialised value, as last = $9 beyond NF does. Its assignment
+ *  operators set it */
+class Awkccc_last_variable : public Awkccc_variable {
+    public:
+        bool assigned_ = false;
+
+        using Awkccc_variable::Awkccc_variable;
+        Awkccc_last_variable() = default;
+        Awkccc_last_variable( const Awkccc_last_variable & ) = default;
+        Awkccc_last_variable & operator = ( const Awkccc_last_variable & value ) {
+            return *this = static_cast<const Awkccc_variable &>( value );
+        }
+        template< typename Value >
+        Awkccc_last_variable & operator = ( Value && value ) {
+            Awkccc_variable::operator = ( std::forward<Value>( value ) );
+            assigned_ = true;
+            return *this;
+        }
+};
+
+/** Prepare a shard's copy of a reduced variable.
+ *  Sums start uninitialised so that merging can tell whether the shard
+ *  touched them: a count no record incremented is still "" afterwards,
+ *  as it is when run sequentially. Max & min keep the value the shard
+ *  inherited, which never changes the result. A last value held in an
+ *  array element is known to be assigned by being there */
+inline void start_reduction( Awkccc_variable & value, Awkccc_reduction reduction ) {
+    if( reduction == Reduce_Sum )
+        value = Awkccc_variable();
+}
+inline void start_reduction( Awkccc_last_variable & value, Awkccc_reduction ) {
+    value.assigned_ = false;
+}
+/** A shard's copy of a reduced array starts empty */
+template< typename Key >
+inline void start_reduction( std::map<Key, Awkccc_variable> & array, Awkccc_reduction ) {
+    array.clear();
+}
+
+inline void start_reduction( Awkccc_array & array, Awkccc_reduction ) {
+    array.clear();
+}
+
+/** Fold a shard's value into the running total. Shards are merged in input order */
+inline void reduce( Awkccc_variable & total, const Awkccc_variable & shard, Awkccc_reduction reduction ) {
+    switch( reduction ) {
+        case Reduce_Sum:
+            if( shard.data_type() != Uninitialised )
+                total = Awkccc_variable( double( total ) + double( shard ) );
+            break;
+        case Reduce_Max:
+            if( shard.compare( total ) > 0 )
+                total = shard;
+            break;
+        case Reduce_Min:
+            if( shard.compare( total ) < 0 )
+                total = shard;
+            break;
+        case Reduce_Last:
+            total = shard;
+            break;
+    }
+}
+/** The last value is the one from the last shard that assigned it */
+inline void reduce( Awkccc_last_variable & total, const Awkccc_last_variable & shard, Awkccc_reduction ) {
+    if( shard.assigned_ )
+        total = shard;
+}
+/** Fold a shard's array into the running total, element by element */
+template< typename Key >
+inline void reduce( std::map<Key, Awkccc_variable> & total,
+                    const std::map<Key, Awkccc_variable> & shard,
+                    Awkccc_reduction reduction ) {
+    for( auto & element : shard ) {
+        auto found = total.find( element.first );
+        if( found == total.end() )
+            total.emplace( element.first, element.second );
+        else
+            reduce( found->second, element.second, reduction );
+    }
+}
+
+inline void reduce( Awkccc_array & total, const Awkccc_array & shard, Awkccc_reduction reduction ) {
+    shard.for_each( [&]( std::string_view key, const Awkccc_variable & value ) {
+        if( total.contains( key ) )
+            reduce( total[key], value, reduction );
+        else
+            total[key] = value;
+    } );
+}
+
+/** A shard's copy of a variable the generator declared int64_t or double.
+ *  Only sums, maxima & minima are native: each starts from a value that
+ *  can't change the merged result. A last value must tell whether the
+ *  shard assigned it, so those are Awkccc_last_variable */
+template< typename Number, typename = std::enable_if_t< std::is_arithmetic_v<Number> > >
+inline void start_reduction( Number & value, Awkccc_reduction reduction ) {
+    if( reduction == Reduce_Sum )
+        value = 0;
+}
+
+template< typename Number, typename = std::enable_if_t< std::is_arithmetic_v<Number> > >
+inline void reduce( Number & total, const Number & shard, Awkccc_reduction reduction ) {
+    switch( reduction ) {
+        case Reduce_Sum:
+            total += shard;
+            break;
+        case Reduce_Max:
+            if( shard > total )
+                total = shard;
+            break;
+        case Reduce_Min:
+            if( shard < total )
+                total = shard;
+            break;
+        case Reduce_Last:
+            break;
+    }
+}
+
+/** Remove --parallel or --parallel=N from the command line.
+ *  Returns the number of threads asked for, 1 if the option is absent.
+ *  --parallel alone or N=0 means one thread per core. */
+inline unsigned parse_parallel_option( int & argc, char ** argv ) {
+    unsigned threads = 1;
+    int kept = 1;
+    bool options_ended = false;
+    for( int i = 1; i < argc; ++i ) {
+        const char * arg = argv[i];
+        if( ! options_ended && std::strcmp( arg, "--" ) == 0 ) {
+            options_ended = true;
+        } else if( ! options_ended && std::strncmp( arg, "--parallel", 10 ) == 0
+                && ( arg[10] == '\0' || arg[10] == '=' ) ) {
+            threads = arg[10] == '=' ? unsigned( std::strtoul( arg + 11, nullptr, 10 ) ) : 0;
+            if( threads == 0 )
+                threads = std::thread::hardware_concurrency();
+            if( threads == 0 )
+                threads = 1;
+            continue;
+        }
+        argv[kept++] = argv[i];
+    }
+    argc = kept;
+    argv[argc] = nullptr;
+    return threads;
+}
+
+/** Runs the main rules over an input file on several threads.
+ *  Only used for programs analyse_parallel() passed: each record is
+ *  processed independently & every variable the main rules update has a
+ *  reduction. The file is cut into shards at record boundaries. Each shard
+ *  runs on a copy of the program taken after BEGIN, then the copies are
+ *  merged back in input order before END runs.
+ *
+ *  Program is the generated class, derived from Awkccc_runtime, with
+ *      void main_rules()               the pattern-action rules for $0
+ *      void start_shard()              start_reduction() on each reduced variable
+ *      void merge_shard( Program & )   reduce() each reduced variable into this
+ *
+ *  Input that can't be mapped, paragraph mode & threads < 2 run sequentially.
+ **/
+template< typename Program >
+class Awkccc_parallel_driver {
+    public:
+        /** Process one input file. Returns false if it can't be opened */
+        static bool run_file( Program & program, const char * filename, unsigned threads ) {
+            if( ! program.open_input( filename ) )
+                return false;
+            std::string_view input;
+            if( threads < 2 || program.reader_.paragraph_mode() || ! program.reader_.whole_input( input ) ) {
+                while( program.next_record() )
+                    program.main_rules();
+                return true;
+            }
+            std::vector<Awkccc_shard> shards = plan_shards( input, program.reader_.separator(), threads );
+            std::vector<Program> states( shards.size(), program );
+            for( size_t i = 0; i < shards.size(); ++i )
+                start_shard( states[i], input, shards[i] );
+            std::vector<std::exception_ptr> errors( shards.size() );
+            std::vector<std::thread> workers;
+            for( size_t i = 0; i < shards.size(); ++i ) {
+                workers.emplace_back( [&, i]() {
+                    try {
+                        run_shard( states[i] );
+                    } catch( ... ) {
+                        errors[i] = std::current_exception();
+                    }
+                } );
+            }
+            for( auto & worker : workers )
+                worker.join();
+            for( auto & error : errors )
+                if( error )
+                    std::rethrow_exception( error );
+            const Program * last = nullptr;
+            for( auto & state : states ) {
+                program.merge_shard( state );
+                program.Awk__NR += state.Awk__NR;
+                program.Awk__FNR += state.Awk__FNR;
+                if( state.Awk__FNR > 0 )
+                    last = &state;
+            }
+            if( last != nullptr )
+                program.adopt_record( *last );
+            program.reader_.skip_to_end();
+            return true;
+        }
+        /** Point a copy of the program at its shard. Done on the calling
+         *  thread, as copying & starting touch strings shared with program */
+        static void start_shard( Program & state, std::string_view input, const Awkccc_shard & shard ) {
+            state.open_memory( input.substr( shard.begin_, shard.end_ - shard.begin_ ) );
+            state.start_shard();
+        }
+    private:
+        static void run_shard( Program & state ) {
+            while( state.next_record() )
+                state.main_rules();
+        }
+};
+
+/** Runs filter & transform programs, whose main rules print, on several
+ *  threads while keeping their output byte for byte as a sequential run
+ *  would write it. analyse_parallel() sets ordered_output_ for these.
+ *
+ *  The input is cut into chunks of about chunk_size bytes at record
+ *  boundaries. Workers take chunks in turn, each running on its own copy
+ *  of the program with output going to the chunk's buffer. The calling
+ *  thread is the sequencer: it writes each chunk's buffer to the program's
+ *  output & merges its variables strictly in input order, and keeps no
+ *  more than two chunks per thread in flight to bound memory use.
+ **/
+template< typename Program >
+class Awkccc_ordered_driver {
+    public:
+        static constexpr size_t default_chunk_size_ = size_t( 4 ) << 20;
+        /** Process one input file. Returns false if it can't be opened */
+        static bool run_file( Program & program, const char * filename, unsigned threads,
+                              size_t chunk_size = default_chunk_size_ ) {
+            if( ! program.open_input( filename ) )
+                return false;
+            std::string_view input;
+            if( threads < 2 || program.reader_.paragraph_mode() || ! program.reader_.whole_input( input ) ) {
+                while( program.next_record() )
+                    program.main_rules();
+                return true;
+            }
+            if( chunk_size == 0 )
+                chunk_size = default_chunk_size_;
+            const unsigned wanted = unsigned( input.size() / chunk_size + 1 );
+            std::vector<Awkccc_shard> shards = plan_shards( input, program.reader_.separator(), wanted );
+            std::vector<chunk> chunks( shards.size() );
+            const size_t window = size_t( threads ) * 2;
+            const Program initial( program );
+            std::mutex lock;
+            std::condition_variable changed;
+            size_t ready = 0;       // chunks prepared for a worker
+            size_t taken = 0;       // chunks handed to a worker
+            bool stop = false;      // a chunk failed, hand out no more
+            std::vector<std::thread> workers;
+            for( unsigned t = 0; t < threads && t < shards.size(); ++t ) {
+                workers.emplace_back( [&]() {
+                    std::unique_lock<std::mutex> hold( lock );
+                    for(;;) {
+                        changed.wait( hold, [&]() { return stop || taken < ready || taken == chunks.size(); } );
+                        if( stop || taken == chunks.size() )
+                            return;
+                        chunk & mine = chunks[taken++];
+                        hold.unlock();
+                        try {
+                            while( mine.state_->next_record() )
+                                mine.state_->main_rules();
+                        } catch( ... ) {
+                            mine.error_ = std::current_exception();
+                        }
+                        hold.lock();
+                        mine.done_ = true;
+                        changed.notify_all();
+                    }
+                } );
+            }
+            std::exception_ptr error;
+            std::unique_ptr<Program> last;
+            size_t prepared = 0;
+            for( size_t i = 0; i < chunks.size(); ++i ) {
+                for( ; prepared < chunks.size() && prepared < i + window; ++prepared ) {
+                    chunk & next = chunks[prepared];
+                    next.state_.reset( new Program( initial ) );
+                    next.state_->output_ = &next.output_;
+                    Awkccc_parallel_driver<Program>::start_shard( *next.state_, input, shards[prepared] );
+                    std::lock_guard<std::mutex> hold( lock );
+                    ready = prepared + 1;
+                    changed.notify_all();
+                }
+                {
+                    std::unique_lock<std::mutex> hold( lock );
+                    changed.wait( hold, [&]() { return chunks[i].done_; } );
+                }
+                chunk & done = chunks[i];
+                if( done.error_ ) {
+                    error = done.error_;
+                    std::lock_guard<std::mutex> hold( lock );
+                    stop = true;
+                    changed.notify_all();
+                    break;
+                }
+                program.output_->write( done.output_.text() );
+                program.merge_shard( *done.state_ );
+                program.Awk__NR += done.state_->Awk__NR;
+                program.Awk__FNR += done.state_->Awk__FNR;
+                done.output_.clear();
+                if( done.state_->Awk__FNR > 0 )
+                    last = std::move( done.state_ );
+                else
+                    done.state_.reset();
+            }
+            for( auto & worker : workers )
+                worker.join();
+            if( error )
+                std::rethrow_exception( error );
+            if( last )
+                program.adopt_record( *last );
+            program.reader_.skip_to_end();
+            return true;
+        }
+    private:
+        struct chunk {
+            std::unique_ptr<Program> state_;
+            Awkccc_writer output_{ Awkccc_writer::memory_ };
+            std::exception_ptr error_;
+            bool done_ = false;
+        };
+};
+}
+#endif
@@ -0,0 +1,228 @@
+/***
+**
+** AWKCCC Runtime record reader
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_RECORD_READER_HPP
+#define AWKCCC_RECORD_READER_HPP 1
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+namespace awkccc {
+/** Splits an input file into records without copying them.
+ *  Regular files are mapped into memory & each record is a string_view slice
+ *  of the mapping. Pipes, terminals & anything else mmap refuses are read()
+ *  into a reusable buffer which is grown only when a record doesn't fit.
+ *  A record returned by next_record() remains valid until the next call to
+ *  next_record() or close(), callers wanting to keep it must copy it.
+ **/
+class Awkccc_record_reader {
+    public:
+        static constexpr size_t initial_buffer_size_ = 64 * 1024;
+        Awkccc_record_reader()
+            : data_( nullptr )
+            , size_( 0 )
+            , pos_( 0 )
+            , fd_( -1 )
+            , owns_fd_( false )
+            , mapped_( false )
+            , eof_( true )
+            , separator_( '\n' )
+            , paragraph_mode_( false )
+            {}
+        /** A copy starts closed, only the original knows its place in the input */
+        Awkccc_record_reader( const Awkccc_record_reader & )
+            : Awkccc_record_reader()
+            {}
+        Awkccc_record_reader & operator = ( const Awkccc_record_reader & ) = delete;
+        ~Awkccc_record_reader() {
+            close();
+        }
+        /** Open a named file, "-" or "/dev/stdin" reads standard input.
+         *  Returns false (with errno set) if the file can't be opened. */
+        bool open( const char * filename ) {
+            if( std::strcmp( filename, "-" ) == 0 || std::strcmp( filename, "/dev/stdin" ) == 0 )
+                return open_fd( STDIN_FILENO, false );
+            int fd = ::open( filename, O_RDONLY );
+            if( fd < 0 )
+                return false;
+            return open_fd( fd, true );
+        }
+        /** Read from an already open file descriptor.
+         *  If owns_fd the descriptor is closed by close() */
+        bool open_fd( int fd, bool owns_fd ) {
+            close();
+            fd_ = fd;
+            owns_fd_ = owns_fd;
+            eof_ = false;
+            struct stat st;
+            // Files in /proc & the like claim a size of 0 & are read instead
+            if( fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) && st.st_size > 0 ) {
+                void * map = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+                if( map != MAP_FAILED ) {
+                    madvise( map, st.st_size, MADV_SEQUENTIAL );
+                    data_ = static_cast<const char *>( map );
+                    size_ = st.st_size;
+                    mapped_ = true;
+                    eof_ = true;
+                    return true;
+                }
+            }
+            // read() fallback for pipes etc.
+            if( buffer_.size() < initial_buffer_size_ )
+                buffer_.resize( initial_buffer_size_ );
+            data_ = buffer_.data();
+            return true;
+        }
+        /** Read records from text already in memory, such as one shard of
+         *  a mapped file. The text must outlive the reader's use of it */
+        void open_memory( const char * data, size_t size ) {
+            close();
+            data_ = data;
+            size_ = size;
+        }
+        void close() {
+            if( mapped_ )
+                munmap( const_cast<char *>( data_ ), size_ );
+            if( owns_fd_ && fd_ >= 0 )
+                ::close( fd_ );
+            data_ = nullptr;
+            size_ = pos_ = 0;
+            fd_ = -1;
+            owns_fd_ = mapped_ = false;
+            eof_ = true;
+        }
+        /** Set the record separator from the value of RS.
+         *  POSIX only uses the first character, "" selects paragraph mode */
+        void set_separator( std::string_view RS ) {
+            paragraph_mode_ = RS.empty();
+            separator_ = paragraph_mode_ ? '\n' : RS[0];
+        }
+        inline bool is_mapped() const {
+            return mapped_;
+        }
+        inline char separator() const {
+            return separator_;
+        }
+        inline bool paragraph_mode() const {
+            return paragraph_mode_;
+        }
+        /** The whole of a mapped input. False if it was not mapped */
+        bool whole_input( std::string_view & input ) const {
+            if( ! mapped_ )
+                return false;
+            input = std::string_view( data_, size_ );
+            return true;
+        }
+        /** Treat the rest of the input as consumed, keeping it mapped */
+        void skip_to_end() {
+            pos_ = size_;
+        }
+        /** Fetch the next record, without its terminator.
+         *  Returns false at end of input */
+        bool next_record( std::string_view & record ) {
+            if( data_ == nullptr )
+                return false;
+            for(;;) {
+                if( paragraph_mode_ ) {
+                    // Leading newlines never start a record
+                    while( pos_ < size_ && data_[pos_] == '\n' )
+                        ++pos_;
+                }
+                const char * start = data_ + pos_;
+                const char * end = data_ + size_;
+                const char * next;
+                if( const char * found = find_terminator( start, end, next ) ) {
+                    record = std::string_view( start, found - start );
+                    pos_ = next - data_;
+                    return true;
+                }
+                if( eof_ ) {
+                    if( pos_ >= size_ )
+                        return false;
+                    // Final record lacks a terminator
+                    if( paragraph_mode_ )
+                        while( end > start && end[-1] == '\n' )
+                            --end;
+                    record = std::string_view( start, end - start );
+                    pos_ = size_;
+                    return true;
+                }
+                refill();
+            }
+        }
+    private:
+        const char * data_;
+        size_t size_;
+        size_t pos_;
+        int fd_;
+        bool owns_fd_;
+        bool mapped_;
+        bool eof_;
+        char separator_;
+        bool paragraph_mode_;
+        std::vector<char> buffer_;
+
+        /** Return the end of the record beginning at start & set next to the
+         *  beginning of the following record, nullptr if no terminator in view */
+        inline const char * find_terminator( const char * start, const char * end, const char * & next ) const {
+            if( ! paragraph_mode_ ) {
+                auto found = static_cast<const char *>( std::memchr( start, separator_, end - start ) );
+                if( found )
+                    next = found + 1;
+                return found;
+            }
+            // Paragraph mode: records end at a blank line
+            for( const char * p = start;
+                 ( p = static_cast<const char *>( std::memchr( p, '\n', end - p ) ) ) != nullptr;
+                 ++p ) {
+                if( p + 1 < end && p[1] == '\n' ) {
+                    next = p + 2;
+                    return p;
+                }
+                if( p + 1 == end )
+                    break;
+            }
+            return nullptr;
+        }
+        /** Shuffle the unread tail of the buffer to the front & read more,
+         *  growing the buffer if a single record fills it */
+        void refill() {
+            size_t unread = size_ - pos_;
+            if( pos_ > 0 && unread > 0 )
+                std::memmove( buffer_.data(), buffer_.data() + pos_, unread );
+            pos_ = 0;
+            size_ = unread;
+            if( size_ == buffer_.size() )
+                buffer_.resize( buffer_.size() * 2 );
+            data_ = buffer_.data();
+            ssize_t got;
+            do {
+                got = ::read( fd_, buffer_.data() + size_, buffer_.size() - size_ );
+            } while( got < 0 && errno == EINTR );
+            if( got <= 0 )
+                eof_ = true;
+            else
+                size_ += got;
+        }
+};
+}
+#endif
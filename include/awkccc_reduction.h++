@@ -0,0 +1,43 @@
+/***
+**
+** AWKCCC Reductions shared by the translator & the parallel runtime
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_REDUCTION_HPP
+#define AWKCCC_REDUCTION_HPP 1
+namespace awkccc {
+/** How the copies of a variable updated by parallel shards are combined.
+ *  Found by analyse_parallel() from the way the main rules update it.
+ **/
+enum Awkccc_reduction {
+    Reduce_Sum,     // x++, x--, x += e, x -= e
+    Reduce_Max,     // if( e > x ) x = e
+    Reduce_Min,     // if( e < x ) x = e
+    Reduce_Last     // x = e: the value from the last record to assign it
+};
+
+/** The enumerator's name, as written into generated code */
+inline const char * reduction_name( Awkccc_reduction reduction ) {
+    switch( reduction ) {
+        case Reduce_Sum: return "awkccc::Reduce_Sum";
+        case Reduce_Max: return "awkccc::Reduce_Max";
+        case Reduce_Min: return "awkccc::Reduce_Min";
+        case Reduce_Last: return "awkccc::Reduce_Last";
+    }
+    return "awkccc::Reduce_Last";
+}
+}
+#endif
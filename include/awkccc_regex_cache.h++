@@ -0,0 +1,184 @@
+/***
+**
+** AWKCCC Runtime cache of compiled dynamic regular expressions
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_REGEX_CACHE_HPP
+#define AWKCCC_REGEX_CACHE_HPP 1
+#include <list>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include "../include/awkccc_output_table.h++"
+namespace awkccc {
+/** pattern, an awk ERE, compiled. Awk's escapes such as \t & \/ are
+ *  understood & one that isn't valid is a fatal error */
+inline std::regex compile_ere( std::string_view pattern ) {
+    try {
+        return std::regex( pattern.begin(), pattern.end(), std::regex::awk );
+    } catch( const std::regex_error & error ) {
+        fatal_error( "invalid regular expression /" + std::string( pattern ) + "/: " + error.what() );
+    }
+}
+/** std::regex_search, with the errors it can meet, such as a pattern too
+ *  complex for the text, fatal as a pattern that won't compile is */
+template< typename... Args >
+inline bool search_ere( Args &&... args ) {
+    try {
+        return std::regex_search( std::forward<Args>( args )... );
+    } catch( const std::regex_error & error ) {
+        fatal_error( std::string( "regular expression match failed: " ) + error.what() );
+    }
+}
+
+/** Compiled forms of the regular expressions a program builds at run time,
+ *  as in $1 ~ pattern or match( $0, variable ), keyed by the pattern text.
+ *  Constant EREs are compiled by the translator & never come here.
+ *
+ *  The pattern used last is checked first, as a program usually matches
+ *  the same variable against every record. Other patterns cost one hash
+ *  probe. At most capacity_ patterns are kept, the least recently used
+ *  is dropped to make room. Patterns that are plain text, or ^ & plain
+ *  text, are never compiled: a string search or compare does instead.
+ **/
+class Awkccc_regex_cache {
+    public:
+        static constexpr size_t default_capacity_ = 64;
+        explicit Awkccc_regex_cache( size_t capacity = default_capacity_ )
+            : capacity_( capacity ? capacity : 1 )
+            {}
+        Awkccc_regex_cache( const Awkccc_regex_cache & ) = delete;
+        Awkccc_regex_cache & operator = ( const Awkccc_regex_cache & ) = delete;
+
+        /** The compiled ERE. One that isn't valid is a fatal error */
+        const std::regex & get( std::string_view pattern ) {
+            entry & found = lookup( pattern );
+            if( ! found.compiled_ )
+                compile( found );
+            return found.regex_;
+        }
+        /** text ~ pattern */
+        bool matches( std::string_view text, std::string_view pattern ) {
+            entry & found = lookup( pattern );
+            switch( found.shape_ ) {
+                case Shape_Literal:
+                    return text.find( found.literal() ) != std::string_view::npos;
+                case Shape_Prefix:
+                    return text.substr( 0, found.literal().size() ) == found.literal();
+                default:
+                    return search_ere( text.begin(), text.end(), found.regex_ );
+            }
+        }
+        /** The leftmost match of pattern in text. False if there is none */
+        bool search( std::string_view text, std::string_view pattern, size_t & start, size_t & length ) {
+            entry & found = lookup( pattern );
+            if( found.shape_ != Shape_Automaton ) {
+                start = found.shape_ == Shape_Prefix
+                      ? ( text.substr( 0, found.literal().size() ) == found.literal() ? 0 : std::string_view::npos )
+                      : text.find( found.literal() );
+                length = found.literal().size();
+                return start != std::string_view::npos;
+            }
+            std::match_results<std::string_view::const_iterator> match;
+            if( ! search_ere( text.begin(), text.end(), match, found.regex_ ) )
+                return false;
+            start = match.position( 0 );
+            length = match.length( 0 );
+            return true;
+        }
+        inline size_t size() const {
+            return entries_.size();
+        }
+        /** How many times a pattern has been compiled, for testing */
+        inline size_t compiled() const {
+            return compiled_;
+        }
+    private:
+        /// Plain text patterns are searched for without an automaton
+        enum shape {
+            Shape_Automaton,
+            Shape_Literal,  ///< No ERE operators at all
+            Shape_Prefix    ///< ^ followed by no ERE operators
+        };
+        struct entry {
+            std::string pattern_;
+            shape shape_ = Shape_Automaton;
+            bool compiled_ = false;
+            std::regex regex_;
+            inline std::string_view literal() const {
+                return std::string_view( pattern_ ).substr( shape_ == Shape_Prefix ? 1 : 0 );
+            }
+        };
+        /// Most recently used first
+        std::list<entry> entries_;
+        std::unordered_map<std::string_view, std::list<entry>::iterator> index_;
+        entry * last_ = nullptr;
+        size_t capacity_;
+        size_t compiled_ = 0;
+
+        entry & lookup( std::string_view pattern ) {
+            if( last_ != nullptr && last_->pattern_ == pattern )
+                return *last_;
+            auto found = index_.find( pattern );
+            if( found != index_.end() ) {
+                if( found->second != entries_.begin() )
+                    entries_.splice( entries_.begin(), entries_, found->second );
+            } else {
+                if( entries_.size() >= capacity_ ) {
+                    if( last_ == &entries_.back() )
+                        last_ = nullptr;
+                    index_.erase( std::string_view( entries_.back().pattern_ ) );
+                    entries_.pop_back();
+                }
+                entries_.push_front( entry() );
+                entry & added = entries_.front();
+                added.pattern_ = pattern;
+                added.shape_ = shape_of( pattern );
+                if( added.shape_ == Shape_Automaton ) {
+                    try {
+                        compile( added );
+                    } catch( ... ) {
+                        entries_.pop_front();
+                        throw;
+                    }
+                }
+                index_.emplace( std::string_view( added.pattern_ ), entries_.begin() );
+            }
+            last_ = &entries_.front();
+            return *last_;
+        }
+        void compile( entry & target ) {
+            target.regex_ = compile_ere( target.pattern_ );
+            target.compiled_ = true;
+            ++compiled_;
+        }
+        static shape shape_of( std::string_view pattern ) {
+            bool prefix = ! pattern.empty() && pattern[0] == '^';
+            if( pattern.find_first_of( "\\.[]()*+?{}|^$", prefix ? 1 : 0 ) != std::string_view::npos )
+                return Shape_Automaton;
+            return prefix ? Shape_Prefix : Shape_Literal;
+        }
+};
+
+/** This thread's cache. Parallel shards each match on their own thread */
+inline Awkccc_regex_cache & regex_cache() {
+    static thread_local Awkccc_regex_cache cache;
+    return cache;
+}
+}
+#endif
@@ -18,30 +18,291 @@
 ***/
 #ifndef AWKCCC_RUNTIME_HPP
 #define AWKCCC_RUNTIME_HPP 1
+#include <cstdlib>
 #include <map>
+#include <string_view>
+#include <utility>
+#include <sys/wait.h>
 #include "../include/awkccc_variable.h++"
+#include "../include/awkccc_array.h++"
+#include "../include/awkccc_intern.h++"
+#include "../include/awkccc_record_reader.h++"
+#include "../include/awkccc_fields.h++"
+#include "../include/awkccc_output.h++"
+#include "../include/awkccc_output_table.h++"
+#include "../include/awkccc_regex_cache.h++"
 using namespace awkccc;
+/** CONVFMT: a variable that brings conversion_format() into line with
+ *  itself whenever the program assigns to it */
+class Awkccc_convfmt_variable : public Awkccc_variable {
+    public:
+        using Awkccc_variable::Awkccc_variable;
+        Awkccc_convfmt_variable( const Awkccc_convfmt_variable & ) = default;
+        Awkccc_convfmt_variable & operator = ( const Awkccc_convfmt_variable & value ) {
+            return *this = static_cast<const Awkccc_variable &>( value );
+        }
+        template< typename Value >
+        Awkccc_convfmt_variable & operator = ( Value && value ) {
+            Awkccc_variable::operator = ( std::forward<Value>( value ) );
+            update();
+            return *this;
+        }
+        /** Parse the format again if it has changed */
+        inline void update() const {
+            Awkccc_number_format::text buf;
+            conversion_format().update( text( buf ) );
+        }
+};
 /** The Awkccc_runtime class acts as a wrapper around the generated C++ code
  *  It provides the runtime variables & implements the Awk processing loop
  *  Generated code supplies the business logic in the final program
  **/
 class Awkccc_runtime {
     public:
-        int Awk__ARGC;
-        std::map<jclib::jString, Awkccc_variable> Awk__ARGV;
-        Awkccc_variable Awk__CONVFMT;
-        std::map<jclib::jString, Awkccc_variable>  Awk__ENVIRON;
+        int Awk__ARGC = 0;
+        Awkccc_array Awk__ARGV;
+        Awkccc_convfmt_variable Awk__CONVFMT{ "%.6g" };
+        Awkccc_array Awk__ENVIRON;
         jclib::jString Awk__FILENAME;
-        long Awk__FNR;
-        Awkccc_variable Awk__FS;
-        int Awk__NF;
-        int Awk__NR;
-        Awkccc_variable Awk__OFMT;
-        Awkccc_variable Awk__OFS;
-        Awkccc_variable Awk__ORS;
-        int Awk__RLENGTH;
-        Awkccc_variable Awk__RS;
+        long Awk__FNR = 0;
+        Awkccc_variable Awk__FS{ " " };
+        int Awk__NF = 0;
+        int Awk__NR = 0;
+        Awkccc_variable Awk__OFMT{ "%.6g" };
+        Awkccc_variable Awk__OFS{ " " };
+        Awkccc_variable Awk__ORS{ "\n" };
+        int Awk__RLENGTH = -1;
+        Awkccc_variable Awk__RS{ "\n" };
         Awkccc_variable Awk__RSTART;
-        Awkccc_variable Awk__SUBSEP;
+        Awkccc_variable Awk__SUBSEP{ "\034" };
+
+        /// Source of input records for the main loop
+        Awkccc_record_reader reader_;
+        /// $0. A slice of the reader's input until the program assigns to it
+        std::string_view record_;
+        /// Owns the text of $0 once it has been modified
+        jclib::jString modified_record_;
+        bool record_modified_ = false;
+        /// Share field values through intern_table(), for programs that
+        /// keep fields as array keys or in variables
+        bool intern_fields_ = false;
+        /// $1..$NF, split lazily
+        Awkccc_fields fields_;
+        /// Temporaries made from the current record, freed all at once when
+        /// the main loop reads the next one
+        Awkccc_arena arena_;
+        /// OFMT as last parsed
+        Awkccc_number_format output_format_;
+        /// Where print & printf without redirection write. A parallel
+        /// shard's own buffer while it runs
+        Awkccc_writer * output_ = &standard_output();
+
+        /** Open the next input file. Returns false if it can't be opened */
+        bool open_input( const char * filename ) {
+            if( ! reader_.open( filename ) )
+                return false;
+            set_input_separators();
+            Awk__FILENAME = filename;
+            Awk__FNR = 0;
+            return true;
+        }
+        /** Read records from text already in memory, one shard of a
+         *  parallel run. NR & FNR count from 0 within the shard */
+        void open_memory( std::string_view input ) {
+            reader_.open_memory( input.data(), input.size() );
+            set_input_separators();
+            Awk__NR = 0;
+            Awk__FNR = 0;
+        }
+        inline void set_input_separators() {
+            reader_.set_separator( std::string_view( jclib::jString( Awk__RS ) ) );
+            fields_.set_separator( std::string_view( jclib::jString( Awk__FS ) ) );
+        }
+        /** Read the next record into $0 without copying it, for the main
+         *  loop, between actions, where no temporary can still be held.
+         *  Returns false at the end of the current input file */
+        bool next_record() {
+            arena_.reset();
+            return read_record();
+        }
+        /** As next_record(), for getline within an action. Temporaries
+         *  stay, as the action may still hold them, as in f($1) with
+         *  function f(x) { getline; print x } */
+        bool read_record() {
+            if( ! reader_.next_record( record_ ) )
+                return false;
+            record_modified_ = false;
+            update_conversion_format();
+            ++Awk__NR;
+            ++Awk__FNR;
+            new_fields();
+            return true;
+        }
+        /** Split the new $0 as far as the program needs up front.
+         *  NF is only kept up to date if the program uses it */
+        inline void new_fields() {
+            fields_.reset( record_ );
+            if( fields_.usage().uses_nf_ )
+                Awk__NF = fields_.count();
+        }
+        /** $n */
+        inline std::string_view field( size_t n ) {
+            return n == 0 ? record_ : fields_.get( n );
+        }
+        /** $n in arithmetic, as in $3 * 2 */
+        inline double field_number( size_t n ) {
+            return fields_.number( n ).value_;
+        }
+        /** $n as a value, as in $3 > 100 or x = $3: a numeric string if it
+         *  looks like a number, uninitialised beyond NF. A temporary in
+         *  arena_ unless fields are interned */
+        Awkccc_variable field_value( size_t n ) {
+            const Awkccc_field_number & number = fields_.number( n );
+            if( number.missing_ )
+                return Awkccc_variable();
+            if( intern_fields_ )
+                return intern_table().intern( field( n ), number.value_, number.numeric_ );
+            return Awkccc_variable::from_input( field( n ), number.value_, number.numeric_, arena_ );
+        }
+        /** A concatenation as a temporary, valid until the next record */
+        template< size_t Count >
+        inline Awkccc_variable temporary( const Awkccc_concatenation<Count> & pieces ) {
+            return pieces.value( arena_ );
+        }
+        /** $0 as seen by the program */
+        inline std::string_view record() const {
+            return record_;
+        }
+        /** Take over another runtime's current record, as if this runtime
+         *  had read it. Used to leave $0 & NF as END expects after a
+         *  parallel run. The text it read must still be mapped */
+        void adopt_record( const Awkccc_runtime & other ) {
+            if( other.record_modified_ ) {
+                set_record( other.modified_record_ );
+            } else {
+                record_ = other.record_;
+                record_modified_ = false;
+                new_fields();
+            }
+        }
+        /** text ~ ere, where ere is only known at run time */
+        inline bool matches( std::string_view text, std::string_view ere ) {
+            return regex_cache().matches( text, ere );
+        }
+        /** match( text, ere ): sets RSTART & RLENGTH, returns RSTART */
+        int match( std::string_view text, std::string_view ere ) {
+            size_t start, length;
+            if( regex_cache().search( text, ere, start, length ) ) {
+                Awk__RSTART = double( start + 1 );
+                Awk__RLENGTH = int( length );
+            } else {
+                Awk__RSTART = 0.0;
+                Awk__RLENGTH = -1;
+            }
+            return Awk__RLENGTH < 0 ? 0 : int( start + 1 );
+        }
+        /** OFMT, parsed again only when the program has changed it */
+        inline const Awkccc_number_format & output_format() {
+            Awkccc_number_format::text buf;
+            output_format_.update( Awk__OFMT.text( buf ) );
+            return output_format_;
+        }
+        /** Bring conversion_format() into line with CONVFMT. Assigning
+         *  CONVFMT does so too; this is done for each record as well, so
+         *  the thread running a parallel shard follows the shard's copy */
+        inline void update_conversion_format() {
+            Awk__CONVFMT.update();
+        }
+        /** print item, item, ... to the unredirected output */
+        template< typename... Items >
+        void print( const Items &... items ) {
+            Awkccc_number_format::text OFS_buf, ORS_buf;
+            output_->print( Awk__OFS.text( OFS_buf ), Awk__ORS.text( ORS_buf ), output_format(), items... );
+        }
+        /** print with no items prints $0 */
+        void print() {
+            print( record_ );
+        }
+        /** printf format, args... The arguments must already be C types */
+        template< typename... Args >
+        void print_formatted( const char * format, Args... args ) {
+            output_->format( format, args... );
+        }
+        /** print item, item, ... > name, >> name or | command.
+         *  Returns false if the destination can't be opened */
+        template< typename... Items >
+        bool print_to( std::string_view name, Awkccc_redirection how, const Items &... items ) {
+            Awkccc_writer * writer = redirected( name, how );
+            if( writer == nullptr )
+                return false;
+            Awkccc_number_format::text OFS_buf, ORS_buf;
+            if constexpr ( sizeof...( items ) == 0 )
+                writer->print( Awk__OFS.text( OFS_buf ), Awk__ORS.text( ORS_buf ), output_format(), record_ );
+            else
+                writer->print( Awk__OFS.text( OFS_buf ), Awk__ORS.text( ORS_buf ), output_format(), items... );
+            return true;
+        }
+        /** printf format, args... redirected */
+        template< typename... Args >
+        bool print_formatted_to( std::string_view name, Awkccc_redirection how, const char * format, Args... args ) {
+            Awkccc_writer * writer = redirected( name, how );
+            if( writer == nullptr )
+                return false;
+            writer->format( format, args... );
+            return true;
+        }
+        /** /dev/stdout & "-" are the program's own output & /dev/stderr
+         *  standard error, rather than files opened again. nullptr for
+         *  any other name */
+        Awkccc_writer * standard_stream( std::string_view name ) {
+            if( name == "/dev/stdout" || name == "-" )
+                return output_;
+            if( name == "/dev/stderr" )
+                return &standard_error();
+            return nullptr;
+        }
+        /** The writer for > name, >> name or | command, nullptr if it can't be opened */
+        inline Awkccc_writer * redirected( std::string_view name, Awkccc_redirection how ) {
+            Awkccc_writer * writer = how == Redirect_Pipe ? nullptr : standard_stream( name );
+            return writer ? writer : output_table().get( name, how );
+        }
+        /** close( name ): flush & close a redirected output. A standard
+         *  stream is only flushed */
+        int close( const char * name ) {
+            if( Awkccc_writer * writer = standard_stream( name ) )
+                return writer->flush() ? 0 : -1;
+            return output_table().close( name );
+        }
+        /** Output must reach its destination before anything else can see
+         *  it: before system() runs a command & before the program exits */
+        bool flush_output() {
+            bool ok = output_->flush();
+            ok = standard_output().flush() && ok;
+            return output_table().flush_all() && ok;
+        }
+        /** system( command ): the command's exit status, or as gawk does
+         *  256 plus the signal that killed it. -1 if it couldn't be run */
+        int system( const char * command ) {
+            flush_output();
+            int status = std::system( command );
+            if( status == -1 )
+                return -1;
+            if( WIFSIGNALED( status ) )
+                return 256 + WTERMSIG( status );
+            return WEXITSTATUS( status );
+        }
+        /** exit status, after END has run */
+        [[noreturn]] void exit_program( int status ) {
+            flush_output();
+            output_table().close_all();
+            std::exit( status );
+        }
+        /** Assign to $0. Only now does the record get a jString of its own */
+        void set_record( const jclib::jString & value ) {
+            modified_record_ = value;
+            record_ = std::string_view( (const char *) modified_record_, modified_record_.len() );
+            record_modified_ = true;
+            new_fields();
+        }
 };
 #endif
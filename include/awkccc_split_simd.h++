@@ -0,0 +1,284 @@
+/***
+**
+** AWKCCC Runtime SIMD field splitting kernels
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#ifndef AWKCCC_SPLIT_SIMD_HPP
+#define AWKCCC_SPLIT_SIMD_HPP 1
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#define AWKCCC_SPLIT_X86 1
+#include <immintrin.h>
+#endif
+namespace awkccc {
+/** A field is a slice of the record, held as offsets to keep the table small */
+struct Awkccc_field_span {
+    uint32_t start_;
+    uint32_t length_;
+};
+
+/** Field splitting kernels.
+ *  Each kernel scans the record once, 32 bytes at a time, turning the
+ *  separators in each block into a bit mask & walking the mask with
+ *  count-trailing-zeros to find field boundaries. Only the block classifier
+ *  differs between the scalar, SSE2 & AVX2 versions.
+ *
+ *  A kernel starts at pos, appends spans until limit fields are known or
+ *  the record is exhausted, & returns true if the record is exhausted.
+ *  next is set to where a later call should resume.
+ *  default_fs kernels implement FS=" ": fields are separated by runs of
+ *  blanks, tabs & newlines with leading & trailing separators ignored.
+ *  pos must be a field end or the start of the record.
+ *  char_fs kernels split on every occurrence of a single byte.
+ *  pos must be the start of a field.
+ **/
+typedef bool (*Awkccc_default_fs_kernel)( const char * data, size_t size, size_t pos,
+                                          size_t limit, std::vector<Awkccc_field_span> & spans,
+                                          size_t & next );
+typedef bool (*Awkccc_char_fs_kernel)( const char * data, size_t size, size_t pos, char separator,
+                                       size_t limit, std::vector<Awkccc_field_span> & spans,
+                                       size_t & next );
+
+namespace split_kernels {
+    static constexpr unsigned block_ = 32;
+
+    inline unsigned trailing_zeros( uint32_t bits ) {
+        return __builtin_ctz( bits );
+    }
+    inline uint32_t valid_bits( unsigned len ) {
+        return len >= 32 ? ~0u : ( ( 1u << len ) - 1 );
+    }
+    inline bool is_blank( char c ) {
+        return c == ' ' || c == '\t' || c == '\n';
+    }
+    inline void add_span( std::vector<Awkccc_field_span> & spans, size_t start, size_t end ) {
+        spans.push_back( { uint32_t( start ), uint32_t( end - start ) } );
+    }
+
+    /// Where the default FS scan is up to between blocks
+    struct default_fs_cursor {
+        size_t field_start_ = 0;
+        bool in_field_ = false;
+    };
+
+    /** Walk one block's blank mask. Returns true once limit is reached */
+    inline bool default_fs_block( uint32_t blanks, size_t base, unsigned len,
+                                  default_fs_cursor & cursor, std::vector<Awkccc_field_span> & spans,
+                                  size_t limit, size_t & next ) {
+        const uint32_t valid = valid_bits( len );
+        blanks &= valid;
+        const uint32_t non_blanks = ~blanks & valid;
+        unsigned k = 0;
+        while( k < len ) {
+            const uint32_t upper = ~0u << k;
+            if( cursor.in_field_ ) {
+                uint32_t ends = blanks & upper;
+                if( ! ends )
+                    return false;
+                k = trailing_zeros( ends );
+                add_span( spans, cursor.field_start_, base + k );
+                cursor.in_field_ = false;
+                if( spans.size() >= limit ) {
+                    next = base + k;
+                    return true;
+                }
+            } else {
+                uint32_t starts = non_blanks & upper;
+                if( ! starts )
+                    return false;
+                k = trailing_zeros( starts );
+                cursor.field_start_ = base + k;
+                cursor.in_field_ = true;
+            }
+        }
+        return false;
+    }
+
+    /** Walk one block's separator mask. Returns true once limit is reached */
+    inline bool char_fs_block( uint32_t hits, size_t base, unsigned len, size_t & field_start,
+                               std::vector<Awkccc_field_span> & spans, size_t limit, size_t & next ) {
+        hits &= valid_bits( len );
+        while( hits ) {
+            const size_t found = base + trailing_zeros( hits );
+            hits &= hits - 1;
+            add_span( spans, field_start, found );
+            field_start = found + 1;
+            if( spans.size() >= limit ) {
+                next = field_start;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline uint32_t scalar_blank_mask( const char * p, unsigned len ) {
+        uint32_t mask = 0;
+        for( unsigned i = 0; i < len; ++i )
+            mask |= uint32_t( is_blank( p[i] ) ) << i;
+        return mask;
+    }
+    inline uint32_t scalar_char_mask( const char * p, unsigned len, char separator ) {
+        uint32_t mask = 0;
+        for( unsigned i = 0; i < len; ++i )
+            mask |= uint32_t( p[i] == separator ) << i;
+        return mask;
+    }
+
+    /** The kernels differ only in how a full block is classified, so the
+     *  loop is written once. The final partial block is always scalar. */
+#define AWKCCC_DEFAULT_FS_KERNEL_BODY( BLANK_MASK ) \
+        default_fs_cursor cursor; \
+        size_t base = pos; \
+        for( ; base + block_ <= size; base += block_ ) \
+            if( default_fs_block( BLANK_MASK, base, block_, cursor, spans, limit, next ) ) \
+                return false; \
+        if( base < size \
+         && default_fs_block( scalar_blank_mask( data + base, size - base ), base, size - base, \
+                              cursor, spans, limit, next ) ) \
+            return false; \
+        if( cursor.in_field_ ) \
+            add_span( spans, cursor.field_start_, size ); \
+        next = size; \
+        return true;
+
+#define AWKCCC_CHAR_FS_KERNEL_BODY( CHAR_MASK ) \
+        size_t field_start = pos; \
+        size_t base = pos; \
+        for( ; base + block_ <= size; base += block_ ) \
+            if( char_fs_block( CHAR_MASK, base, block_, field_start, spans, limit, next ) ) \
+                return false; \
+        if( base < size \
+         && char_fs_block( scalar_char_mask( data + base, size - base, separator ), base, size - base, \
+                           field_start, spans, limit, next ) ) \
+            return false; \
+        add_span( spans, field_start, size ); \
+        next = size; \
+        return true;
+
+    inline bool default_fs_scalar( const char * data, size_t size, size_t pos, size_t limit,
+                                   std::vector<Awkccc_field_span> & spans, size_t & next ) {
+        AWKCCC_DEFAULT_FS_KERNEL_BODY( scalar_blank_mask( data + base, block_ ) )
+    }
+    inline bool char_fs_scalar( const char * data, size_t size, size_t pos, char separator, size_t limit,
+                                std::vector<Awkccc_field_span> & spans, size_t & next ) {
+        AWKCCC_CHAR_FS_KERNEL_BODY( scalar_char_mask( data + base, block_, separator ) )
+    }
+
+#ifdef AWKCCC_SPLIT_X86
+    __attribute__((target("sse2")))
+    inline uint32_t sse2_blank_mask( const char * p ) {
+        const __m128i space = _mm_set1_epi8( ' ' );
+        const __m128i tab = _mm_set1_epi8( '\t' );
+        const __m128i newline = _mm_set1_epi8( '\n' );
+        __m128i lo = _mm_loadu_si128( reinterpret_cast<const __m128i *>( p ) );
+        __m128i hi = _mm_loadu_si128( reinterpret_cast<const __m128i *>( p + 16 ) );
+        __m128i lo_blank = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( lo, space ), _mm_cmpeq_epi8( lo, tab ) ),
+                                         _mm_cmpeq_epi8( lo, newline ) );
+        __m128i hi_blank = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( hi, space ), _mm_cmpeq_epi8( hi, tab ) ),
+                                         _mm_cmpeq_epi8( hi, newline ) );
+        return uint32_t( _mm_movemask_epi8( lo_blank ) ) | ( uint32_t( _mm_movemask_epi8( hi_blank ) ) << 16 );
+    }
+    __attribute__((target("sse2")))
+    inline uint32_t sse2_char_mask( const char * p, __m128i separator ) {
+        __m128i lo = _mm_loadu_si128( reinterpret_cast<const __m128i *>( p ) );
+        __m128i hi = _mm_loadu_si128( reinterpret_cast<const __m128i *>( p + 16 ) );
+        return uint32_t( _mm_movemask_epi8( _mm_cmpeq_epi8( lo, separator ) ) )
+             | ( uint32_t( _mm_movemask_epi8( _mm_cmpeq_epi8( hi, separator ) ) ) << 16 );
+    }
+    __attribute__((target("sse2")))
+    inline bool default_fs_sse2( const char * data, size_t size, size_t pos, size_t limit,
+                                 std::vector<Awkccc_field_span> & spans, size_t & next ) {
+        AWKCCC_DEFAULT_FS_KERNEL_BODY( sse2_blank_mask( data + base ) )
+    }
+    __attribute__((target("sse2")))
+    inline bool char_fs_sse2( const char * data, size_t size, size_t pos, char separator, size_t limit,
+                              std::vector<Awkccc_field_span> & spans, size_t & next ) {
+        const __m128i wanted = _mm_set1_epi8( separator );
+        AWKCCC_CHAR_FS_KERNEL_BODY( sse2_char_mask( data + base, wanted ) )
+    }
+
+    __attribute__((target("avx2")))
+    inline uint32_t avx2_blank_mask( const char * p ) {
+        const __m256i space = _mm256_set1_epi8( ' ' );
+        const __m256i tab = _mm256_set1_epi8( '\t' );
+        const __m256i newline = _mm256_set1_epi8( '\n' );
+        __m256i bytes = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( p ) );
+        __m256i blank = _mm256_or_si256( _mm256_or_si256( _mm256_cmpeq_epi8( bytes, space ),
+                                                          _mm256_cmpeq_epi8( bytes, tab ) ),
+                                         _mm256_cmpeq_epi8( bytes, newline ) );
+        return uint32_t( _mm256_movemask_epi8( blank ) );
+    }
+    __attribute__((target("avx2")))
+    inline bool default_fs_avx2( const char * data, size_t size, size_t pos, size_t limit,
+                                 std::vector<Awkccc_field_span> & spans, size_t & next ) {
+        AWKCCC_DEFAULT_FS_KERNEL_BODY( avx2_blank_mask( data + base ) )
+    }
+    __attribute__((target("avx2")))
+    inline bool char_fs_avx2( const char * data, size_t size, size_t pos, char separator, size_t limit,
+                              std::vector<Awkccc_field_span> & spans, size_t & next ) {
+        const __m256i wanted = _mm256_set1_epi8( separator );
+        AWKCCC_CHAR_FS_KERNEL_BODY( uint32_t( _mm256_movemask_epi8(
+                _mm256_cmpeq_epi8( _mm256_loadu_si256( reinterpret_cast<const __m256i *>( data + base ) ),
+                                   wanted ) ) ) )
+    }
+#endif
+#undef AWKCCC_DEFAULT_FS_KERNEL_BODY
+#undef AWKCCC_CHAR_FS_KERNEL_BODY
+}
+
+/** Which kernel set to use */
+enum Awkccc_split_isa {
+    Split_Scalar,
+    Split_SSE2,
+    Split_AVX2
+};
+
+/** The kernels selected for this CPU. Chosen once via CPUID */
+struct Awkccc_split_kernels {
+    Awkccc_split_isa isa_;
+    Awkccc_default_fs_kernel default_fs_;
+    Awkccc_char_fs_kernel char_fs_;
+
+    /** The best kernel set this CPU supports */
+    static Awkccc_split_isa best_isa() {
+#ifdef AWKCCC_SPLIT_X86
+        __builtin_cpu_init();
+        if( __builtin_cpu_supports( "avx2" ) )
+            return Split_AVX2;
+        if( __builtin_cpu_supports( "sse2" ) )
+            return Split_SSE2;
+#endif
+        return Split_Scalar;
+    }
+    /** Kernels for isa, falling back to scalar if it isn't compiled in */
+    static Awkccc_split_kernels for_isa( Awkccc_split_isa isa ) {
+#ifdef AWKCCC_SPLIT_X86
+        if( isa == Split_AVX2 )
+            return { Split_AVX2, split_kernels::default_fs_avx2, split_kernels::char_fs_avx2 };
+        if( isa == Split_SSE2 )
+            return { Split_SSE2, split_kernels::default_fs_sse2, split_kernels::char_fs_sse2 };
+#endif
+        return { Split_Scalar, split_kernels::default_fs_scalar, split_kernels::char_fs_scalar };
+    }
+    static const Awkccc_split_kernels & selected() {
+        static const Awkccc_split_kernels kernels = for_isa( best_isa() );
+        return kernels;
+    }
+};
+}
+#endif
@@ -18,10 +18,19 @@
 ***/
 #ifndef AWKCCC_VARIABLE_HPP
 #define AWKCCC_VARIABLE_HPP 1
+#include <atomic>
 #include <charconv>
-#include <cstdio> // FIXME replace with <format> once C++20 in all target systems
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <cmath>
+#include <new>
+#include <string_view>
+#include <type_traits>
 #include "../include/jString.hpp"
+#include "../include/awkccc_number.h++"
+#include "../include/awkccc_arena.h++"
 namespace awkccc {
 /** A variable at any moment may be any of:
  *  uninitalised equivalent to "" and 0.0,
@@ -36,141 +45,290 @@ enum Awkccc_data_type{
     Numeric_String
 };
 
-/** AWK variables are untyped, but coerce their values to string or number on demand*/
+/** AWK variables are untyped, but coerce their values to string or number on demand.
+ *
+ *  A variable is 16 bytes: the double & one word holding the string &
+ *  the type. Strings of up to 6 bytes live in the word itself. Longer
+ *  ones are on the heap, shared between copies & reference counted, &
+ *  the word holds a pointer to them. The word's top two bytes hold the
+ *  inline length, whether the string is on the heap, the data type &
+ *  which of the number & string are valid. Pointers must fit in the
+ *  48 bits left, as user space pointers do on x86-64 & AArch64.
+ *
+ *  A temporary, such as a field value or concatenation made for one
+ *  record, may keep its string in the runtime's Awkccc_arena instead of
+ *  on the heap. Moving a temporary keeps it there, but copying or
+ *  assigning it anywhere, a variable, an array element or the runtime's
+ *  own state, first promotes the string to the heap, so nothing that
+ *  outlives the record can point into the arena.
+ **/
 class Awkccc_variable {
     public:
         static constexpr double epsilon_ = 1e-6;
-        jclib::jString string_;
+        /// Strings this long or shorter need no allocation
+        static constexpr size_t inline_size_ = 6;
         double number_;
-        Awkccc_data_type data_type_;
-        bool number_is_valid_;
-        bool string_is_valid_;
+
         Awkccc_variable()
-            : string_( jclib::jString::get_empty() )
-            , number_(0.0)
-            , data_type_( Uninitialised )
-            , number_is_valid_( true )
-            , string_is_valid_( true )
+            : number_( 0.0 )
+            , word_( flags( Uninitialised, true, true ) )
             {}
         Awkccc_variable( const Awkccc_variable &old )
-            : string_( old.string_ )
-            , number_( old.number_ )
-            , data_type_( old.data_type_ )
-            , number_is_valid_( old.number_is_valid_ )
-            , string_is_valid_( old.string_is_valid_ )
+            : number_( old.number_ )
+            , word_( old.word_ )
+            {
+                share();
+            }
+        /** Take the string without touching its reference count. A
+         *  temporary stays a temporary */
+        Awkccc_variable( Awkccc_variable && old ) noexcept
+            : number_( old.number_ )
+            , word_( old.word_ )
+            {
+                old.number_ = 0.0;
+                old.word_ = flags( Uninitialised, true, true );
+            }
+        Awkccc_variable( std::string_view string )
+            : number_( 0.0 )
+            , word_( flags( String, false, true ) )
+            {
+                store( string );
+            }
+        Awkccc_variable( const char * string )
+            : Awkccc_variable( std::string_view( string ) )
             {}
         Awkccc_variable( const jclib::jString & string )
-            : string_( string )
-            , data_type_( String )
-            , number_is_valid_( false )
-            , string_is_valid_( true )
+            : Awkccc_variable( std::string_view( (const char *) string, string.len() ) )
             {}
-        Awkccc_variable( double number )
-            : string_( jclib::jString::get_empty() )
-            , number_ (number )
-            , data_type_( Number )
-            , number_is_valid_( true )
-            , string_is_valid_( false )
+        template< typename Number, typename = std::enable_if_t<std::is_arithmetic_v<Number> > >
+        Awkccc_variable( Number number )
+            : number_( double( number ) )
+            , word_( flags( Awkccc_data_type::Number, true, false ) )
             {}
         /** Create a Numeric String */
+        Awkccc_variable( std::string_view string, double number )
+            : number_( number )
+            , word_( flags( Numeric_String, true, true ) )
+            {
+                store( string );
+            }
+        Awkccc_variable( const char * string, double number )
+            : Awkccc_variable( std::string_view( string ), number )
+            {}
         Awkccc_variable( const jclib::jString & string, double number )
-            : string_( string )
-            , number_ (number )
-            , data_type_( Numeric_String )
-            , number_is_valid_( true )
-            , string_is_valid_( true )
+            : Awkccc_variable( std::string_view( (const char *) string, string.len() ), number )
             {}
+        ~Awkccc_variable() {
+            release();
+        }
+
+        inline Awkccc_data_type data_type() const {
+            return Awkccc_data_type( ( word_ >> type_shift_ ) & 3 );
+        }
+        inline bool number_is_valid() const {
+            return ( word_ & number_valid_bit_ ) != 0;
+        }
+        inline bool string_is_valid() const {
+            return ( word_ & string_valid_bit_ ) != 0;
+        }
+        /** The string held, without converting a number. Only meaningful
+         *  if string_is_valid() */
+        inline std::string_view string_value() const {
+            if( word_ & heap_bit_ ) {
+                const heap_string * heap = heap_pointer();
+                return std::string_view( heap->text(), heap->size_ );
+            }
+            return std::string_view( reinterpret_cast<const char *>( &word_ ), ( word_ >> length_shift_ ) & 7 );
+        }
+
+        /** Do both hold the very same heap string, as copies of one value &
+         *  interned values do. A quick test for equal text: false doesn't
+         *  mean the texts differ */
+        inline bool same_text( const Awkccc_variable & other ) const {
+            constexpr uint64_t storage = pointer_mask_ | heap_bit_;
+            return ( word_ & heap_bit_ ) && ( word_ & storage ) == ( other.word_ & storage );
+        }
+
+        /** Does the string live in an Awkccc_arena */
+        inline bool is_temporary() const {
+            return ( word_ & arena_bit_ ) != 0;
+        }
+        /** Move a temporary's string to the heap, so it outlives the arena */
+        inline void promote() {
+            if( word_ & arena_bit_ )
+                store( string_value() );
+        }
+
+        /** A value read from input: a field, getline, split(), ARGV or
+         *  ENVIRON. It is a numeric string if it looks like a number, &
+         *  either way is only scanned this once */
+        static Awkccc_variable from_input( std::string_view text ) {
+            double number;
+            bool numeric = scan_number( text, number );
+            return from_input( text, number, numeric );
+        }
+        /** As above, for input already scanned */
+        static Awkccc_variable from_input( std::string_view text, double number, bool numeric ) {
+            if( numeric )
+                return Awkccc_variable( text, number );
+            Awkccc_variable answer( text );
+            answer.number_ = number;
+            answer.word_ |= number_valid_bit_;
+            return answer;
+        }
+        /** As above, for a temporary: a long text is copied into arena */
+        static Awkccc_variable from_input( std::string_view text, double number, bool numeric, Awkccc_arena & arena ) {
+            if( text.size() <= inline_size_ )
+                return from_input( text, number, numeric );
+            Awkccc_variable answer = filled( text.size(), [text]( char * out ) {
+                std::memcpy( out, text.data(), text.size() );
+            }, arena );
+            answer.number_ = number;
+            answer.word_ = ( answer.word_ & ~flag_mask_ ) | flags( numeric ? Numeric_String : String, true, true );
+            return answer;
+        }
         /** Ensure number_ is valid */
         Awkccc_variable & ensure_double() {
-            std::string_view sv( string_);
-            std::from_chars(sv.begin(), sv.end(), number_);
-            number_is_valid_ = true;
+            scan_number( string_value(), number_ );
+            word_ |= number_valid_bit_;
             return *this;
         }
         /** Get or create double value, may change this despite constness */
         inline operator double() const {
-            return number_is_valid_ ? number_ : const_cast<Awkccc_variable*>(this)->ensure_double().number_;
+            return number_is_valid() ? number_ : const_cast<Awkccc_variable*>(this)->ensure_double().number_;
         }
         /** Get or create double value, may change this */
         inline operator double() {
-            return number_is_valid_ ? number_ : ensure_double().number_;
+            return number_is_valid() ? number_ : ensure_double().number_;
         }
         /** Get or create long long value using operator double. Required for % operator */
         inline operator long long() const {
             return (long long)( double(*this));
         }
-        /** Get or create jString value.
-         *  FIXME 1 use OFMT / CONVFMT depending on context
-         *  FIXME 2 replace with <format> once C++20 in all target systems
-         *          test __cpp_lib_format
-         * */ 
+        /** Get or create jString value through CONVFMT. print formats
+         *  numbers itself through OFMT
+         * */
         jclib::jString format() {
-            if( string_is_valid_ )
-                return string_;
-            double intpart;
-            char buf[48];
-            if( std::fabs(std::modf(number_,&intpart)) < epsilon_ ){
-                std::snprintf(buf, 48, "%lld", (long long)number_);
-            } else {
-                std::snprintf(buf, 48, "%.6g", number_);
-            }
-            return buf;
+            if( string_is_valid() )
+                return make_jString( string_value() );
+            Awkccc_number_format::text buf;
+            std::string_view text = format_number( buf );
+            buf[text.size()] = 0;
+            return make_jString( text );
         }
         inline operator jclib::jString() const {
-            return string_is_valid_ ? string_ : const_cast<Awkccc_variable*>(this)->format();
+            return const_cast<Awkccc_variable*>(this)->format();
         }
         Awkccc_variable & operator = ( const Awkccc_variable &old ){
-            string_ = old.string_;
-            number_ = old.number_;
-            data_type_ = old.data_type_;
-            number_is_valid_ = old.number_is_valid_ ;
+            if( this != &old ) {
+                release();
+                number_ = old.number_;
+                word_ = old.word_;
+                share();
+            }
             return *this;
         }
+        Awkccc_variable & operator = ( Awkccc_variable &&old ) noexcept {
+            if( this != &old ) {
+                release();
+                number_ = old.number_;
+                word_ = old.word_;
+                old.number_ = 0.0;
+                old.word_ = flags( Uninitialised, true, true );
+                promote();
+            }
+            return *this;
+        }
+        /** The number as a string through CONVFMT, in buf */
+        inline std::string_view format_number( Awkccc_number_format::text & buf ) const {
+            return conversion_format().format( number_, buf );
+        }
+        /** The string value, converting a number into buf if need be */
+        inline std::string_view text( Awkccc_number_format::text & buf ) const {
+            return string_is_valid() ? string_value() : format_number( buf );
+        }
         
-        template< typename T > double operator + ( const T &&old ) const {
-            return double(*this) + double(old);
+        /** A string of size chars written by fill( char * ) straight into
+         *  the variable's own storage, so building it allocates at most once */
+        template< typename Fill >
+        static Awkccc_variable filled( size_t size, Fill fill ) {
+            Awkccc_variable answer;
+            answer.word_ = flags( String, false, true );
+            if( size <= inline_size_ ) {
+                char buf[inline_size_];
+                fill( buf );
+                answer.store( std::string_view( buf, size ) );
+                return answer;
+            }
+            void * memory = ::operator new( sizeof( heap_string ) + size + 1 );
+            heap_string * heap = new( memory ) heap_string{ { 1 }, size };
+            fill( heap->text() );
+            heap->text()[size] = 0;
+            answer.word_ |= pointer_bits( heap ) | heap_bit_;
+            return answer;
         }
-        template< typename T > double operator - ( const T &&old ) const {
-            return double(*this) - double(old) ;
+        /** As above, for a temporary: a long string is written into arena */
+        template< typename Fill >
+        static Awkccc_variable filled( size_t size, Fill fill, Awkccc_arena & arena ) {
+            if( size <= inline_size_ )
+                return filled( size, fill );
+            void * memory = arena.allocate( sizeof( heap_string ) + size + 1 );
+            heap_string * heap = new( memory ) heap_string{ { 0 }, size };
+            fill( heap->text() );
+            heap->text()[size] = 0;
+            Awkccc_variable answer;
+            answer.word_ = flags( String, false, true )
+                         | pointer_bits( heap ) | heap_bit_ | arena_bit_;
+            return answer;
         }
-        template< typename T > double operator * ( const T &&old ) const {
-            return double(*this) + double(old) ;
+
+        /** Assigning a number needs no conversion & no allocation */
+        template< typename Number, typename = std::enable_if_t<std::is_arithmetic_v<Number> > >
+        Awkccc_variable & operator = ( Number number ) {
+            release();
+            number_ = double( number );
+            word_ = flags( Awkccc_data_type::Number, true, false );
+            return *this;
         }
-        template< typename T > double operator / ( const T &&old ) const {
-            return double(*this) / double(old) ;
+        Awkccc_variable & operator += ( double right ) {
+            return *this = double( *this ) + right;
         }
-        /** Modulo operator %.
-         *  C++ standard requires that both operators are an integral type,
-         *  but we store numbers as double so we force the issue.
-         *  Datatype long long was chosen as it gives the greatest chance of 
-         *  a correct translation.
-         * */
-        template< typename T > long long operator % ( const T &&old ) const {
-            return ((long long) (*this)) % ((long long) (old)) ;
+        Awkccc_variable & operator -= ( double right ) {
+            return *this = double( *this ) - right;
+        }
+        Awkccc_variable & operator *= ( double right ) {
+            return *this = double( *this ) * right;
+        }
+        Awkccc_variable & operator /= ( double right ) {
+            return *this = double( *this ) / right;
         }
         // prefix operator ++x
-        long long operator ++() {
-            ensure_double();
-            string_is_valid_ = false;
+        double operator ++() {
+            if( ! number_is_valid() )
+                ensure_double();
+            drop_string();
             return ++number_;
         }
         // postfix operator x++
-        long long operator ++(int) {
-            ensure_double();
-            string_is_valid_ = false;
+        double operator ++(int) {
+            if( ! number_is_valid() )
+                ensure_double();
+            drop_string();
             return number_++;
         }
         // prefix operator --x
-        long long operator --() {
-            ensure_double();
-            string_is_valid_ = false;
+        double operator --() {
+            if( ! number_is_valid() )
+                ensure_double();
+            drop_string();
             return --number_;
         }
         // postfix operator x--
-        long long operator --(int) {
-            ensure_double();
-            string_is_valid_ = false;
-            return --number_;
+        double operator --(int) {
+            if( ! number_is_valid() )
+                ensure_double();
+            drop_string();
+            return number_--;
         }
         /** Comparison operators.
          * All comparisons are routed through the single compare() routine which returns negative, 0 or
@@ -193,7 +351,7 @@ class Awkccc_variable {
          * FIXME: Haven't yet implemented locale-specific collation as required by the standard
          */
         int compare( const Awkccc_variable &rhs ) const {
-            if( number_is_valid_ && rhs.number_is_valid_ ){
+            if( data_type() != String && rhs.data_type() != String ){
                 const double diff = number_ - rhs.number_;
                 return  ( fabs( diff ) < epsilon_ )
                         ? 0
@@ -201,8 +359,11 @@ class Awkccc_variable {
                             ? -1
                             : 1;
             }
-            jclib::jString lhss(*this),rhss(rhs);
-            return lhss.compare( rhss );
+            if( same_text( rhs ) && string_is_valid() && rhs.string_is_valid() )
+                return 0;
+            Awkccc_number_format::text lhs_buf, rhs_buf;
+            int answer = text( lhs_buf ).compare( rhs.text( rhs_buf ) );
+            return answer < 0 ? -1 : answer > 0 ? 1 : 0;
         }
         bool operator <( const Awkccc_variable &rhs ) const {
             return compare( rhs ) < 0;
@@ -222,23 +383,173 @@ class Awkccc_variable {
         bool operator !=( const Awkccc_variable &rhs ) const {
             return compare( rhs ) != 0;
         }
-    };
-    namespace {
-        template< typename T > inline double operator + ( const T &&left, const Awkccc_variable && right ) {
-            return double(left) + double(right);
+    private:
+        /// Long strings, shared between copies
+        struct heap_string {
+            std::atomic<uint32_t> references_;
+            size_t size_;
+            inline const char * text() const {
+                return reinterpret_cast<const char *>( this + 1 );
+            }
+            inline char * text() {
+                return reinterpret_cast<char *>( this + 1 );
+            }
+        };
+        static constexpr int length_shift_ = 48;
+        /// The heap_string is in an arena & isn't reference counted
+        static constexpr uint64_t arena_bit_ = uint64_t( 1 ) << 54;
+        static constexpr uint64_t heap_bit_ = uint64_t( 1 ) << 55;
+        static constexpr int type_shift_ = 56;
+        static constexpr uint64_t number_valid_bit_ = uint64_t( 1 ) << 58;
+        static constexpr uint64_t string_valid_bit_ = uint64_t( 1 ) << 59;
+        static constexpr uint64_t flag_mask_ = uint64_t( 0xFF ) << 56;
+        static constexpr uint64_t pointer_mask_ = ( uint64_t( 1 ) << 48 ) - 1;
+        static_assert( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "inline strings are the word's low bytes" );
+        static_assert( sizeof( void * ) == 8, "pointers share the word with the flags" );
+
+        /// Inline text or heap pointer in the low 6 bytes, inline length,
+        /// arena_bit_ & heap_bit_ in byte 6, data type & validity in byte 7
+        uint64_t word_;
+
+        static constexpr uint64_t flags( Awkccc_data_type type, bool number_valid, bool string_valid ) {
+            return ( uint64_t( type ) << type_shift_ )
+                 | ( number_valid ? number_valid_bit_ : 0 )
+                 | ( string_valid ? string_valid_bit_ : 0 );
         }
-        template< typename T > inline double operator - ( const T &&left, const Awkccc_variable && right ) {
-            return double(left) - double(right) ;
+        inline heap_string * heap_pointer() const {
+            return reinterpret_cast<heap_string *>( word_ & pointer_mask_ );
         }
-        template< typename T > inline double operator * ( const T &&left, const Awkccc_variable && right ) {
-            return double(left) + double(right) ;
+        /** heap as it goes in the word. A pointer with bits above the 48
+         *  the flags leave, as with 5-level paging or tagged pointers,
+         *  would be cut short, so the program stops, in release builds too */
+        static inline uint64_t pointer_bits( const heap_string * heap ) {
+            uint64_t bits = reinterpret_cast<uintptr_t>( heap );
+            if( ( bits & ~pointer_mask_ ) != 0 ) {
+                std::fputs( "awkccc: heap pointer doesn't fit in 48 bits\n", stderr );
+                std::abort();
+            }
+            return bits;
         }
-        template< typename T > inline double operator / ( const T &&left, const Awkccc_variable && right ) {
-            return double(left) - double(right) ;
+        static jclib::jString make_jString( std::string_view text ) {
+            // jString wants a terminated string. Heap & formatted text have
+            // one, inline text doesn't
+            if( text.size() <= inline_size_ ) {
+                char buf[inline_size_ + 1];
+                std::memcpy( buf, text.data(), text.size() );
+                buf[text.size()] = 0;
+                return jclib::jString( buf );
+            }
+            return jclib::jString( text.data() );
+        }
+        /** Put text in an empty word, keeping the flags */
+        void store( std::string_view text ) {
+            word_ &= flag_mask_;
+            if( text.size() <= inline_size_ ) {
+                uint64_t chars = 0;
+                std::memcpy( &chars, text.data(), text.size() );
+                word_ |= chars | ( uint64_t( text.size() ) << length_shift_ );
+                return;
+            }
+            void * memory = ::operator new( sizeof( heap_string ) + text.size() + 1 );
+            heap_string * heap = new( memory ) heap_string{ { 1 }, text.size() };
+            std::memcpy( heap->text(), text.data(), text.size() );
+            heap->text()[text.size()] = 0;
+            word_ |= pointer_bits( heap ) | heap_bit_;
+        }
+        /** A copy has been made of the word: count it, or give the copy a
+         *  heap string of its own if the text is in an arena */
+        inline void share() {
+            if( word_ & arena_bit_ )
+                promote();
+            else if( word_ & heap_bit_ )
+                heap_pointer()->references_.fetch_add( 1, std::memory_order_relaxed );
         }
-        template< typename T > inline long long operator % ( const T &&left, const Awkccc_variable && right ) {
-            return (long long) (left) % (long long) (right) ;
+        inline void release() {
+            if( ( word_ & ( heap_bit_ | arena_bit_ ) ) == heap_bit_
+                && heap_pointer()->references_.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+                heap_string * heap = heap_pointer();
+                heap->~heap_string();
+                ::operator delete( heap );
+            }
+        }
+        /** The number has changed: the string no longer matches it */
+        inline void drop_string() {
+            release();
+            word_ = flags( Awkccc_data_type::Number, true, false );
         }
+    };
+    /** Arithmetic on variables. Operands bind by const reference, so named
+     *  variables & temporaries are treated alike, & results are plain
+     *  doubles: a chain like a + b * c - d builds no intermediate variable,
+     *  copies no string & never allocates.
+     *  % truncates to long long, as C++ requires integral operands.
+     */
+    template< typename Number >
+    using Awkccc_if_number = std::enable_if_t<std::is_arithmetic_v<Number>, double>;
+
+    inline double operator + ( const Awkccc_variable & left, const Awkccc_variable & right ) {
+        return double( left ) + double( right );
+    }
+    template< typename Number > inline Awkccc_if_number<Number> operator + ( const Awkccc_variable & left, Number right ) {
+        return double( left ) + double( right );
+    }
+    template< typename Number > inline Awkccc_if_number<Number> operator + ( Number left, const Awkccc_variable & right ) {
+        return double( left ) + double( right );
+    }
+    inline double operator - ( const Awkccc_variable & left, const Awkccc_variable & right ) {
+        return double( left ) - double( right );
+    }
+    template< typename Number > inline Awkccc_if_number<Number> operator - ( const Awkccc_variable & left, Number right ) {
+        return double( left ) - double( right );
+    }
+    template< typename Number > inline Awkccc_if_number<Number> operator - ( Number left, const Awkccc_variable & right ) {
+        return double( left ) - double( right );
+    }
+    inline double operator * ( const Awkccc_variable & left, const Awkccc_variable & right ) {
+        return double( left ) * double( right );
+    }
+    template< typename Number > inline Awkccc_if_number<Number> operator * ( const Awkccc_variable & left, Number right ) {
+        return double( left ) * double( right );
+    }
+    template< typename Number > inline Awkccc_if_number<Number> operator * ( Number left, const Awkccc_variable & right ) {
+        return double( left ) * double( right );
+    }
+    inline double operator / ( const Awkccc_variable & left, const Awkccc_variable & right ) {
+        return double( left ) / double( right );
+    }
+    template< typename Number > inline Awkccc_if_number<Number> operator / ( const Awkccc_variable & left, Number right ) {
+        return double( left ) / double( right );
+    }
+    template< typename Number > inline Awkccc_if_number<Number> operator / ( Number left, const Awkccc_variable & right ) {
+        return double( left ) / double( right );
+    }
+    inline long long operator % ( const Awkccc_variable & left, const Awkccc_variable & right ) {
+        return (long long) double( left ) % (long long) double( right );
+    }
+    template< typename Number > inline std::enable_if_t<std::is_arithmetic_v<Number>, long long>
+    operator % ( const Awkccc_variable & left, Number right ) {
+        return (long long) double( left ) % (long long) right;
+    }
+    template< typename Number > inline std::enable_if_t<std::is_arithmetic_v<Number>, long long>
+    operator % ( Number left, const Awkccc_variable & right ) {
+        return (long long) left % (long long) double( right );
+    }
+    inline double operator - ( const Awkccc_variable & operand ) {
+        return - double( operand );
+    }
+
+    /** Any value as the text awk would use for it in a string context:
+     *  numbers through CONVFMT into buf, strings as they are */
+    template< typename Value >
+    inline std::string_view as_text( const Value & value, Awkccc_number_format::text & buf ) {
+        if constexpr( std::is_arithmetic_v<Value> )
+            return conversion_format().format( double( value ), buf );
+        else if constexpr( std::is_same_v<Value, Awkccc_variable> )
+            return value.text( buf );
+        else if constexpr( std::is_same_v<Value, jclib::jString> )
+            return std::string_view( (const char *) value, value.len() );
+        else
+            return std::string_view( value );
     }
 }
 #endif
@@ -0,0 +1,1395 @@
+/***
+**
+** AWKCCC Analysis passes over the AST
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include "../include/jString.hpp"
+#include "../include/Save.hpp"
+#include "../include/awkccc_analysis.h++"
+using namespace jclib;
+
+namespace awkccc {
+    // Base node
+    void ast_walker::visit_ast_node( ast_node * node ){
+        walk_children( node );
+        walk_siblings( node );
+    }
+    // Empty node
+    void ast_walker::visit_ast_empty_node( ast_empty_node * node ){
+        visit_ast_node( node );
+    }
+    // Statement node
+    void ast_walker::visit_ast_statement_node( ast_statement_node * node ){
+        visit_ast_node( node );
+    }
+    // Generic operator node
+    void ast_walker::visit_ast_op_node( ast_op_node * node ){
+        visit_ast_node( node );
+    }
+    // Left Unary operator (e.g -x, ++y) node
+    void ast_walker::visit_ast_left_unary_op_node( ast_left_unary_op_node * node ){
+        visit_ast_op_node( node );
+    }
+    // Right Unary operator (e.g x--) node
+    void ast_walker::visit_ast_right_unary_op_node( ast_right_unary_op_node * node ){
+        visit_ast_op_node( node );
+    }
+    // Binary operator (e.g. a += b) node
+    void ast_walker::visit_ast_bin_op_node( ast_bin_op_node * node ){
+        visit_ast_op_node( node );
+    }
+    // Function node
+    void ast_walker::visit_ast_function_node( ast_function_node * node ){
+        walk( node->parameters_ );
+        walk( node->body_ );
+        visit_ast_node( node );
+    }
+    // Branch Loop node
+    void ast_walker::visit_ast_branch_loop_node( ast_branch_loop_node * node ){
+        walk( node->question_ );
+        walk( node->if_true_ );
+        walk( node->if_false_ );
+        visit_ast_node( node );
+    }
+    // For Loop node
+    void ast_walker::visit_ast_for_loop_node( ast_for_loop_node * node ){
+        walk( node->initialise_ );
+        walk( node->question_ );
+        walk( node->increment_ );
+        walk( node->loop_body_ );
+        visit_ast_node( node );
+    }
+    // ternary op (xx?yy:zz) node
+    void ast_walker::visit_ast_ternary_op_node( ast_ternary_op_node * node ){
+        walk( node->question_ );
+        walk( node->if_true_ );
+        walk( node->if_false_ );
+        visit_ast_node( node );
+    }
+
+    bool is_operator( ast_node * node, const char * op ) {
+        return node != nullptr && node->name_ == op;
+    }
+
+    bool is_number_constant( ast_node * node, double & value ) {
+        if( node == nullptr || ! node->child_nodes_.empty() )
+            return false;
+        const char * text = (const char *) node->name_;
+        if( ! std::isdigit( (unsigned char) text[0] ) && text[0] != '.' )
+            return false;
+        char * end;
+        value = std::strtod( text, &end );
+        return *end == '\0';
+    }
+
+    /**
+     * Tells apart the kinds of node where the analysis needs to, without
+     * adding anything to the node classes.
+    */
+    class node_shape: public ast_node_visitor {
+        public:
+            ast_node * op_ = nullptr;
+            ast_ternary_op_node * ternary_ = nullptr;
+            ast_function_node * function_ = nullptr;
+            bool is_token_ = false;
+            /// op_ is a two operand operator, rather than n-ary
+            bool binary_ = false;
+            bool has_dependants_ = false;
+            void visit_ast_node( ast_node * node ){
+                is_token_ = true;
+            }
+            void visit_ast_empty_node( ast_empty_node * node ){}
+            void visit_ast_statement_node( ast_statement_node * node ){}
+            void visit_ast_op_node( ast_op_node * node ){
+                op_ = node->op_node_;
+            }
+            void visit_ast_left_unary_op_node( ast_left_unary_op_node * node ){
+                op_ = node->op_node_;
+            }
+            void visit_ast_right_unary_op_node( ast_right_unary_op_node * node ){
+                op_ = node->op_node_;
+            }
+            void visit_ast_bin_op_node( ast_bin_op_node * node ){
+                op_ = node->op_node_;
+                binary_ = true;
+            }
+            void visit_ast_function_node( ast_function_node * node ){
+                function_ = node;
+                has_dependants_ = true;
+            }
+            void visit_ast_branch_loop_node( ast_branch_loop_node * node ){
+                has_dependants_ = true;
+            }
+            void visit_ast_for_loop_node( ast_for_loop_node * node ){
+                has_dependants_ = true;
+            }
+            void visit_ast_ternary_op_node( ast_ternary_op_node * node ){
+                op_ = node->op_node_;
+                ternary_ = node;
+                has_dependants_ = true;
+            }
+    };
+
+    static node_shape shape_of( ast_node * node ) {
+        node_shape shape;
+        if( node != nullptr )
+            node->accept( &shape );
+        return shape;
+    }
+
+    ast_node * operator_of( ast_node * node ) {
+        return shape_of( node ).op_;
+    }
+
+    bool same_expression( ast_node * left, ast_node * right ) {
+        if( left == nullptr || right == nullptr )
+            return left == right;
+        node_shape left_shape = shape_of( left );
+        node_shape right_shape = shape_of( right );
+        if( left_shape.has_dependants_ || right_shape.has_dependants_
+         || left_shape.is_token_ != right_shape.is_token_
+         || ( left_shape.op_ == nullptr ) != ( right_shape.op_ == nullptr ) )
+            return false;
+        if( left_shape.op_ != nullptr ? ! ( left_shape.op_->name_ == right_shape.op_->name_ )
+                                      : ! ( left->name_ == right->name_ ) )
+            return false;
+        if( left->child_nodes_.size() != right->child_nodes_.size()
+         || left->sibling_nodes_.size() != right->sibling_nodes_.size() )
+            return false;
+        for( size_t i = 0; i < left->child_nodes_.size(); ++i )
+            if( ! same_expression( left->child_nodes_[i], right->child_nodes_[i] ) )
+                return false;
+        for( size_t i = 0; i < left->sibling_nodes_.size(); ++i )
+            if( ! same_expression( left->sibling_nodes_[i], right->sibling_nodes_[i] ) )
+                return false;
+        return true;
+    }
+
+    /**
+     * Works bottom up, so by the time a @@@ pair is reached its operands
+     * have already become n-ary nodes whose pieces it can take over.
+    */
+    class concatenation_flattener: public ast_node_visitor {
+        public:
+            void replace( ast_node_ptr & slot ) {
+                if( ! slot.isset() )
+                    return;
+                slot->accept( this );
+                if( is_pair( slot ) )
+                    slot = flatten( slot );
+            }
+            void replace_all( ast_node * node ) {
+                for( auto & child : node->child_nodes_ )
+                    replace( child );
+                for( auto & sibling : node->sibling_nodes_ )
+                    replace( sibling );
+            }
+            static bool is_getline( ast_node * node ) {
+                return node != nullptr && node->has_sym_ && node->sym_->type_ == STATEMENT
+                    && node->name_ == "getline";
+            }
+            /// A @@@ with just its two operands that isn't getline var or cmd | getline var
+            static bool is_pair( ast_node * node ) {
+                node_shape shape = shape_of( node );
+                if( ! shape.binary_ || ! is_operator( shape.op_, "@@@" ) || node->child_nodes_.size() != 2 )
+                    return false;
+                ast_node * left = node->child_nodes_[0];
+                return ! is_getline( left )
+                    && ! ( is_operator( operator_of( left ), "|" ) && left->child_nodes_.size() == 2
+                        && is_getline( left->child_nodes_[1] ) );
+            }
+            /// An n-ary concatenation, already flattened, that may be merged into its parent
+            static ast_node * pieces_of( ast_node * node ) {
+                while( node->sibling_nodes_.empty() && node->child_nodes_.size() == 1
+                    && is_operator( operator_of( node ), "(" ) )
+                    node = node->child_nodes_[0];
+                node_shape shape = shape_of( node );
+                if( shape.binary_ || ! is_operator( shape.op_, "@@@" ) || ! node->sibling_nodes_.empty() )
+                    return nullptr;
+                return node;
+            }
+            ast_node_ptr flatten( ast_node * pair ) {
+                ast_op_node * answer = new ast_op_node( operator_of( pair ), Expression, "CONCATENATION", pair->rule_nr_ );
+                answer->extra_children_allowed_ = false;
+                for( auto & operand : pair->child_nodes_ ) {
+                    if( ast_node * inner = pieces_of( operand ) )
+                        for( auto & piece : inner->child_nodes_ )
+                            answer->add_child( piece );
+                    else
+                        answer->add_child( operand );
+                }
+                answer->sibling_nodes_ = pair->sibling_nodes_;
+                return answer;
+            }
+
+            void visit_ast_node( ast_node * node ){
+                replace_all( node );
+            }
+            void visit_ast_empty_node( ast_empty_node * node ){
+                replace_all( node );
+            }
+            void visit_ast_statement_node( ast_statement_node * node ){
+                replace_all( node );
+            }
+            void visit_ast_op_node( ast_op_node * node ){
+                replace_all( node );
+            }
+            void visit_ast_left_unary_op_node( ast_left_unary_op_node * node ){
+                replace_all( node );
+            }
+            void visit_ast_right_unary_op_node( ast_right_unary_op_node * node ){
+                replace_all( node );
+            }
+            void visit_ast_bin_op_node( ast_bin_op_node * node ){
+                replace_all( node );
+            }
+            void visit_ast_function_node( ast_function_node * node ){
+                replace( node->body_ );
+                replace_all( node );
+            }
+            void visit_ast_branch_loop_node( ast_branch_loop_node * node ){
+                replace( node->question_ );
+                replace( node->if_true_ );
+                replace( node->if_false_ );
+                replace_all( node );
+            }
+            void visit_ast_for_loop_node( ast_for_loop_node * node ){
+                replace( node->initialise_ );
+                replace( node->question_ );
+                replace( node->increment_ );
+                replace( node->loop_body_ );
+                replace_all( node );
+            }
+            void visit_ast_ternary_op_node( ast_ternary_op_node * node ){
+                replace( node->question_ );
+                replace( node->if_true_ );
+                replace( node->if_false_ );
+                replace_all( node );
+            }
+    };
+
+    void flatten_concatenations( ast_node * root ) {
+        concatenation_flattener flattener;
+        if( root != nullptr )
+            root->accept( &flattener );
+    }
+
+    /**
+     * Records each $ operator & NF reference.
+     * '$' reaches the AST as a left unary operator whose only child is
+     * the dollar_index: a NUMBER, an lvalue or a parenthesised expr.
+    */
+    class field_usage_finder: public ast_walker {
+        public:
+            Awkccc_field_usage usage_;
+            field_usage_finder() {
+                usage_.max_field_ = 0;
+                usage_.uses_nf_ = false;
+                usage_.dynamic_field_ = false;
+            }
+            void visit_ast_node( ast_node * node ){
+                if( node->has_sym_ && node->sym_->type_ == VARIABLE && node->sym_->awk_name_ == "NF" )
+                    usage_.uses_nf_ = true;
+                ast_walker::visit_ast_node( node );
+            }
+            void visit_ast_left_unary_op_node( ast_left_unary_op_node * node ){
+                if( is_operator( node->op_node_, "$" ) && ! node->child_nodes_.empty() ) {
+                    double index;
+                    if( is_number_constant( node->child_nodes_[0], index ) ) {
+                        if( index > usage_.max_field_ )
+                            usage_.max_field_ = int( index );
+                    } else {
+                        usage_.dynamic_field_ = true;
+                    }
+                }
+                ast_walker::visit_ast_left_unary_op_node( node );
+            }
+    };
+
+    Awkccc_field_usage analyse_field_usage( ast_node * root ) {
+        field_usage_finder finder;
+        finder.walk( root );
+        return finder.usage_;
+    }
+
+    bool is_ere_literal( ast_node * node ) {
+        return node != nullptr && node->has_sym_ && node->sym_->type_ == REGEX
+            && shape_of( node ).is_token_;
+    }
+
+    std::string_view ere_text( ast_node * node ) {
+        std::string_view text( (const char *) node->name_, node->name_.len() );
+        if( ! text.empty() && text.front() == '/' )
+            text.remove_prefix( 1 );
+        if( ! text.empty() && text.back() == '/' )
+            text.remove_suffix( 1 );
+        return text;
+    }
+
+    /**
+     * Collects each ERE token. A pattern's action hangs off its ERE as
+     * children, so the walk carries on below them.
+    */
+    class ere_literal_finder: public ast_walker {
+        public:
+            std::vector<std::string> found_;
+            void visit_ast_node( ast_node * node ){
+                if( is_ere_literal( node ) ) {
+                    std::string text( ere_text( node ) );
+                    bool seen = false;
+                    for( auto & previous : found_ )
+                        seen = seen || previous == text;
+                    if( ! seen )
+                        found_.push_back( text );
+                }
+                ast_walker::visit_ast_node( node );
+            }
+    };
+
+    std::vector<std::string> find_ere_literals( ast_node * root ) {
+        ere_literal_finder finder;
+        finder.walk( root );
+        return finder.found_;
+    }
+
+    class variable_finder: public ast_walker {
+        public:
+            const char * name_;
+            bool found_ = false;
+            void visit_ast_node( ast_node * node ){
+                if( node->has_sym_ && node->sym_->type_ == VARIABLE && node->sym_->awk_name_ == name_ )
+                    found_ = true;
+                ast_walker::visit_ast_node( node );
+            }
+    };
+
+    bool uses_variable( ast_node * root, const char * name ) {
+        variable_finder finder;
+        finder.name_ = name;
+        finder.walk( root );
+        return finder.found_;
+    }
+
+    /// The variable a token names, nullptr if it isn't a variable
+    static Symbol * variable_of( ast_node * node ) {
+        if( node == nullptr || ! node->has_sym_ || node->sym_->type_ != VARIABLE
+         || ! shape_of( node ).is_token_ )
+            return nullptr;
+        return node->sym_;
+    }
+
+    static ast_node * strip_parentheses( ast_node * node ) {
+        while( node != nullptr && node->child_nodes_.size() == 1
+            && is_operator( operator_of( node ), "(" ) )
+            node = node->child_nodes_[0];
+        return node;
+    }
+
+    /**
+     * Looks for a field kept beyond its record: the one subscript of an
+     * array reference, as in count[$1], or the value of an assignment, as
+     * in last = $3. Subscript lists are joined into a new key, so a[$1,$2]
+     * keeps neither field.
+    */
+    class kept_field_finder: public ast_walker {
+        public:
+            bool found_ = false;
+            void visit_ast_bin_op_node( ast_bin_op_node * node ){
+                auto & operands = node->child_nodes_;
+                if( operands.size() == 2
+                 && ( is_operator( node->op_node_, "[" ) || is_operator( node->op_node_, "=" ) )
+                 && is_operator( operator_of( strip_parentheses( operands[1] ) ), "$" ) )
+                    found_ = true;
+                ast_walker::visit_ast_bin_op_node( node );
+            }
+    };
+
+    bool keeps_fields( ast_node * root ) {
+        kept_field_finder finder;
+        finder.walk( root );
+        return finder.found_;
+    }
+
+    static bool is_output_redirection( ast_node * node ) {
+        return ! node->child_nodes_.empty() && shape_of( node ).is_token_
+            && ( node->name_ == ">" || node->name_ == ">>" || node->name_ == "|" );
+    }
+
+    /**
+     * Follows every variable the main rules touch, in the order they are
+     * evaluated, to see whether records can be processed independently.
+     * Nodes that carry a pattern's action as extra children (beyond the
+     * operator's operands) & the bodies of branches & loops are conditional:
+     * an assignment there may not happen for every record.
+    */
+    class parallel_plan_finder: public ast_walker {
+        public:
+            struct variable_use {
+                jString name_;
+                jString c_name_;
+                bool is_array_ = false;
+                bool seen_ = false;
+                bool read_ = false;
+                bool written_ = false;
+                /// Assigned for every record before anything reads it
+                bool written_first_ = false;
+                bool mixed_ = false;
+                Awkccc_reduction reduction_ = Reduce_Last;
+            };
+            std::vector<variable_use> uses_;
+            std::map<Symbol *, size_t> index_;
+            bool in_main_ = true;
+            int conditional_ = 0;
+            bool after_next_ = false;
+            /// A main rule prints to standard output
+            bool prints_ = false;
+            jString reason_;
+
+            void refuse( const jString & why ) {
+                if( reason_.len() == 0 )
+                    reason_ = why;
+            }
+            variable_use & use_of( Symbol * sym ) {
+                auto found = index_.find( sym );
+                if( found != index_.end() )
+                    return uses_[found->second];
+                index_[sym] = uses_.size();
+                uses_.push_back( variable_use() );
+                uses_.back().name_ = sym->awk_name_;
+                uses_.back().c_name_ = sym->c_name_;
+                return uses_.back();
+            }
+            /// The variable an lvalue assigns: NAME or NAME[...], nullptr for $n
+            Symbol * target_of( ast_node * lvalue, bool & is_array ) {
+                is_array = false;
+                if( Symbol * sym = variable_of( lvalue ) )
+                    return sym;
+                if( is_operator( operator_of( lvalue ), "[" ) && ! lvalue->child_nodes_.empty() ) {
+                    is_array = true;
+                    return variable_of( lvalue->child_nodes_[0] );
+                }
+                return nullptr;
+            }
+            static bool mentions( ast_node * node, Symbol * sym ) {
+                if( node == nullptr )
+                    return false;
+                if( node->has_sym_ && node->sym_ == sym )
+                    return true;
+                for( auto child : node->child_nodes_ )
+                    if( mentions( child, sym ) )
+                        return true;
+                for( auto sibling : node->sibling_nodes_ )
+                    if( mentions( sibling, sym ) )
+                        return true;
+                return false;
+            }
+
+            void note_read( Symbol * sym, bool is_array ) {
+                if( ! in_main_ || sym == nullptr )
+                    return;
+                if( sym->is_built_in_ ) {
+                    if( sym->awk_name_ == "NR" || sym->awk_name_ == "FNR" )
+                        refuse( "NR or FNR is used by a main rule" );
+                    return;
+                }
+                variable_use & use = use_of( sym );
+                use.seen_ = true;
+                use.read_ = true;
+                use.is_array_ = use.is_array_ || is_array;
+            }
+            void note_write( Symbol * sym, bool is_array, Awkccc_reduction reduction ) {
+                if( ! in_main_ || sym == nullptr )
+                    return;
+                if( sym->is_built_in_ ) {
+                    if( ! ( sym->awk_name_ == "NF" ) )
+                        refuse( jString( "a main rule assigns to " ) + sym->awk_name_ );
+                    return;
+                }
+                variable_use & use = use_of( sym );
+                if( ! use.seen_ ) {
+                    use.seen_ = true;
+                    use.written_first_ = reduction == Reduce_Last && ! is_array
+                                      && conditional_ == 0 && ! after_next_;
+                }
+                use.is_array_ = use.is_array_ || is_array;
+                if( use.written_ && use.reduction_ != reduction )
+                    use.mixed_ = true;
+                use.written_ = true;
+                use.reduction_ = reduction;
+            }
+            /// Walk the parts of an lvalue that are evaluated, then record the write
+            void assign( ast_node * lvalue, Awkccc_reduction reduction ) {
+                bool is_array;
+                Symbol * sym = target_of( lvalue, is_array );
+                if( is_array ) {
+                    for( size_t i = 1; i < lvalue->child_nodes_.size(); ++i )
+                        walk( lvalue->child_nodes_[i] );
+                } else if( sym == nullptr ) {
+                    walk( lvalue );
+                }
+                note_write( sym, is_array, reduction );
+            }
+            /// Children beyond an operator's operands are a pattern's action
+            void walk_action( ast_node * node, size_t operands ) {
+                ++conditional_;
+                for( size_t i = operands; i < node->child_nodes_.size(); ++i )
+                    walk( node->child_nodes_[i] );
+                --conditional_;
+            }
+            /** Is question a comparison of value with target, as in value > target?
+             *  If so reduction is set to the reduction assigning value achieves */
+            bool compares( ast_node * question, ast_node * target, ast_node * value, Awkccc_reduction & reduction ) {
+                question = strip_parentheses( question );
+                ast_node * op = operator_of( question );
+                if( op == nullptr || question->child_nodes_.size() != 2 || ! question->sibling_nodes_.empty() )
+                    return false;
+                const bool greater = is_operator( op, ">" ) || is_operator( op, ">=" );
+                const bool less = is_operator( op, "<" ) || is_operator( op, "<=" );
+                if( ! greater && ! less )
+                    return false;
+                ast_node * left = question->child_nodes_[0];
+                ast_node * right = question->child_nodes_[1];
+                if( same_expression( left, value ) && same_expression( right, target ) )
+                    reduction = greater ? Reduce_Max : Reduce_Min;
+                else if( same_expression( left, target ) && same_expression( right, value ) )
+                    reduction = greater ? Reduce_Min : Reduce_Max;
+                else
+                    return false;
+                bool is_array;
+                Symbol * sym = target_of( target, is_array );
+                return sym != nullptr && ! mentions( value, sym );
+            }
+
+            void visit_ast_node( ast_node * node ){
+                if( node->type_ == Pattern ) {
+                    if( node->name_ == "BEGIN" || node->name_ == "END" ) {
+                        auto save_in_main = Save( in_main_ );
+                        in_main_ = false;
+                        walk_children( node );
+                    } else {
+                        if( node->name_ == "BEGINFILE" || node->name_ == "ENDFILE" )
+                            refuse( "BEGINFILE & ENDFILE rules run per input file" );
+                        walk_children( node );
+                    }
+                    walk_siblings( node );
+                    return;
+                }
+                if( ! in_main_ ) {
+                    ast_walker::visit_ast_node( node );
+                    return;
+                }
+                if( node->has_sym_ && node->sym_->type_ == STATEMENT ) {
+                    if( node->name_ == "print" || node->name_ == "printf" ) {
+                        // The items & any output_redirection are all children
+                        // once the tree is cleaned; the redirection is a >, >>
+                        // or | token carrying its target
+                        for( auto child : node->child_nodes_ )
+                            if( is_output_redirection( child ) )
+                                refuse( "redirected output from a main rule" );
+                        prints_ = true;
+                    } else if( node->name_ == "getline" )
+                        refuse( "getline in a main rule" );
+                    else if( node->name_ == "delete" )
+                        refuse( "delete in a main rule" );
+                    else if( node->name_ == "for" && node->child_nodes_.size() >= 3 ) {
+                        // for( name in array ) body
+                        ++conditional_;
+                        note_read( variable_of( node->child_nodes_[1] ), true );
+                        assign( node->child_nodes_[0], Reduce_Last );
+                        for( size_t i = 2; i < node->child_nodes_.size(); ++i )
+                            walk( node->child_nodes_[i] );
+                        --conditional_;
+                        walk_siblings( node );
+                        return;
+                    }
+                    ast_walker::visit_ast_node( node );
+                    return;
+                }
+                note_read( variable_of( node ), false );
+                walk_action( node, 0 );
+                walk_siblings( node );
+            }
+            void visit_ast_empty_node( ast_empty_node * node ){
+                if( in_main_ && node->name_ == "print_record" )
+                    prints_ = true;
+                if( in_main_ && node->name_ == "range_pattern" )
+                    refuse( "range patterns depend on earlier records" );
+                ast_walker::visit_ast_node( node );
+            }
+            void visit_ast_statement_node( ast_statement_node * node ){
+                if( in_main_ ) {
+                    if( is_operator( node->kw_node_, "exit" ) || is_operator( node->kw_node_, "nextfile" ) )
+                        refuse( jString( node->kw_node_->name_ ) + " in a main rule" );
+                    else if( is_operator( node->kw_node_, "next" ) )
+                        after_next_ = true;
+                }
+                ast_walker::visit_ast_node( node );
+            }
+            void visit_ast_op_node( ast_op_node * node ){
+                // a b c d once flattened: every child is an operand
+                walk_children( node );
+                walk_siblings( node );
+            }
+            void visit_ast_left_unary_op_node( ast_left_unary_op_node * node ){
+                visit_unary( node, node->op_node_ );
+            }
+            void visit_ast_right_unary_op_node( ast_right_unary_op_node * node ){
+                visit_unary( node, node->op_node_ );
+            }
+            void visit_unary( ast_node * node, ast_node * op ){
+                if( ! node->child_nodes_.empty() ) {
+                    if( is_operator( op, "++" ) || is_operator( op, "--" ) )
+                        assign( node->child_nodes_[0], Reduce_Sum );
+                    else
+                        walk( node->child_nodes_[0] );
+                }
+                walk_action( node, 1 );
+                walk_siblings( node );
+            }
+            void visit_ast_bin_op_node( ast_bin_op_node * node ){
+                auto & operands = node->child_nodes_;
+                ast_node * op = node->op_node_;
+                if( operands.size() < 2 ) {
+                    ast_walker::visit_ast_node( node );
+                    return;
+                }
+                size_t arity = 2;
+                if( is_operator( op, "=" ) ) {
+                    Awkccc_reduction reduction = Reduce_Last;
+                    node_shape value = shape_of( strip_parentheses( operands[1] ) );
+                    if( value.ternary_ != nullptr
+                     && same_expression( value.ternary_->if_false_, operands[0] )
+                     && compares( value.ternary_->question_, operands[0], value.ternary_->if_true_, reduction ) ) {
+                        // x = ( e > x ) ? e : x
+                        walk( value.ternary_->if_true_ );
+                    } else {
+                        walk( operands[1] );
+                    }
+                    assign( operands[0], reduction );
+                } else if( is_operator( op, "+=" ) || is_operator( op, "-=" ) ) {
+                    walk( operands[1] );
+                    assign( operands[0], Reduce_Sum );
+                } else if( is_operator( op, "*=" ) || is_operator( op, "/=" )
+                        || is_operator( op, "%=" ) || is_operator( op, "^=" ) ) {
+                    walk( operands[1] );
+                    walk( operands[0] );
+                    assign( operands[0], Reduce_Last );
+                } else if( is_operator( op, "(" ) ) {
+                    visit_call( node );
+                    arity = operands.size();
+                } else if( is_operator( op, "&&" ) || is_operator( op, "||" ) ) {
+                    walk( operands[0] );
+                    ++conditional_;
+                    walk( operands[1] );
+                    --conditional_;
+                } else if( is_operator( op, "in" ) ) {
+                    walk( operands[0] );
+                    note_read( variable_of( operands[1] ), true );
+                } else if( is_operator( op, "[" ) ) {
+                    note_read( variable_of( operands[0] ), true );
+                    walk( operands[1] );
+                } else {
+                    walk( operands[0] );
+                    walk( operands[1] );
+                }
+                walk_action( node, arity );
+                walk_siblings( node );
+            }
+            /// name( args ). The arguments are the operands after the name
+            void visit_call( ast_node * node ){
+                ast_node * function = node->child_nodes_[0];
+                std::vector<ast_node *> args;
+                for( size_t i = 1; i < node->child_nodes_.size(); ++i ) {
+                    args.push_back( node->child_nodes_[i] );
+                    for( auto sibling : node->child_nodes_[i]->sibling_nodes_ )
+                        args.push_back( sibling );
+                }
+                if( in_main_ && function->has_sym_ ) {
+                    const jString & name = function->sym_->awk_name_;
+                    if( ! function->sym_->is_built_in_ )
+                        refuse( jString( "a main rule calls " ) + name + "()" );
+                    else if( name == "rand" || name == "srand" || name == "system"
+                          || name == "close" || name == "split" )
+                        refuse( jString( name ) + "() in a main rule" );
+                }
+                for( size_t i = 1; i < node->child_nodes_.size(); ++i )
+                    walk( node->child_nodes_[i] );
+                if( function->has_sym_ && args.size() >= 3
+                 && ( function->sym_->awk_name_ == "sub" || function->sym_->awk_name_ == "gsub" ) )
+                    assign( args[2], Reduce_Last );
+            }
+            void visit_ast_branch_loop_node( ast_branch_loop_node * node ){
+                ast_node * body = node->if_true_;
+                Awkccc_reduction reduction;
+                if( node->type_ == If && node->if_false_ == nullptr && body != nullptr
+                 && body->sibling_nodes_.empty() && body->child_nodes_.size() == 2
+                 && is_operator( operator_of( body ), "=" )
+                 && compares( node->question_, body->child_nodes_[0], body->child_nodes_[1], reduction ) ) {
+                    // if( e > x ) x = e
+                    walk( body->child_nodes_[1] );
+                    assign( body->child_nodes_[0], reduction );
+                } else {
+                    walk( node->question_ );
+                    ++conditional_;
+                    walk( node->if_true_ );
+                    walk( node->if_false_ );
+                    --conditional_;
+                }
+                walk_siblings( node );
+            }
+            void visit_ast_for_loop_node( ast_for_loop_node * node ){
+                walk( node->initialise_ );
+                walk( node->question_ );
+                ++conditional_;
+                walk( node->loop_body_ );
+                walk( node->increment_ );
+                --conditional_;
+                walk_siblings( node );
+            }
+            void visit_ast_ternary_op_node( ast_ternary_op_node * node ){
+                walk( node->question_ );
+                ++conditional_;
+                walk( node->if_true_ );
+                walk( node->if_false_ );
+                --conditional_;
+                ast_walker::visit_ast_node( node );
+            }
+            void visit_ast_function_node( ast_function_node * node ){
+                // Only reachable through a call, which refuses
+                walk_siblings( node );
+            }
+
+            Awkccc_parallel_plan plan() {
+                Awkccc_parallel_plan answer;
+                for( auto & use : uses_ ) {
+                    if( ! use.written_ )
+                        continue;
+                    if( use.mixed_ )
+                        refuse( jString( "variable " ) + use.name_ + " is updated in more than one way" );
+                    else if( use.read_ && ! ( use.reduction_ == Reduce_Last && use.written_first_ ) )
+                        refuse( jString( "variable " ) + use.name_ + " may carry a value from one record to the next" );
+                    else
+                        answer.reducers_.push_back( { use.name_, use.c_name_, use.reduction_, use.is_array_ } );
+                }
+                answer.safe_ = reason_.len() == 0;
+                answer.ordered_output_ = answer.safe_ && prints_;
+                answer.reason_ = reason_;
+                if( ! answer.safe_ )
+                    answer.reducers_.clear();
+                return answer;
+            }
+    };
+
+    Awkccc_parallel_plan analyse_parallel( ast_node * root ) {
+        parallel_plan_finder finder;
+        finder.walk( root );
+        return finder.plan();
+    }
+
+    /**
+     * Follows every assignment to each variable, repeating the walk until no
+     * variable's type changes. A checking walk then makes sure every read of
+     * a variable that would be native comes after an assignment on every
+     * path to it, or is in a context where awk's uninitialised value & the
+     * native 0 or "" behave alike. A read that fails makes its variable
+     * dynamic & the whole process starts again; types only ever move
+     * towards Static_Dynamic, so it ends.
+     *
+     * Must-assigned sets are followed statement by statement: BEGIN rules
+     * in order, then the main rules for the first record, with END starting
+     * from what BEGIN assigned before any exit. Branches, loop bodies,
+     * pattern actions & the right of && and || only keep assignments made
+     * on every way through them. Function bodies start with nothing.
+    */
+    class variable_type_finder: public ast_walker {
+        public:
+            /// How the value of an expression is used
+            enum context {
+                Context_Value,          ///< Copied, printed by printf or compared with anything
+                Context_Number,         ///< Arithmetic: "" & 0 are both 0
+                Context_Compare_Number, ///< Compared with a number, where a string compares as a string
+                Context_String,         ///< Concatenated, printed or a subscript: 0 would be "0"
+                Context_Boolean         ///< Tested for truth or discarded: "" & 0 are both false
+            };
+            struct variable_state {
+                jString name_;
+                jString c_name_;
+                Awkccc_static_type type_ = Static_Unset;
+            };
+            std::vector<variable_state> states_;
+            std::map<Symbol *, size_t> index_;
+            /// Variables assigned on every path to the point reached
+            std::set<Symbol *> assigned_;
+            /// Built-in variables the program assigns, so they may hold anything
+            std::set<Symbol *> assigned_built_ins_;
+            /// What END may rely on: assigned_ at each exit BEGIN might take
+            std::set<Symbol *> end_start_;
+            bool exited_ = false;
+            bool in_begin_ = false;
+            bool checking_ = false;
+            bool changed_ = false;
+            context context_ = Context_Value;
+            Awkccc_static_type result_ = Static_Dynamic;
+
+            static Awkccc_static_type join( Awkccc_static_type a, Awkccc_static_type b ) {
+                if( a == b || b == Static_Unset )
+                    return a;
+                if( a == Static_Unset )
+                    return b;
+                if( a == Static_Array || b == Static_Array )
+                    return Static_Array;
+                if( is_numeric( a ) && is_numeric( b ) )
+                    return Static_Number;
+                return Static_Dynamic;
+            }
+            static bool is_numeric( Awkccc_static_type type ) {
+                return type == Static_Integer || type == Static_Number;
+            }
+            /// Would a native variable of type behave as an uninitialised one here
+            static bool uninitialised_alike( Awkccc_static_type type, context how ) {
+                if( how == Context_Boolean )
+                    return true;
+                if( is_numeric( type ) )
+                    return how == Context_Number || how == Context_Compare_Number;
+                if( type == Static_String )
+                    return how == Context_Number || how == Context_String;
+                return true;
+            }
+            static bool is_string_constant( ast_node * node ) {
+                return node != nullptr && node->child_nodes_.empty() && node->name_.len() > 0
+                    && ( (const char *) node->name_ )[0] == '"';
+            }
+            /// A NUMBER written without a point or exponent that fits an int64_t exactly
+            static Awkccc_static_type constant_type( ast_node * node ) {
+                const char * text = (const char *) node->name_;
+                size_t digits = 0;
+                while( std::isdigit( (unsigned char) text[digits] ) )
+                    ++digits;
+                return text[digits] == '\0' && digits <= 15 ? Static_Integer : Static_Number;
+            }
+            static bool is_statement( ast_node * node, const char * name ) {
+                return node != nullptr && node->has_sym_ && node->sym_->type_ == STATEMENT
+                    && node->name_ == name;
+            }
+            static bool is_arithmetic( ast_node * op ) {
+                return is_operator( op, "+" ) || is_operator( op, "-" ) || is_operator( op, "*" )
+                    || is_operator( op, "/" ) || is_operator( op, "%" ) || is_operator( op, "^" );
+            }
+            static bool is_comparison( ast_node * op ) {
+                return is_operator( op, "<" ) || is_operator( op, "<=" ) || is_operator( op, ">" )
+                    || is_operator( op, ">=" ) || is_operator( op, "==" ) || is_operator( op, "!=" );
+            }
+
+            variable_state & state_of( Symbol * sym ) {
+                auto found = index_.find( sym );
+                if( found != index_.end() )
+                    return states_[found->second];
+                index_[sym] = states_.size();
+                states_.push_back( variable_state() );
+                states_.back().name_ = sym->awk_name_;
+                states_.back().c_name_ = sym->c_name_;
+                return states_.back();
+            }
+            Awkccc_static_type built_in_type( Symbol * sym ) {
+                const jString & name = sym->awk_name_;
+                if( assigned_built_ins_.count( sym ) == 0
+                 && ( name == "NR" || name == "FNR" || name == "NF" || name == "RSTART" || name == "RLENGTH" ) )
+                    return Static_Integer;
+                return Static_Dynamic;
+            }
+            Awkccc_static_type read( Symbol * sym ) {
+                if( sym->is_built_in_ )
+                    return built_in_type( sym );
+                variable_state & state = state_of( sym );
+                if( checking_ && assigned_.count( sym ) == 0 && ! uninitialised_alike( state.type_, context_ ) ) {
+                    state.type_ = Static_Dynamic;
+                    changed_ = true;
+                }
+                return state.type_;
+            }
+            void write( Symbol * sym, Awkccc_static_type type, bool definite ) {
+                if( sym == nullptr )
+                    return;
+                if( sym->is_built_in_ ) {
+                    changed_ = assigned_built_ins_.insert( sym ).second || changed_;
+                    return;
+                }
+                variable_state & state = state_of( sym );
+                Awkccc_static_type joined = join( state.type_, type );
+                if( joined != state.type_ ) {
+                    state.type_ = joined;
+                    changed_ = true;
+                }
+                if( definite )
+                    assigned_.insert( sym );
+            }
+            /// The type an expression already has, without walking it
+            Awkccc_static_type peek( ast_node * node ) {
+                node = strip_parentheses( node );
+                if( is_string_constant( node ) )
+                    return Static_String;
+                double number;
+                if( is_number_constant( node, number ) )
+                    return constant_type( node );
+                if( Symbol * sym = variable_of( node ) ) {
+                    if( sym->is_built_in_ )
+                        return built_in_type( sym );
+                    auto found = index_.find( sym );
+                    return found == index_.end() ? Static_Unset : states_[found->second].type_;
+                }
+                ast_node * op = operator_of( node );
+                if( is_arithmetic( op ) )
+                    return Static_Number;
+                if( is_operator( op, "@@@" ) )
+                    return Static_String;
+                return Static_Dynamic;
+            }
+            /// How an operand compared with other is used
+            context compared_with( ast_node * other ) {
+                Awkccc_static_type type = peek( other );
+                if( is_numeric( type ) )
+                    return Context_Compare_Number;
+                return type == Static_String ? Context_String : Context_Value;
+            }
+
+            /// The type of node alone, used as how says
+            Awkccc_static_type type_of( ast_node * node, context how ) {
+                if( node == nullptr )
+                    return Static_Dynamic;
+                auto save_context = Save( context_ );
+                context_ = how;
+                result_ = Static_Dynamic;
+                node->accept( this );
+                return result_;
+            }
+            /// The type of node, then any statements following it
+            Awkccc_static_type value( ast_node * node, context how ) {
+                Awkccc_static_type answer = type_of( node, how );
+                if( node != nullptr )
+                    for( auto sibling : node->sibling_nodes_ )
+                        value( sibling, Context_Boolean );
+                return answer;
+            }
+            void statements( ast_node * node ) {
+                value( node, Context_Boolean );
+            }
+            /// Children beyond an operator's operands are a pattern's action
+            void action( ast_node * node, size_t operands ) {
+                std::set<Symbol *> before = assigned_;
+                for( size_t i = operands; i < node->child_nodes_.size(); ++i )
+                    statements( node->child_nodes_[i] );
+                assigned_.swap( before );
+            }
+            /// Keep only what both of two ways through assigned
+            void meet( std::set<Symbol *> & other ) {
+                for( auto sym = assigned_.begin(); sym != assigned_.end(); )
+                    sym = other.count( *sym ) ? std::next( sym ) : assigned_.erase( sym );
+            }
+            /// END may start from here if BEGIN leaves now
+            void leaving_begin() {
+                if( ! in_begin_ )
+                    return;
+                if( exited_ ) {
+                    std::set<Symbol *> common;
+                    for( auto sym : end_start_ )
+                        if( assigned_.count( sym ) )
+                            common.insert( sym );
+                    end_start_.swap( common );
+                } else {
+                    end_start_ = assigned_;
+                }
+                exited_ = true;
+            }
+            /// Store a value of type into an lvalue: NAME, NAME[...] or $n
+            void store( ast_node * lvalue, Awkccc_static_type type, bool definite ) {
+                lvalue = strip_parentheses( lvalue );
+                if( Symbol * sym = variable_of( lvalue ) )
+                    write( sym, type, definite );
+                else
+                    type_of( lvalue, Context_Value );
+            }
+            /// lvalue op= step: read the old value as a number & store the new one
+            Awkccc_static_type update( ast_node * lvalue, Awkccc_static_type step ) {
+                lvalue = strip_parentheses( lvalue );
+                Awkccc_static_type old = type_of( lvalue, Context_Number );
+                Awkccc_static_type answer = join( old, step );
+                if( Symbol * sym = variable_of( lvalue ) )
+                    write( sym, answer, true );
+                return is_numeric( answer ) ? answer : Static_Number;
+            }
+
+            void visit_ast_node( ast_node * node ){
+                if( node->has_sym_ && node->sym_->type_ == STATEMENT ) {
+                    statement( node );
+                    result_ = Static_Dynamic;
+                    return;
+                }
+                Awkccc_static_type answer = Static_Dynamic;
+                double number;
+                if( is_string_constant( node ) )
+                    answer = Static_String;
+                else if( is_number_constant( node, number ) )
+                    answer = constant_type( node );
+                else if( is_ere_literal( node ) )
+                    answer = Static_Integer;
+                else if( Symbol * sym = variable_of( node ) )
+                    answer = read( sym );
+                action( node, 0 );
+                result_ = answer;
+            }
+            /// print, getline, delete & for( name in array ), which reach the tree as tokens
+            void statement( ast_node * node ){
+                auto & children = node->child_nodes_;
+                if( node->name_ == "print" || node->name_ == "printf" ) {
+                    for( size_t i = 0; i < children.size(); ++i ) {
+                        if( is_output_redirection( children[i] ) )
+                            value( children[i]->child_nodes_[0], Context_String );
+                        else
+                            value( children[i], i == 0 || node->name_ == "print" ? Context_String : Context_Value );
+                    }
+                } else if( node->name_ == "getline" ) {
+                    for( auto child : children )
+                        store( child, Static_Dynamic, false );
+                } else if( node->name_ == "delete" && ! children.empty() ) {
+                    write( variable_of( children[0] ), Static_Array, false );
+                    for( size_t i = 1; i < children.size(); ++i )
+                        value( children[i], Context_String );
+                } else if( node->name_ == "for" && children.size() >= 2 ) {
+                    write( variable_of( children[1] ), Static_Array, false );
+                    std::set<Symbol *> before = assigned_;
+                    store( children[0], Static_String, true );
+                    for( size_t i = 2; i < children.size(); ++i )
+                        statements( children[i] );
+                    assigned_.swap( before );
+                } else {
+                    for( auto child : children )
+                        value( child, Context_Value );
+                }
+            }
+            void visit_ast_empty_node( ast_empty_node * node ){
+                // print_record, range_pattern & the like: their parts may not run
+                std::set<Symbol *> before = assigned_;
+                for( auto child : node->child_nodes_ )
+                    statements( child );
+                assigned_.swap( before );
+                result_ = Static_Dynamic;
+            }
+            void visit_ast_statement_node( ast_statement_node * node ){
+                const bool exit = is_operator( node->kw_node_, "exit" );
+                for( auto child : node->child_nodes_ )
+                    value( child, exit ? Context_Number : Context_Value );
+                if( exit )
+                    leaving_begin();
+                result_ = Static_Dynamic;
+            }
+            void visit_ast_op_node( ast_op_node * node ){
+                // a b c d once flattened
+                const bool concatenation = is_operator( node->op_node_, "@@@" );
+                for( auto child : node->child_nodes_ )
+                    value( child, concatenation ? Context_String : Context_Value );
+                result_ = concatenation ? Static_String : Static_Dynamic;
+            }
+            void visit_ast_left_unary_op_node( ast_left_unary_op_node * node ){
+                visit_unary( node, node->op_node_ );
+            }
+            void visit_ast_right_unary_op_node( ast_right_unary_op_node * node ){
+                visit_unary( node, node->op_node_ );
+            }
+            void visit_unary( ast_node * node, ast_node * op ){
+                Awkccc_static_type answer = Static_Dynamic;
+                if( ! node->child_nodes_.empty() ) {
+                    ast_node * operand = node->child_nodes_[0];
+                    if( is_operator( op, "++" ) || is_operator( op, "--" ) )
+                        answer = update( operand, Static_Integer );
+                    else if( is_operator( op, "$" ) )
+                        value( operand, Context_Number );
+                    else if( is_operator( op, "-" ) || is_operator( op, "+" ) )
+                        answer = value( operand, Context_Number ) == Static_Integer ? Static_Integer : Static_Number;
+                    else if( is_operator( op, "!" ) ) {
+                        value( operand, Context_Boolean );
+                        answer = Static_Integer;
+                    } else if( is_operator( op, "(" ) )
+                        answer = value( operand, context_ );
+                    else
+                        value( operand, Context_Value );
+                }
+                action( node, 1 );
+                result_ = answer;
+            }
+            void visit_ast_bin_op_node( ast_bin_op_node * node ){
+                auto & operands = node->child_nodes_;
+                ast_node * op = node->op_node_;
+                if( operands.size() < 2 ) {
+                    visit_ast_op_node( node );
+                    return;
+                }
+                size_t arity = 2;
+                Awkccc_static_type answer = Static_Integer;
+                double step;
+                if( is_operator( op, "=" ) ) {
+                    answer = value( operands[1], Context_Value );
+                    store( operands[0], answer, true );
+                } else if( is_operator( op, "+=" ) || is_operator( op, "-=" ) ) {
+                    // Small whole steps keep a counter whole
+                    bool small = is_number_constant( operands[1], step ) && step <= 65536
+                              && constant_type( operands[1] ) == Static_Integer;
+                    value( operands[1], Context_Number );
+                    answer = update( operands[0], small ? Static_Integer : Static_Number );
+                } else if( is_operator( op, "*=" ) || is_operator( op, "/=" )
+                        || is_operator( op, "%=" ) || is_operator( op, "^=" ) ) {
+                    value( operands[1], Context_Number );
+                    answer = update( operands[0], Static_Number );
+                } else if( is_operator( op, "(" ) ) {
+                    answer = call( node );
+                    arity = operands.size();
+                } else if( is_operator( op, "&&" ) || is_operator( op, "||" ) ) {
+                    value( operands[0], Context_Boolean );
+                    std::set<Symbol *> before = assigned_;
+                    value( operands[1], Context_Boolean );
+                    assigned_.swap( before );
+                } else if( is_operator( op, "in" ) ) {
+                    value( operands[0], Context_String );
+                    write( variable_of( operands[1] ), Static_Array, false );
+                } else if( is_operator( op, "[" ) ) {
+                    write( variable_of( operands[0] ), Static_Array, false );
+                    for( size_t i = 1; i < operands.size(); ++i )
+                        value( operands[i], Context_String );
+                    arity = operands.size();
+                    answer = Static_Dynamic;
+                } else if( is_operator( op, "@@@" ) && is_statement( operands[0], "getline" ) ) {
+                    // getline var, & getline var < file
+                    ast_node * target = operands[1];
+                    if( is_operator( operator_of( target ), "<" ) && target->child_nodes_.size() == 2 ) {
+                        value( target->child_nodes_[1], Context_String );
+                        target = target->child_nodes_[0];
+                    }
+                    store( target, Static_Dynamic, false );
+                } else if( is_operator( op, "@@@" ) && is_operator( operator_of( operands[0] ), "|" )
+                        && operands[0]->child_nodes_.size() == 2
+                        && is_statement( operands[0]->child_nodes_[1], "getline" ) ) {
+                    // cmd | getline var
+                    value( operands[0]->child_nodes_[0], Context_String );
+                    store( operands[1], Static_Dynamic, false );
+                } else if( is_operator( op, "|" ) && is_statement( operands[1], "getline" ) ) {
+                    value( operands[0], Context_String );
+                } else if( is_operator( op, "<" ) && is_statement( operands[0], "getline" ) ) {
+                    value( operands[1], Context_String );
+                } else if( is_comparison( op ) ) {
+                    context left = compared_with( operands[1] );
+                    context right = compared_with( operands[0] );
+                    value( operands[0], left );
+                    value( operands[1], right );
+                } else if( is_operator( op, "~" ) || is_operator( op, "!~" ) ) {
+                    value( operands[0], Context_String );
+                    value( operands[1], Context_String );
+                } else if( is_operator( op, "@@@" ) ) {
+                    value( operands[0], Context_String );
+                    value( operands[1], Context_String );
+                    answer = Static_String;
+                } else if( is_arithmetic( op ) ) {
+                    value( operands[0], Context_Number );
+                    value( operands[1], Context_Number );
+                    answer = Static_Number;
+                } else {
+                    value( operands[0], Context_Value );
+                    value( operands[1], Context_Value );
+                    answer = Static_Dynamic;
+                }
+                action( node, arity );
+                result_ = answer;
+            }
+            /// name( args ). The arguments are the operands after the name
+            Awkccc_static_type call( ast_node * node ){
+                ast_node * function = node->child_nodes_[0];
+                std::vector<ast_node *> args;
+                for( size_t i = 1; i < node->child_nodes_.size(); ++i ) {
+                    args.push_back( node->child_nodes_[i] );
+                    for( auto sibling : node->child_nodes_[i]->sibling_nodes_ )
+                        args.push_back( sibling );
+                }
+                if( ! function->has_sym_ || ! function->sym_->is_built_in_ ) {
+                    // A user function may exit, & may make an argument an array
+                    for( auto arg : args ) {
+                        if( Symbol * sym = variable_of( strip_parentheses( arg ) ) )
+                            write( sym, Static_Dynamic, false );
+                        else
+                            type_of( arg, Context_Value );
+                    }
+                    leaving_begin();
+                    return Static_Dynamic;
+                }
+                const jString & name = function->sym_->awk_name_;
+                auto arg = [&]( size_t i, context how ) {
+                    return i < args.size() ? type_of( args[i], how ) : Static_Dynamic;
+                };
+                Awkccc_static_type answer = Static_Integer;
+                size_t done = 0;
+                if( name == "length" || name == "close" || name == "system" || name == "fflush" ) {
+                    arg( 0, Context_String );
+                    done = 1;
+                } else if( name == "index" || name == "match" ) {
+                    arg( 0, Context_String );
+                    arg( 1, Context_String );
+                    done = 2;
+                } else if( name == "split" ) {
+                    arg( 0, Context_String );
+                    for( size_t i = 1; i < args.size() && i < 4; i += 2 )
+                        write( variable_of( strip_parentheses( args[i] ) ), Static_Array, false );
+                    arg( 2, Context_String );
+                    done = args.size();
+                } else if( name == "sub" || name == "gsub" ) {
+                    arg( 0, Context_String );
+                    arg( 1, Context_String );
+                    if( args.size() >= 3 ) {
+                        // Only changed, & so only made a string, if the ERE matches
+                        Awkccc_static_type old = arg( 2, Context_String );
+                        if( Symbol * sym = variable_of( strip_parentheses( args[2] ) ) )
+                            write( sym, join( old, Static_String ), false );
+                    }
+                    done = 3;
+                } else if( name == "substr" ) {
+                    arg( 0, Context_String );
+                    arg( 1, Context_Number );
+                    arg( 2, Context_Number );
+                    answer = Static_String;
+                    done = 3;
+                } else if( name == "tolower" || name == "toupper" || name == "sprintf" ) {
+                    arg( 0, Context_String );
+                    answer = Static_String;
+                    done = 1;
+                } else if( name == "sin" || name == "cos" || name == "atan2" || name == "exp"
+                        || name == "log" || name == "sqrt" || name == "int" || name == "rand"
+                        || name == "srand" ) {
+                    arg( 0, Context_Number );
+                    arg( 1, Context_Number );
+                    answer = Static_Number;
+                    done = 2;
+                } else {
+                    answer = Static_Dynamic;
+                }
+                for( size_t i = done; i < args.size(); ++i )
+                    type_of( args[i], Context_Value );
+                return answer;
+            }
+            void visit_ast_branch_loop_node( ast_branch_loop_node * node ){
+                value( node->question_, Context_Boolean );
+                std::set<Symbol *> before = assigned_;
+                statements( node->if_true_ );
+                std::set<Symbol *> if_true;
+                if_true.swap( assigned_ );
+                assigned_ = before;
+                statements( node->if_false_ );
+                meet( if_true );
+                result_ = Static_Dynamic;
+            }
+            void visit_ast_for_loop_node( ast_for_loop_node * node ){
+                statements( node->initialise_ );
+                value( node->question_, Context_Boolean );
+                std::set<Symbol *> before = assigned_;
+                statements( node->loop_body_ );
+                statements( node->increment_ );
+                assigned_.swap( before );
+                result_ = Static_Dynamic;
+            }
+            void visit_ast_ternary_op_node( ast_ternary_op_node * node ){
+                value( node->question_, Context_Boolean );
+                const context how = context_;
+                std::set<Symbol *> before = assigned_;
+                Awkccc_static_type if_true = value( node->if_true_, how );
+                std::set<Symbol *> after_true;
+                after_true.swap( assigned_ );
+                assigned_ = before;
+                Awkccc_static_type if_false = value( node->if_false_, how );
+                meet( after_true );
+                action( node, 0 );
+                Awkccc_static_type answer = join( if_true, if_false );
+                result_ = answer == Static_Unset ? Static_Dynamic : answer;
+            }
+            void visit_ast_function_node( ast_function_node * node ){
+                if( node->parameters_ != nullptr ) {
+                    write( variable_of( node->parameters_ ), Static_Dynamic, false );
+                    for( auto parameter : node->parameters_->sibling_nodes_ )
+                        write( variable_of( parameter ), Static_Dynamic, false );
+                }
+                assigned_.clear();
+                statements( node->body_ );
+                result_ = Static_Dynamic;
+            }
+
+            void walk_program( ast_node * root ) {
+                assigned_.clear();
+                end_start_.clear();
+                exited_ = false;
+                in_begin_ = true;
+                for( auto child : root->child_nodes_ )
+                    if( child->type_ == Pattern && child->name_ == "BEGIN" )
+                        for( auto item : child->child_nodes_ )
+                            statements( item );
+                const std::set<Symbol *> after_begin = assigned_;
+                leaving_begin();
+                in_begin_ = false;
+                // The main rules, in order, for the first record
+                for( auto child : root->child_nodes_ )
+                    if( child->type_ != Pattern && shape_of( child ).function_ == nullptr )
+                        statements( child );
+                for( auto child : root->child_nodes_ ) {
+                    if( child->type_ == Pattern && ! ( child->name_ == "BEGIN" ) ) {
+                        assigned_ = child->name_ == "END" ? end_start_ : after_begin;
+                        for( auto item : child->child_nodes_ )
+                            statements( item );
+                    } else if( shape_of( child ).function_ != nullptr ) {
+                        child->accept( this );
+                    }
+                }
+            }
+            std::vector<Awkccc_variable_type> types( ast_node * root ) {
+                for( ;; ) {
+                    do {
+                        changed_ = false;
+                        walk_program( root );
+                    } while( changed_ );
+                    // Never assigned: only the uninitialised value will do
+                    bool unset = false;
+                    for( auto & state : states_ )
+                        if( state.type_ == Static_Unset ) {
+                            state.type_ = Static_Dynamic;
+                            unset = true;
+                        }
+                    if( unset )
+                        continue;
+                    checking_ = true;
+                    changed_ = false;
+                    walk_program( root );
+                    checking_ = false;
+                    if( ! changed_ )
+                        break;
+                }
+                std::vector<Awkccc_variable_type> answer;
+                for( auto & state : states_ )
+                    answer.push_back( { state.name_, state.c_name_, state.type_ } );
+                return answer;
+            }
+    };
+
+    std::vector<Awkccc_variable_type> analyse_variable_types( ast_node * root ) {
+        variable_type_finder finder;
+        return finder.types( root );
+    }
+} // namespace awkccc
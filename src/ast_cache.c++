@@ -0,0 +1,675 @@
+/***
+**
+** AWKCCC: On-disk cache of the parsed AST of @include files
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <unordered_map>
+#include <unistd.h>
+#include "../include/jString.hpp"
+#include "../include/awkccc_ast.hpp"
+#include "../src/parser.h++"
+#include "../include/awkccc_lexer.hpp"
+#include "../include/awkccc_ast_cache.h++"
+using namespace jclib;
+
+namespace awkccc {
+namespace {
+    /*
+     * An entry is
+     *     magic, format_version_, AWKCCC_VERSION, key, size of the text
+     *     the number of files @included, then each one's name & key
+     *     the number of symbols, then each symbol's
+     *         namespace, name, type, token
+     *     the number of nodes, then each node's
+     *         kind, type_, flags, rule_nr_, symbol, name_ (unless it is
+     *         the symbol's), children, siblings & the fields of its kind
+     *     the number of the item_list
+     * Numbers are LEB128, texts a length then the bytes & the key 8 bytes,
+     * least significant first. Symbols & nodes are numbered from 1 in the
+     * order written, 0 meaning none; a node is written after every node it
+     * refers to.
+    */
+    const char magic[] = "awkccc ast\n";
+
+    enum node_kind : uint8_t {
+        Kind_node,
+        Kind_empty,
+        Kind_statement,
+        Kind_op,
+        Kind_left_unary_op,
+        Kind_right_unary_op,
+        Kind_bin_op,
+        Kind_function,
+        Kind_branch_loop,
+        Kind_for_loop,
+        Kind_ternary_op
+    };
+    /// How many of its own node pointers each kind has, such as kw_node_
+    const size_t field_counts[] = { 0, 0, 1, 1, 1, 1, 1, 3, 4, 5, 4 };
+    constexpr size_t max_fields = 5;
+
+    enum node_flags : uint8_t {
+        Has_sym = 1,
+        Extra_children_allowed = 2,
+        Dummy = 4,
+        /// name_ is the symbol's name & isn't written again
+        Symbol_name = 8
+    };
+
+    inline std::string_view view( const jString & text ) {
+        return std::string_view( (const char *) text, text.len() );
+    }
+
+    inline jString to_string( std::string_view text ) {
+        return jString( text.data(), text.data() + text.size() );
+    }
+
+    void put_number( std::string & out, uint64_t number ) {
+        while( number >= 0x80 ) {
+            out += char( number | 0x80 );
+            number >>= 7;
+        }
+        out += char( number );
+    }
+
+    void put_text( std::string & out, std::string_view text ) {
+        put_number( out, text.size() );
+        out.append( text );
+    }
+
+    /// rule_nr_ is -1 when there is no rule
+    inline uint64_t zigzag( int number ) {
+        return ( uint64_t( number ) << 1 ) ^ uint64_t( int64_t( number ) >> 63 );
+    }
+
+    inline int unzigzag( uint64_t number ) {
+        return int( int64_t( number >> 1 ) ^ -int64_t( number & 1 ) );
+    }
+
+    /// Reads an entry, noting rather than throwing when it runs out
+    class entry_reader {
+        public:
+            explicit entry_reader( std::string_view in )
+                : in_( in )
+                {}
+            bool ok_ = true;
+            uint8_t byte() {
+                if( in_.empty() ) {
+                    ok_ = false;
+                    return 0;
+                }
+                uint8_t answer = in_[0];
+                in_.remove_prefix( 1 );
+                return answer;
+            }
+            uint64_t number() {
+                uint64_t answer = 0;
+                for( int shift = 0; shift < 64; shift += 7 ) {
+                    uint8_t next = byte();
+                    answer |= uint64_t( next & 0x7f ) << shift;
+                    if( ( next & 0x80 ) == 0 )
+                        return answer;
+                }
+                ok_ = false;
+                return 0;
+            }
+            std::string_view text( size_t size ) {
+                if( size > in_.size() ) {
+                    ok_ = false;
+                    return std::string_view();
+                }
+                std::string_view answer = in_.substr( 0, size );
+                in_.remove_prefix( size );
+                return answer;
+            }
+            std::string_view text() {
+                return text( number() );
+            }
+            uint64_t fixed64() {
+                uint64_t answer = 0;
+                for( int shift = 0; shift < 64; shift += 8 )
+                    answer |= uint64_t( byte() ) << shift;
+                return answer;
+            }
+            bool at_end() const {
+                return in_.empty();
+            }
+        private:
+            std::string_view in_;
+    };
+
+    /// The kind of a node & the nodes its own fields point to
+    class node_shape: public ast_node_visitor {
+        public:
+            node_kind kind_ = Kind_node;
+            ast_node * fields_[max_fields];
+
+            virtual void visit_ast_node( ast_node * ) {
+                kind_ = Kind_node;
+            }
+            virtual void visit_ast_empty_node( ast_empty_node * ) {
+                kind_ = Kind_empty;
+            }
+            virtual void visit_ast_statement_node( ast_statement_node * node ) {
+                set( Kind_statement, { node->kw_node_ } );
+            }
+            virtual void visit_ast_op_node( ast_op_node * node ) {
+                set( Kind_op, { node->op_node_ } );
+            }
+            virtual void visit_ast_left_unary_op_node( ast_left_unary_op_node * node ) {
+                set( Kind_left_unary_op, { node->op_node_ } );
+            }
+            virtual void visit_ast_right_unary_op_node( ast_right_unary_op_node * node ) {
+                set( Kind_right_unary_op, { node->op_node_ } );
+            }
+            virtual void visit_ast_bin_op_node( ast_bin_op_node * node ) {
+                set( Kind_bin_op, { node->op_node_ } );
+            }
+            virtual void visit_ast_function_node( ast_function_node * node ) {
+                set( Kind_function, { node->function_, node->parameters_, node->body_ } );
+            }
+            virtual void visit_ast_branch_loop_node( ast_branch_loop_node * node ) {
+                set( Kind_branch_loop, { node->kw_node_, node->question_, node->if_true_, node->if_false_ } );
+            }
+            virtual void visit_ast_for_loop_node( ast_for_loop_node * node ) {
+                set( Kind_for_loop, { node->kw_node_, node->initialise_, node->question_,
+                                      node->increment_, node->loop_body_ } );
+            }
+            virtual void visit_ast_ternary_op_node( ast_ternary_op_node * node ) {
+                set( Kind_ternary_op, { node->op_node_, node->question_, node->if_true_, node->if_false_ } );
+            }
+        private:
+            void set( node_kind kind, std::initializer_list<ast_node *> fields ) {
+                kind_ = kind;
+                size_t i = 0;
+                for( auto field : fields )
+                    fields_[i++] = field;
+            }
+    };
+
+    /// Numbers & writes the nodes reachable from an item_list
+    class entry_writer {
+        public:
+            std::string symbols_;
+            std::string nodes_;
+            uint64_t symbol_count_ = 0;
+            uint64_t node_count_ = 0;
+            /// False if a node turned out to be its own descendant
+            bool ok_ = true;
+
+            /// node's number, writing it & all it refers to if they are new
+            uint64_t number( ast_node * node ) {
+                if( node == nullptr || ! ok_ )
+                    return 0;
+                auto seen = node_numbers_.find( node );
+                if( seen != node_numbers_.end() ) {
+                    // Still 0 while node's descendants are being written
+                    if( seen->second == 0 )
+                        ok_ = false;
+                    return seen->second;
+                }
+                node_numbers_[node] = 0;
+                node_shape shape;
+                node->accept( &shape );
+                size_t field_count = field_counts[shape.kind_];
+                std::vector<uint64_t> children, siblings;
+                uint64_t fields[max_fields];
+                for( auto child : node->child_nodes_ )
+                    children.push_back( number( child ) );
+                for( auto sibling : node->sibling_nodes_ )
+                    siblings.push_back( number( sibling ) );
+                for( size_t i = 0; i < field_count; ++i )
+                    fields[i] = number( shape.fields_[i] );
+                Symbol * sym = node->sym_;
+                bool symbol_name = sym != nullptr && node->name_ == sym->awk_name_;
+                uint8_t flags = ( node->has_sym_ ? Has_sym : 0 )
+                              | ( node->extra_children_allowed_ ? Extra_children_allowed : 0 )
+                              | ( node->dummy_ ? Dummy : 0 )
+                              | ( symbol_name ? Symbol_name : 0 );
+                nodes_ += char( shape.kind_ );
+                nodes_ += char( node->type_ );
+                nodes_ += char( flags );
+                put_number( nodes_, zigzag( node->rule_nr_ ) );
+                put_number( nodes_, symbol( sym ) );
+                if( ! symbol_name )
+                    put_text( nodes_, view( node->name_ ) );
+                put_number( nodes_, children.size() );
+                for( auto child : children )
+                    put_number( nodes_, child );
+                put_number( nodes_, siblings.size() );
+                for( auto sibling : siblings )
+                    put_number( nodes_, sibling );
+                for( size_t i = 0; i < field_count; ++i )
+                    put_number( nodes_, fields[i] );
+                return node_numbers_[node] = ++node_count_;
+            }
+        private:
+            std::unordered_map<ast_node *, uint64_t> node_numbers_;
+            std::unordered_map<Symbol *, uint64_t> symbol_numbers_;
+
+            uint64_t symbol( Symbol * sym ) {
+                if( sym == nullptr )
+                    return 0;
+                uint64_t & answer = symbol_numbers_[sym];
+                if( answer == 0 ) {
+                    answer = ++symbol_count_;
+                    put_text( symbols_, view( sym->awk_namespace_ ) );
+                    put_text( symbols_, view( sym->awk_name_ ) );
+                    symbols_ += char( sym->type_ );
+                    put_number( symbols_, zigzag( sym->token_ ) );
+                }
+                return answer;
+            }
+    };
+
+    struct symbol_record {
+        std::string_view awk_namespace_;
+        std::string_view awk_name_;
+        SymbolType type_;
+        int token_;
+    };
+
+    struct node_record {
+        node_kind kind_;
+        node_types type_;
+        uint8_t flags_;
+        int rule_nr_;
+        uint64_t sym_;
+        std::string_view name_;
+        /// Where the node's children, then siblings, then fields start in
+        /// the references read
+        size_t children_at_;
+        size_t child_count_;
+        size_t siblings_at_;
+        size_t sibling_count_;
+        size_t fields_at_;
+    };
+
+    /// Reads & closes file
+    bool read_all( std::FILE * file, std::string & into ) {
+        char chunk[64 * 1024];
+        size_t got;
+        while( ( got = std::fread( chunk, 1, sizeof chunk, file ) ) > 0 )
+            into.append( chunk, got );
+        bool ok = ! std::ferror( file );
+        std::fclose( file );
+        return ok;
+    }
+
+    bool read_file( const jString & path, std::string & into ) {
+        std::FILE * file = std::fopen( path, "rb" );
+        return file && read_all( file, into );
+    }
+
+    /// Written under a name of its own & renamed, so a translation running
+    /// at the same time never reads half an entry
+    void write_file( const jString & path, const std::string & entry ) {
+        std::error_code ignored;
+        std::filesystem::path target( (const char *) path );
+        std::filesystem::create_directories( target.parent_path(), ignored );
+        std::filesystem::path partial = target;
+        partial += "." + std::to_string( getpid() );
+        std::FILE * file = std::fopen( partial.c_str(), "wb" );
+        if( ! file )
+            return;
+        bool ok = std::fwrite( entry.data(), 1, entry.size(), file ) == entry.size();
+        ok = std::fclose( file ) == 0 && ok;
+        if( ok )
+            std::filesystem::rename( partial, target, ignored );
+        if( ! ok || ignored )
+            std::filesystem::remove( partial, ignored );
+    }
+}
+
+uint64_t ast_cache::key( std::string_view text ) {
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash]( std::string_view more ) {
+        for( unsigned char c : more )
+            hash = ( hash ^ c ) * 1099511628211ull;
+    };
+    add( AWKCCC_VERSION );
+    hash = ( hash ^ format_version_ ) * 1099511628211ull;
+    add( text );
+    return hash;
+}
+
+uint64_t ast_cache::current_key( const jString & name ) {
+    jString path;
+    std::FILE * file = Lexer::open_include( name, path );
+    std::string text;
+    if( ! file || ! read_all( file, text ) )
+        return 0;
+    return key( text );
+}
+
+jString ast_cache::entry_name( uint64_t key ) const {
+    char name[32];
+    std::snprintf( name, sizeof name, "/%016llx.ast", (unsigned long long) key );
+    return directory_ + jString( name );
+}
+
+std::string ast_cache::save( ast_node * items, uint64_t key, size_t text_size,
+                             const std::vector<nested_include> & nested ) {
+    entry_writer writer;
+    uint64_t root = writer.number( items );
+    if( ! writer.ok_ )
+        return std::string();
+    std::string answer( magic );
+    put_number( answer, format_version_ );
+    put_text( answer, AWKCCC_VERSION );
+    for( int shift = 0; shift < 64; shift += 8 )
+        answer += char( key >> shift );
+    put_number( answer, text_size );
+    put_number( answer, nested.size() );
+    for( auto & file : nested ) {
+        put_text( answer, view( file.name_ ) );
+        for( int shift = 0; shift < 64; shift += 8 )
+            answer += char( file.key_ >> shift );
+    }
+    put_number( answer, writer.symbol_count_ );
+    answer += writer.symbols_;
+    put_number( answer, writer.node_count_ );
+    answer += writer.nodes_;
+    put_number( answer, root );
+    return answer;
+}
+
+namespace {
+    /// The count & list of the files an entry's file @included
+    bool read_nested( entry_reader & in, size_t entry_size,
+                      std::vector<ast_cache::nested_include> & nested ) {
+        uint64_t nested_count = in.number();
+        if( ! in.ok_ || nested_count > entry_size )
+            return false;
+        for( uint64_t i = 0; i < nested_count && in.ok_; ++i ) {
+            jString name = to_string( in.text() );
+            uint64_t was = in.fixed64();
+            nested.push_back( { name, was } );
+        }
+        return in.ok_;
+    }
+}
+
+bool ast_cache::nested_includes( std::string_view entry, std::vector<nested_include> & nested ) {
+    entry_reader in( entry );
+    if( in.text( sizeof magic - 1 ) != magic
+     || in.number() != format_version_
+     || in.text() != AWKCCC_VERSION )
+        return false;
+    in.fixed64();
+    in.number();
+    return in.ok_ && read_nested( in, entry.size(), nested );
+}
+
+ast_node_ptr ast_cache::load( std::string_view entry, uint64_t key, size_t text_size,
+                              SymbolTable & symbol_table,
+                              std::vector<nested_include> * nested ) {
+    entry_reader in( entry );
+    if( in.text( sizeof magic - 1 ) != magic
+     || in.number() != format_version_
+     || in.text() != AWKCCC_VERSION
+     || in.fixed64() != key
+     || in.number() != text_size
+     || ! in.ok_ )
+        return ast_node_ptr();
+    std::vector<nested_include> included;
+    if( ! read_nested( in, entry.size(), included ) )
+        return ast_node_ptr();
+    for( auto & file : included ) {
+        if( current_key( file.name_ ) != file.key_ )
+            return ast_node_ptr();
+    }
+
+    // Everything is read & checked before a symbol or node is made, so a
+    // damaged entry leaves the symbol table as it was
+    uint64_t symbol_count = in.number();
+    if( ! in.ok_ || symbol_count > entry.size() )
+        return ast_node_ptr();
+    std::vector<symbol_record> symbols( symbol_count );
+    for( auto & sym : symbols ) {
+        sym.awk_namespace_ = in.text();
+        sym.awk_name_ = in.text();
+        uint8_t type = in.byte();
+        sym.type_ = SymbolType( type );
+        sym.token_ = unzigzag( in.number() );
+        if( type > OTHER )
+            in.ok_ = false;
+    }
+    uint64_t node_count = in.number();
+    if( ! in.ok_ || node_count > entry.size() )
+        return ast_node_ptr();
+    std::vector<node_record> records( node_count );
+    std::vector<uint64_t> references;
+    for( uint64_t number = 1; number <= node_count && in.ok_; ++number ) {
+        node_record & record = records[number - 1];
+        uint8_t kind = in.byte();
+        uint8_t type = in.byte();
+        record.kind_ = node_kind( kind );
+        record.type_ = node_types( type );
+        record.flags_ = in.byte();
+        record.rule_nr_ = unzigzag( in.number() );
+        record.sym_ = in.number();
+        if( kind > Kind_ternary_op || type > Empty || record.sym_ > symbols.size()
+         || ( ( record.flags_ & Symbol_name ) && record.sym_ == 0 ) ) {
+            in.ok_ = false;
+            break;
+        }
+        if( ! ( record.flags_ & Symbol_name ) )
+            record.name_ = in.text();
+        record.children_at_ = references.size();
+        record.child_count_ = in.number();
+        for( size_t i = 0; i < record.child_count_ && in.ok_; ++i )
+            references.push_back( in.number() );
+        record.siblings_at_ = references.size();
+        record.sibling_count_ = in.number();
+        for( size_t i = 0; i < record.sibling_count_ && in.ok_; ++i )
+            references.push_back( in.number() );
+        record.fields_at_ = references.size();
+        for( size_t i = 0; i < field_counts[kind]; ++i )
+            references.push_back( in.number() );
+        // Only nodes already made may be referred to, & the constructors
+        // of the operators need their operands
+        for( size_t i = record.children_at_; i < references.size(); ++i )
+            if( references[i] >= number )
+                in.ok_ = false;
+        for( size_t i = record.children_at_; i < record.siblings_at_; ++i )
+            if( references[i] == 0 )
+                in.ok_ = false;
+        for( size_t i = record.siblings_at_; i < record.fields_at_; ++i )
+            if( references[i] == 0 )
+                in.ok_ = false;
+        size_t operands = kind == Kind_bin_op ? 2
+                        : kind == Kind_left_unary_op || kind == Kind_right_unary_op ? 1 : 0;
+        if( record.child_count_ < operands )
+            in.ok_ = false;
+    }
+    uint64_t root = in.number();
+    if( ! in.ok_ || ! in.at_end() || root == 0 || root > node_count )
+        return ast_node_ptr();
+
+    std::vector<Symbol *> made_symbols;
+    made_symbols.reserve( symbols.size() );
+    for( auto & record : symbols ) {
+        Symbol * sym = symbol_table.get( record.awk_namespace_, record.awk_name_, record.token_, true, record.type_ );
+        // A function defined in the file is known to be one by whatever
+        // follows the @include, as if the file had just been parsed
+        if( record.type_ == FUNCTION && sym->type_ != FUNCTION )
+            sym->set_type( FUNCTION, record.token_ );
+        made_symbols.push_back( sym );
+    }
+
+    ast_arena & arena = ast_arena::current();
+    std::vector<ast_node *> nodes;
+    nodes.reserve( node_count );
+    for( auto & record : records ) {
+        auto at = [&]( size_t i ) -> ast_node_ptr {
+            return references[i] ? nodes[references[i] - 1] : nullptr;
+        };
+        Symbol * sym = record.sym_ ? made_symbols[record.sym_ - 1] : nullptr;
+        jString name = record.flags_ & Symbol_name ? sym->awk_name_ : to_string( record.name_ );
+        ast_node_ptr fields[max_fields];
+        for( size_t i = 0; i < field_counts[record.kind_]; ++i )
+            fields[i] = at( record.fields_at_ + i );
+        ast_node_ptr first = record.child_count_ > 0 ? at( record.children_at_ ) : nullptr;
+        ast_node_ptr second = record.child_count_ > 1 ? at( record.children_at_ + 1 ) : nullptr;
+        ast_node * node = nullptr;
+        switch( record.kind_ ) {
+            case Kind_node:
+                // Punctuation is shared in the arena, as the lexer would have made it
+                if( sym != nullptr && record.child_count_ == 0 && record.sibling_count_ == 0
+                 && ( record.flags_ & Has_sym ) && ast_arena::is_shared_token( name ) ) {
+                    nodes.push_back( arena.token( sym, record.type_ ) );
+                    continue;
+                }
+                node = new ast_node( record.type_, name, record.rule_nr_ );
+                break;
+            case Kind_empty:
+                node = new ast_empty_node( record.type_, name, record.rule_nr_ );
+                break;
+            case Kind_statement:
+                node = new ast_statement_node( fields[0], record.type_, name, record.rule_nr_ );
+                break;
+            case Kind_op:
+                node = new ast_op_node( fields[0], record.type_, name, record.rule_nr_ );
+                break;
+            case Kind_left_unary_op:
+                node = new ast_left_unary_op_node( fields[0], first, record.rule_nr_ );
+                break;
+            case Kind_right_unary_op:
+                node = new ast_right_unary_op_node( first.get(), fields[0].get(), record.rule_nr_ );
+                break;
+            case Kind_bin_op:
+                node = new ast_bin_op_node( first, fields[0], second, record.rule_nr_ );
+                break;
+            case Kind_function:
+                node = new ast_function_node( record.type_, name, fields[0], fields[1], fields[2], record.rule_nr_ );
+                break;
+            case Kind_branch_loop:
+                node = new ast_branch_loop_node( record.type_, fields[0], fields[1], fields[2], fields[3], record.rule_nr_ );
+                break;
+            case Kind_for_loop:
+                node = new ast_for_loop_node( fields[0], fields[1], fields[2], fields[3], fields[4], record.rule_nr_ );
+                break;
+            case Kind_ternary_op:
+                node = new ast_ternary_op_node( fields[0], fields[1], fields[2], fields[3], record.rule_nr_ );
+                break;
+        }
+        // What the constructors made of these gives way to what was saved
+        node->type_ = record.type_;
+        node->name_ = name;
+        node->rule_nr_ = record.rule_nr_;
+        node->sym_ = sym;
+        node->has_sym_ = record.flags_ & Has_sym;
+        node->extra_children_allowed_ = record.flags_ & Extra_children_allowed;
+        node->dummy_ = record.flags_ & Dummy;
+        node->child_nodes_.clear();
+        for( size_t i = 0; i < record.child_count_; ++i )
+            node->child_nodes_.push_back( at( record.children_at_ + i ) );
+        for( size_t i = 0; i < record.sibling_count_; ++i )
+            node->sibling_nodes_.push_back( at( record.siblings_at_ + i ) );
+        nodes.push_back( node );
+    }
+    if( nested )
+        nested->insert( nested->end(), included.begin(), included.end() );
+    return nodes[root - 1];
+}
+
+ast_node_ptr ast_cache::include( const jString & name, Lexer & including ) {
+    SymbolTable & symbol_table = *including.symbol_table_;
+    jString path;
+    std::FILE * file = Lexer::open_include( name, path );
+    if( ! file ) {
+        // Caching the including file would hide the error once this one appears
+        if( nested_ )
+            nested_->push_back( { name, 0 } );
+        return nullptr;
+    }
+    for( auto & open : parsing_ ) {
+        if( open == path ) {
+            std::fclose( file );
+            std::cerr << "@include of " << path << " from within itself\n";
+            return nullptr;
+        }
+    }
+    std::string text;
+    read_all( file, text );
+
+    uint64_t text_key = key( text );
+    if( nested_ )
+        nested_->push_back( { name, text_key } );
+    jString entry_path = entry_name( text_key );
+    std::string entry;
+    // The entry holds the items of the files this one included, so it is
+    // of no use once any of them has been lexed: they would be there twice
+    std::vector<nested_include> within;
+    if( read_file( entry_path, entry ) && nested_includes( entry, within ) ) {
+        bool fresh = true;
+        for( auto & file : within )
+            fresh = fresh && ! including.was_included( file.name_ );
+        ast_node_ptr items = fresh ? load( entry, text_key, text.size(), symbol_table, nested_ ) : nullptr;
+        if( items.isset() ) {
+            ++hits_;
+            for( auto & file : within )
+                including.note_included( file.name_ );
+            return items;
+        }
+    }
+    ++misses_;
+    std::vector<nested_include> nested;
+    std::vector<nested_include> * outer = nested_;
+    nested_ = &nested;
+    size_t skipped = including.program_lexer().skipped_includes_;
+    ast_node_ptr items = parse( path, text, including );
+    nested_ = outer;
+    // Nor is an entry kept that lacks a file this program had already
+    // lexed, as another program would need it
+    if( items.isset() && including.program_lexer().skipped_includes_ == skipped ) {
+        entry = save( items, text_key, text.size(), nested );
+        if( ! entry.empty() )
+            write_file( entry_path, entry );
+    }
+    if( nested_ )
+        nested_->insert( nested_->end(), nested.begin(), nested.end() );
+    return items;
+}
+
+ast_node_ptr ast_cache::parse( const jString & path, const std::string & text,
+                               Lexer & includer ) {
+    // The file is a program of its own, starting in the awk namespace;
+    // the tree it leaves in Lexer::ast_out is taken before the including
+    // program's parser can see it
+    ast_node_ptr including = Lexer::ast_out;
+    Lexer::ast_out = nullptr;
+    parsing_.push_back( path );
+    {
+        Lexer lexer( nullptr, nullptr, nullptr, nullptr, nullptr, 0, includer.symbol_table_, create_parser_() );
+        lexer.ast_cache_ = this;
+        lexer.including_ = &includer;
+        lexer.push_text( text.c_str() );
+        lexer.lex();
+    }
+    parsing_.pop_back();
+    ast_node_ptr program = Lexer::ast_out;
+    Lexer::ast_out = including;
+    if( ! program.isset() || program->child_nodes_.empty() )
+        return nullptr;
+    return program->child_nodes_[0];
+}
+}
@@ -19,18 +19,21 @@
 #include "../include/countedPointer.hpp"
 #include "../include/awkccc_ast.hpp"
 #include "../include/awkccc_lexer.hpp"
+#include "../include/awkccc_ast_cache.h++"
 #include "../include/jcargs.hpp"
 #include "parser.h++"
 #include <iostream>
 #include <cstdio>
+#include <cstdlib>
+#include <memory>
 #include <sstream>
 
 //using namespace jclib;
 using namespace awkccc;
 typedef void *(*malloc_t(size_t));
 typedef void *(*free_t(void *));
-#define ParseTOKENTYPE jclib::CountedPointer<ast_node>
-void Parse(void *pParser_, int tokenCode, ParseTOKENTYPE token_, jclib::CountedPointer<awkccc::ast_node> *);
+#define ParseTOKENTYPE ast_node_ptr
+void Parse(void *pParser_, int tokenCode, ParseTOKENTYPE token_, awkccc::ast_node_ptr *);
 void ParseTrace(FILE *stream, char *zPrefix);
 
 using namespace jclib;
@@ -104,21 +107,33 @@ int ymain(int argc, char * argv[]) {
 
 int main(int argc, char **argv) {
     
-    char buf_[25601];
     bool had_input = false;
     bool clean_tree = true;
     SymbolTable & the_symbol_table = SymbolTable::instance();
+    // Owns every node of the parse trees below
+    ast_arena nodes;
+    // @include files are parsed once & kept in $AWKCCC_CACHE, by default
+    // ~/.cache/awkccc. An empty AWKCCC_CACHE parses them every time
+    std::unique_ptr<ast_cache> included;
+    const char * cache_directory = std::getenv( "AWKCCC_CACHE" );
+    const char * home = std::getenv( "HOME" );
+    if( cache_directory == nullptr && home != nullptr )
+        included.reset( new ast_cache( jclib::jString( home ) + jclib::jString( "/.cache/awkccc" ) ) );
+    else if( cache_directory != nullptr && *cache_directory != '\0' )
+        included.reset( new ast_cache( jclib::jString( cache_directory ) ) );
     if( argc > 1 ) {
         for( int i = 1; i< argc; ++i ){
             if( argv[i][0] == ':'){
                 auto fname = argv[i]+1;
-                auto file = fopen(fname, "r");
-                auto len = fread(buf_, 1, 25600, file );
-                buf_[len]='\0';
-				std::cout << buf_ << "\n\n";
                 had_input = true;
                 PARSER_Parser *parser = PARSER_Parser::Create();
-                Lexer lexer (buf_,nullptr,nullptr,nullptr,nullptr,0,&the_symbol_table,parser);
+                // The file is read a buffer at a time as it is lexed
+                Lexer lexer (nullptr,nullptr,nullptr,nullptr,nullptr,0,&the_symbol_table,parser);
+                lexer.ast_cache_ = included.get();
+                if( ! lexer.include_file( fname ) ) {
+                    std::cerr << "cannot open " << fname << "\n";
+                    continue;
+                }
                 lexer.initialise_symbol_table();
                 lexer.lex();
                 if( Lexer::ast_out.isset()) {
@@ -133,13 +148,14 @@ int main(int argc, char **argv) {
     }
     if( ! had_input ) {
         //strcpy(buf_,"_p1 += 4;\nanswer=_p1+_param2[13.0]&!7;$1=a/7;$2~/a+b[/]+c+/;$3~/a+b[/]+c+/\n");
-        strcpy(buf_,
+        char buf_[] =
             "@include \"filename\"\n"
             "BEGIN {b+=a=1+2 < 3+4*5;\n}\n" 
             //"BEGIN {a=1;\nj=$1*$2+$3;\n}\n"
-            "END {print a; exit 3;}\n");
+            "END {print a; exit 3;}\n";
         PARSER_Parser *parser = PARSER_Parser::Create();
         Lexer lexer (buf_,nullptr,nullptr,nullptr,nullptr,0,&the_symbol_table,parser);
+        lexer.ast_cache_ = included.get();
         lexer.initialise_symbol_table();
         lexer.lex();
         if( clean_tree )
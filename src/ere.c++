@@ -0,0 +1,474 @@
+/***
+**
+** AWKCCC Translation of constant EREs to re2c matchers
+**
+** Copyright (C) 2024 Julia Ingleby Clement
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+***/
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include "../include/awkccc_ere.h++"
+
+namespace awkccc {
+    /**
+     * Recursive descent over an ERE, writing the re2c equivalent.
+     * Every character becomes its own quoted string or \xHH class member
+     * so nothing in the ERE can be mistaken for re2c syntax.
+    */
+    class ere_translator {
+        public:
+            std::string_view ere_;
+            size_t pos_ = 0;
+            size_t end_;
+            std::string why_;
+
+            ere_translator( std::string_view ere, size_t begin, size_t end )
+                : ere_( ere )
+                , pos_( begin )
+                , end_( end )
+                {}
+
+            bool fail( const char * why ) {
+                if( why_.empty() )
+                    why_ = why;
+                return false;
+            }
+            inline bool at_end() const {
+                return pos_ >= end_;
+            }
+            inline char peek() const {
+                return ere_[pos_];
+            }
+            static std::string hex( unsigned char c ) {
+                char buf[8];
+                std::snprintf( buf, sizeof buf, "\\x%02X", c );
+                return buf;
+            }
+            static std::string literal( unsigned char c ) {
+                if( std::isalnum( c ) || ( std::ispunct( c ) && c != '"' && c != '\\' ) || c == ' ' )
+                    return std::string( "\"" ) + char( c ) + "\"";
+                return "\"" + hex( c ) + "\"";
+            }
+            /** The character an escape outside or inside brackets stands for */
+            bool escape( unsigned char & c ) {
+                if( at_end() )
+                    return fail( "ERE ends with \\" );
+                char e = ere_[pos_++];
+                switch( e ) {
+                    case 'n': c = '\n'; return true;
+                    case 't': c = '\t'; return true;
+                    case 'r': c = '\r'; return true;
+                    case 'f': c = '\f'; return true;
+                    case 'v': c = '\v'; return true;
+                    case 'b': c = '\b'; return true;
+                    case 'a': c = '\a'; return true;
+                }
+                if( e >= '0' && e <= '7' ) {
+                    int value = e - '0';
+                    for( int digits = 1; digits < 3 && ! at_end() && peek() >= '0' && peek() <= '7'; ++digits )
+                        value = value * 8 + ( ere_[pos_++] - '0' );
+                    c = (unsigned char) value;
+                    return true;
+                }
+                if( std::strchr( "\\/\".[]()*+?{}|^$-", e ) != nullptr ) {
+                    c = e;
+                    return true;
+                }
+                return fail( "escape sequence awk doesn't define" );
+            }
+
+            bool alternation( std::string & out ) {
+                std::string branch_text;
+                if( ! branch( branch_text ) )
+                    return false;
+                out += branch_text.empty() ? "\"\"" : branch_text;
+                while( ! at_end() && peek() == '|' ) {
+                    ++pos_;
+                    branch_text.clear();
+                    if( ! branch( branch_text ) )
+                        return false;
+                    out += " | ";
+                    out += branch_text.empty() ? "\"\"" : branch_text;
+                }
+                return true;
+            }
+            bool branch( std::string & out ) {
+                while( ! at_end() && peek() != '|' && peek() != ')' ) {
+                    std::string item;
+                    if( ! atom( item ) || ! quantifiers( item ) )
+                        return false;
+                    if( ! out.empty() )
+                        out += ' ';
+                    out += item;
+                }
+                return true;
+            }
+            bool atom( std::string & out ) {
+                char c = ere_[pos_++];
+                switch( c ) {
+                    case '(': {
+                        std::string inner;
+                        if( ! at_end() && peek() == ')' )
+                            inner = "\"\"";
+                        else if( ! alternation( inner ) )
+                            return false;
+                        if( at_end() || peek() != ')' )
+                            return fail( "unbalanced (" );
+                        ++pos_;
+                        out = "(" + inner + ")";
+                        return true;
+                    }
+                    case '.':
+                        out = "[^]";
+                        return true;
+                    case '[':
+                        return bracket( out );
+                    case '\\': {
+                        unsigned char e;
+                        if( ! escape( e ) )
+                            return false;
+                        out = literal( e );
+                        return true;
+                    }
+                    case '^':
+                    case '$':
+                        return fail( "anchor inside the ERE" );
+                    case '*':
+                    case '+':
+                    case '?':
+                        return fail( "repetition with nothing to repeat" );
+                    default:
+                        out = literal( (unsigned char) c );
+                        return true;
+                }
+            }
+            /** Parse {n}, {n,} or {n,m} at pos_. False, without moving, if it isn't one */
+            bool interval( std::string & out ) {
+                size_t p = pos_ + 1;
+                auto number = [&]( std::string & digits ) {
+                    while( p < end_ && std::isdigit( (unsigned char) ere_[p] ) )
+                        digits += ere_[p++];
+                    return ! digits.empty();
+                };
+                std::string low, high;
+                if( ! number( low ) )
+                    return false;
+                bool comma = p < end_ && ere_[p] == ',';
+                if( comma ) {
+                    ++p;
+                    number( high );
+                }
+                if( p >= end_ || ere_[p] != '}' )
+                    return false;
+                pos_ = p + 1;
+                out = "{" + low + ( comma ? "," + high : std::string() ) + "}";
+                return true;
+            }
+            bool quantifiers( std::string & item ) {
+                bool quantified = false;
+                while( ! at_end() ) {
+                    std::string q;
+                    char c = peek();
+                    if( c == '*' || c == '+' || c == '?' ) {
+                        q = c;
+                        ++pos_;
+                    } else if( c != '{' || ! interval( q ) ) {
+                        break;
+                    }
+                    if( quantified )
+                        item = "(" + item + ")";
+                    item += q;
+                    quantified = true;
+                }
+                return true;
+            }
+            /** Add a POSIX [:name:] class to the members of a bracket expression */
+            bool character_class( const std::string & name, std::string & members ) {
+                static const struct { const char * name_; const char * ranges_; } classes[] = {
+                    { "alpha", "AZaz" }, { "digit", "09" }, { "alnum", "09AZaz" },
+                    { "upper", "AZ" }, { "lower", "az" }, { "xdigit", "09AFaf" },
+                    { "space", "\t\r  " }, { "blank", "\t\t  " },
+                    { "punct", "!/:@[`{~" }, { "print", " ~" }, { "graph", "!~" },
+                    { "cntrl", "\x01\x1F\x7F\x7F" } };
+                for( auto & entry : classes ) {
+                    if( name != entry.name_ )
+                        continue;
+                    if( name == "cntrl" )
+                        members += hex( 0 );
+                    for( const char * r = entry.ranges_; *r; r += 2 )
+                        members += hex( r[0] ) + "-" + hex( r[1] );
+                    return true;
+                }
+                return fail( "unknown character class" );
+            }
+            bool bracket( std::string & out ) {
+                std::string members;
+                bool negated = ! at_end() && peek() == '^';
+                if( negated )
+                    ++pos_;
+                bool first = true;
+                for(;;) {
+                    if( at_end() )
+                        return fail( "unterminated [" );
+                    unsigned char c = ere_[pos_++];
+                    if( c == ']' && ! first )
+                        break;
+                    first = false;
+                    if( c == '[' && ! at_end() && peek() == ':' ) {
+                        size_t close = ere_.find( ":]", pos_ + 1 );
+                        if( close == std::string_view::npos || close >= end_ )
+                            return fail( "unterminated [:" );
+                        if( ! character_class( std::string( ere_.substr( pos_ + 1, close - pos_ - 1 ) ), members ) )
+                            return false;
+                        pos_ = close + 2;
+                        continue;
+                    }
+                    if( c == '\\' && ! escape( c ) )
+                        return false;
+                    if( pos_ + 1 < end_ && peek() == '-' && ere_[pos_ + 1] != ']' ) {
+                        ++pos_;
+                        unsigned char high = ere_[pos_++];
+                        if( high == '\\' && ! escape( high ) )
+                            return false;
+                        if( high < c )
+                            return fail( "range out of order" );
+                        members += hex( c ) + "-" + hex( high );
+                    } else {
+                        members += hex( c );
+                    }
+                }
+                out = std::string( negated ? "[^" : "[" ) + members + "]";
+                return true;
+            }
+    };
+
+    /** Step begin & end past a leading ^ & trailing $ */
+    static void strip_anchors( std::string_view ere, size_t & begin, size_t & end,
+                               bool & anchored_start, bool & anchored_end ) {
+        begin = 0;
+        end = ere.size();
+        anchored_start = end > 0 && ere[0] == '^';
+        if( anchored_start )
+            ++begin;
+        anchored_end = false;
+        if( end > begin && ere[end - 1] == '$' ) {
+            // An escaped $ is a literal, count the backslashes before it
+            size_t slashes = 0;
+            while( end - 1 - slashes > begin && ere[end - 2 - slashes] == '\\' )
+                ++slashes;
+            if( slashes % 2 == 0 ) {
+                anchored_end = true;
+                --end;
+            }
+        }
+    }
+
+    /** Skip a bracket expression, pos just after its [ */
+    static size_t skip_bracket( std::string_view ere, size_t pos, size_t end ) {
+        if( pos < end && ere[pos] == '^' )
+            ++pos;
+        if( pos < end && ere[pos] == ']' )
+            ++pos;
+        while( pos < end && ere[pos] != ']' ) {
+            if( ere[pos] == '[' && pos + 1 < end && ere[pos + 1] == ':' ) {
+                size_t close = ere.find( ":]", pos + 2 );
+                pos = close == std::string_view::npos ? end : close + 2;
+            } else {
+                pos += ere[pos] == '\\' ? 2 : 1;
+            }
+        }
+        return pos + 1;
+    }
+
+    bool ere_literal( std::string_view ere, Awkccc_ere_literal & answer ) {
+        size_t begin, end;
+        bool anchored_start, anchored_end;
+        strip_anchors( ere, begin, end, anchored_start, anchored_end );
+        ere_translator scan( ere, begin, end );
+        std::string run;
+        bool literal = true;
+        int depth = 0;
+        answer = Awkccc_ere_literal();
+        // Runs of literal characters outside any group are in every match
+        auto keep = [&]() {
+            if( run.size() > answer.literal_.size() )
+                answer.literal_ = run;
+            run.clear();
+        };
+        while( ! scan.at_end() ) {
+            char c = ere[scan.pos_++];
+            unsigned char character = c;
+            bool is_literal = c == '\\' || std::strchr( ".[]()*+?{}|^$", c ) == nullptr;
+            if( c == '\\' && ! scan.escape( character ) )
+                return false;
+            if( is_literal ) {
+                char next = scan.at_end() ? 0 : scan.peek();
+                if( next == '*' || next == '?' || next == '{' ) {
+                    // Optional or repeated, the run can't carry on through it
+                    literal = false;
+                    keep();
+                    continue;
+                }
+                if( depth == 0 )
+                    run += char( character );
+                if( next == '+' )
+                    keep();
+                continue;
+            }
+            literal = false;
+            keep();
+            if( c == '|' && depth == 0 ) {
+                // Matches needn't contain anything from one alternative
+                answer.literal_.clear();
+                return true;
+            }
+            if( c == '(' )
+                ++depth;
+            else if( c == ')' )
+                --depth;
+            else if( c == '[' )
+                scan.pos_ = skip_bracket( ere, scan.pos_, end );
+        }
+        keep();
+        if( literal )
+            answer.shape_ = anchored_start ? ( anchored_end ? Ere_Exact : Ere_Prefix )
+                                           : ( anchored_end ? Ere_Suffix : Ere_Literal );
+        return true;
+    }
+
+    bool ere_to_re2c( std::string_view ere, Awkccc_re2c_regex & answer, std::string & why ) {
+        size_t begin, end;
+        strip_anchors( ere, begin, end, answer.anchored_start_, answer.anchored_end_ );
+        ere_translator translator( ere, begin, end );
+        answer.regex_.clear();
+        bool ok = translator.alternation( answer.regex_ );
+        if( ok && ! translator.at_end() )
+            ok = translator.fail( "unbalanced )" );
+        if( ok && ( answer.anchored_start_ || answer.anchored_end_ )
+               && answer.regex_.find( " | " ) != std::string::npos ) {
+            // The anchor would belong to one alternative only, check it is outside any
+            int depth = 0;
+            for( size_t i = begin; i < end; ++i ) {
+                char c = ere[i];
+                if( c == '\\' )
+                    ++i;
+                else if( c == '[' )
+                    i = ere.find( ']', i + 2 );
+                else if( c == '(' )
+                    ++depth;
+                else if( c == ')' )
+                    --depth;
+                else if( c == '|' && depth == 0 )
+                    ok = translator.fail( "anchor with alternation" );
+                if( i == std::string_view::npos )
+                    break;
+            }
+        }
+        why = translator.why_;
+        return ok;
+    }
+
+    /** text as a C++ string literal. Octal escapes can't run into the next character */
+    static std::string cpp_literal( std::string_view text ) {
+        std::string answer = "\"";
+        for( unsigned char c : text ) {
+            if( c == '"' || c == '\\' ) {
+                answer += '\\';
+                answer += c;
+            } else if( std::isprint( c ) ) {
+                answer += c;
+            } else {
+                char buf[8];
+                std::snprintf( buf, sizeof buf, "\\%03o", c );
+                answer += buf;
+            }
+        }
+        return answer + "\"";
+    }
+
+    /** The body of a matcher that needs no DFA */
+    static std::string literal_matcher( const Awkccc_ere_literal & literal ) {
+        const std::string text = cpp_literal( literal.literal_ );
+        const std::string size = std::to_string( literal.literal_.size() );
+        switch( literal.shape_ ) {
+            case Ere_Literal:
+                if( literal.literal_.empty() )
+                    return "    return true;\n";
+                if( literal.literal_.size() == 1 )
+                    return "    return std::memchr( text.data(), " + std::to_string( (unsigned char) literal.literal_[0] )
+                         + ", text.size() ) != nullptr;\n";
+                return "    return memmem( text.data(), text.size(), " + text + ", " + size + " ) != nullptr;\n";
+            case Ere_Prefix:
+                return "    return text.size() >= " + size + " && std::memcmp( text.data(), " + text + ", " + size + " ) == 0;\n";
+            case Ere_Suffix:
+                return "    return text.size() >= " + size + " && std::memcmp( text.data() + text.size() - " + size
+                     + ", " + text + ", " + size + " ) == 0;\n";
+            case Ere_Exact:
+                return "    return text == std::string_view( " + text + ", " + size + " );\n";
+            default:
+                return "";
+        }
+    }
+
+    bool ere_matcher( std::string_view ere, const std::string & name, std::string & code, std::string & why ) {
+        Awkccc_re2c_regex regex;
+        if( ! ere_to_re2c( ere, regex, why ) )
+            return false;
+        Awkccc_ere_literal literal;
+        ere_literal( ere, literal );
+        code = "/// /" + std::string( ere ) + "/\n";
+        code += "bool " + name + "( std::string_view text ) {\n";
+        if( literal.shape_ != Ere_General ) {
+            code += literal_matcher( literal ) + "}\n";
+            return true;
+        }
+        if( ! literal.literal_.empty() ) {
+            // Most text won't contain the literal, memmem rejects it faster than the DFA
+            code += "    if( memmem( text.data(), text.size(), " + cpp_literal( literal.literal_ ) + ", "
+                  + std::to_string( literal.literal_.size() ) + " ) == nullptr )\n"
+                    "        return false;\n";
+        }
+        code += "    const unsigned char * YYCURSOR = reinterpret_cast<const unsigned char *>( text.data() );\n"
+                "    const unsigned char * const YYLIMIT = YYCURSOR + text.size();\n"
+                "    const unsigned char * YYMARKER = YYCURSOR;\n"
+                "    (void) YYLIMIT;\n"
+                "    (void) YYMARKER;\n"
+                "    /*!re2c\n"
+                "        re2c:api = custom;\n"
+                "        re2c:api:style = free-form;\n"
+                "        re2c:define:YYCTYPE = \"unsigned char\";\n"
+                "        re2c:define:YYPEEK = \"( YYCURSOR < YYLIMIT ? *YYCURSOR : 0 )\";\n"
+                "        re2c:define:YYSKIP = \"++YYCURSOR;\";\n"
+                "        re2c:define:YYBACKUP = \"YYMARKER = YYCURSOR;\";\n"
+                "        re2c:define:YYRESTORE = \"YYCURSOR = YYMARKER;\";\n"
+                "        re2c:define:YYLESSTHAN = \"YYLIMIT - YYCURSOR < @@{len}\";\n"
+                "        re2c:yyfill:enable = 0;\n"
+                "        re2c:eof = 0;\n\n";
+        // Unanchored, [^]* lets the match start anywhere. Longest match
+        // semantics mean a match ending at YYLIMIT is found if there is one
+        code += "        ";
+        if( ! regex.anchored_start_ )
+            code += "[^]* ";
+        code += "(" + regex.regex_ + ")";
+        code += regex.anchored_end_ ? " { return YYCURSOR == YYLIMIT; }\n" : " { return true; }\n";
+        code += "        * { return false; }\n"
+                "        $ { return false; }\n"
+                "    */\n"
+                "    // Only reached if re2c hasn't made the block above into a DFA\n"
+                "    return awkccc::regex_cache().matches( text, " + cpp_literal( ere ) + " );\n"
+                "}\n";
+        return true;
+    }
+} // namespace awkccc
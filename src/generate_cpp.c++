@@ -20,6 +20,7 @@
 #include "../include/jString.hpp"
 #include "../include/Save.hpp"
 #include "../include/awkccc.h++"
+#include "../include/awkccc_ere.h++"
 using namespace jclib;
 
 namespace awkccc {
@@ -29,7 +30,7 @@ namespace awkccc {
     class ast_to_cpp: public ast_node_visitor {
         public:
             struct cpp_generator_ctl {
-                CountedPointer<ast_node> node_;
+                ast_node_ptr node_;
                 jclib::jString padding_;
                 bool include_children_;
                 bool include_siblings_;
@@ -40,6 +41,8 @@ namespace awkccc {
             std::vector<postream > & code_;
             postream out_;
             cpp_generator_ctl ctl_;
+            /// What emit_parallel_plan() found, which decides how reduced variables are declared
+            Awkccc_parallel_plan parallel_plan_;
             /// @brief Construct with supplied code segment array. To support unit testing.
             /// @param node The top level node in the AST
             /// @param code code segment array
@@ -76,7 +79,123 @@ namespace awkccc {
                 }
             }
             void traverse() {
+                flatten_concatenations( ctl_.node_ );
                 ctl_.node_->accept( this );
+                emit_runtime_hints();
+            }
+            /// Tell the runtime what the analysis passes found out about the program
+            void emit_runtime_hints() {
+                postream vars = code_[template_VARS];
+                Awkccc_field_usage fields = analyse_field_usage( ctl_.node_ );
+                (*vars) << "const awkccc::Awkccc_field_usage awkccc_field_usage_ = { "
+                        << fields.max_field_ << ", "
+                        << ( fields.uses_nf_ ? "true" : "false" ) << ", "
+                        << ( fields.dynamic_field_ ? "true" : "false" ) << " };\n";
+                // a[i,j] can hash its subscripts against a constant SUBSEP
+                (*vars) << "const bool awkccc_subsep_fixed_ = "
+                        << ( uses_variable( ctl_.node_, "SUBSEP" ) ? "false" : "true" ) << ";\n";
+                // Fields kept as keys or values are shared through intern_table()
+                (*vars) << "const bool awkccc_intern_fields_ = "
+                        << ( keeps_fields( ctl_.node_ ) ? "true" : "false" ) << ";\n";
+                emit_parallel_plan();
+                emit_ere_matchers();
+                emit_variable_types();
+            }
+            /** A declaration for each variable: native where analyse_variable_types()
+             *  proved a single type, otherwise the runtime's own classes.
+             *  A variable --parallel reduces is native only as a number
+             *  summed or kept as a maximum or minimum: the reductions
+             *  awkccc_parallel.h++ has for int64_t & double. One reduced to
+             *  its last value is an Awkccc_last_variable, which knows
+             *  whether a shard assigned it */
+            void emit_variable_types() {
+                std::vector<Awkccc_variable_type> types = analyse_variable_types( ctl_.node_ );
+                if( types.empty() )
+                    return;
+                postream vars = code_[template_VARS];
+                bool integers = false;
+                (*vars) << "// Variables: native types where only numbers or only strings are assigned\n";
+                for( auto & variable : types ) {
+                    Awkccc_static_type type = variable.type_;
+                    bool last_value = false;
+                    for( auto & reducer : parallel_plan_.reducers_ ) {
+                        if( reducer.c_name_ != variable.c_name_ || type == Static_Array )
+                            continue;
+                        if( reducer.reduction_ == Reduce_Last )
+                            last_value = true;
+                        else if( type == Static_String )
+                            type = Static_Dynamic;
+                    }
+                    if( last_value ) {
+                        (*vars) << "awkccc::Awkccc_last_variable " << variable.c_name_ << ";\n";
+                        continue;
+                    }
+                    switch( type ) {
+                        case Static_Integer:
+                            (*vars) << "int64_t " << variable.c_name_ << " = 0;\n";
+                            integers = true;
+                            break;
+                        case Static_Number:
+                            (*vars) << "double " << variable.c_name_ << " = 0;\n";
+                            break;
+                        case Static_String:
+                            (*vars) << "jclib::jString " << variable.c_name_ << ";\n";
+                            break;
+                        case Static_Array:
+                            (*vars) << "awkccc::Awkccc_array " << variable.c_name_ << ";\n";
+                            break;
+                        default:
+                            (*vars) << "awkccc::Awkccc_variable " << variable.c_name_ << ";\n";
+                            break;
+                    }
+                }
+                if( integers )
+                    (*code_[template_INCLUDES]) << "#include <cstdint>\n";
+            }
+            /** A DFA matcher function for each constant ERE, awkccc_ere_0, awkccc_ere_1...
+             *  numbered in the order find_ere_literals() returns them. Run
+             *  through re2c they match with a DFA; compiled as they are they
+             *  fall back to the runtime's regex cache */
+            void emit_ere_matchers() {
+                std::vector<std::string> eres = find_ere_literals( ctl_.node_ );
+                if( eres.empty() )
+                    return;
+                postream includes = code_[template_INCLUDES];
+                postream procs = code_[template_PROCS];
+                (*includes) << "#include <cstring>\n"
+                            << "#include <string_view>\n"
+                            << "// Constant EREs are matched by re2c blocks: without re2c they use the regex cache\n";
+                for( size_t i = 0; i < eres.size(); ++i ) {
+                    std::string code, why;
+                    if( ere_matcher( eres[i], "awkccc_ere_" + std::to_string( i ), code, why ) )
+                        (*procs) << code;
+                    else
+                        (*procs) << "// /" << eres[i] << "/ is matched at runtime: " << why << "\n";
+                }
+            }
+            /// The hooks Awkccc_parallel_driver needs, or why --parallel must run sequentially
+            void emit_parallel_plan() {
+                postream vars = code_[template_VARS];
+                postream procs = code_[template_PROCS];
+                parallel_plan_ = analyse_parallel( ctl_.node_ );
+                Awkccc_parallel_plan & plan = parallel_plan_;
+                (*vars) << "const bool awkccc_parallel_safe_ = " << ( plan.safe_ ? "true" : "false" ) << ";\n";
+                (*vars) << "const bool awkccc_parallel_ordered_ = " << ( plan.ordered_output_ ? "true" : "false" ) << ";\n";
+                if( ! plan.safe_ ) {
+                    (*vars) << "// --parallel runs sequentially: " << plan.reason_ << "\n";
+                    return;
+                }
+                (*procs) << "void start_shard() {\n";
+                for( auto & reducer : plan.reducers_ )
+                    (*procs) << "    awkccc::start_reduction( " << reducer.c_name_ << ", "
+                             << reduction_name( reducer.reduction_ ) << " );\n";
+                (*procs) << "}\n";
+                (*procs) << "template< typename Program >\n"
+                         << "void merge_shard( const Program & shard ) {\n";
+                for( auto & reducer : plan.reducers_ )
+                    (*procs) << "    awkccc::reduce( " << reducer.c_name_ << ", shard." << reducer.c_name_ << ", "
+                             << reduction_name( reducer.reduction_ ) << " );\n";
+                (*procs) << "}\n";
             }
             void print_header( ast_node * node ){
                 (*out_) << ctl_.padding_ << ctl_.extra_ << node->name_;
@@ -17,29 +17,197 @@
 ** limitations under the License.
 ***/
 #include <algorithm>
-#include <map>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
 #include "../include/awkccc_ast.hpp"
 #include "../src/parser.h++"
 #include "../include/awkccc_lexer.hpp"
+#include "../include/awkccc_ast_cache.h++"
 
 #include "../include/jString.hpp"
 using namespace awkccc;
 using namespace jclib;
 
-jclib::CountedPointer<awkccc::ast_node> Lexer::ast_out;
-
-typedef std::map<jclib::jString, jclib::CountedPointer<Symbol> > map_t;
+awkccc::ast_node_ptr Lexer::ast_out;
 
 namespace {
     jclib::jString Empty_Str;
     jclib::jString Awk("Awk");
+
+    inline std::string_view view( const jclib::jString & text ) {
+        return std::string_view( (const char *) text, text.len() );
+    }
+
+    inline jclib::jString to_string( std::string_view text ) {
+        if( text.empty() )
+            return Empty_Str;
+        return jclib::jString( text.data(), text.data() + text.size() );
+    }
+
+    /// FNV-1a over namespace & name
+    inline uint64_t hash_symbol( std::string_view awk_namespace, std::string_view awk_name ) {
+        uint64_t hash = 14695981039346656037ull;
+        for( unsigned char c : awk_namespace )
+            hash = ( hash ^ c ) * 1099511628211ull;
+        hash = ( hash ^ ':' ) * 1099511628211ull;
+        for( unsigned char c : awk_name )
+            hash = ( hash ^ c ) * 1099511628211ull;
+        return hash;
+    }
+
+    /// hash moved to another place by displacement, as the perfect hash probes it
+    inline uint64_t displace( uint64_t hash, uint32_t displacement ) {
+        hash += displacement * 0x9e3779b97f4a7c15ull;
+        hash = ( hash ^ ( hash >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+        hash = ( hash ^ ( hash >> 27 ) ) * 0x94d049bb133111ebull;
+        return hash ^ ( hash >> 31 );
+    }
+
+    /**
+     * The keywords, operators & builtins Lexer::initialise_symbol_table
+     * loads. They don't change once loaded, so they are held in a perfect
+     * hash: every key has a slot of its own, & a lookup hashes the name,
+     * reads one displacement & one slot & compares one key.
+     *
+     * The hash is made from the loader lists the first time it is needed,
+     * hash & displace style: keys are grouped into buckets, & each bucket,
+     * largest first, is given the first displacement that puts all its keys
+     * in empty slots. Loading the same lists again, as every Lexer does,
+     * replaces the symbols in place without making it again.
+    */
+    class fixed_symbols {
+        public:
+            Symbol * find( std::string_view awk_namespace, std::string_view awk_name, uint64_t hash ) {
+                if( stale_ )
+                    rebuild();
+                int32_t index = lookup( awk_namespace, awk_name, hash );
+                return index < 0 ? nullptr : symbols_[index].get();
+            }
+            void insert( jclib::CountedPointer<Symbol> sym ) {
+                std::string_view awk_namespace = view( sym->awk_namespace_ );
+                std::string_view awk_name = view( sym->awk_name_ );
+                uint64_t hash = hash_symbol( awk_namespace, awk_name );
+                int32_t index = stale_ ? scan( awk_namespace, awk_name, hash ) : lookup( awk_namespace, awk_name, hash );
+                if( index >= 0 ) {
+                    symbols_[index] = sym;
+                } else {
+                    symbols_.push_back( sym );
+                    hashes_.push_back( hash );
+                    stale_ = true;
+                }
+            }
+        private:
+            /// A bucket that no displacement up to this fits makes the table grow
+            static constexpr uint32_t max_displacement_ = 1 << 16;
+            std::vector<jclib::CountedPointer<Symbol> > symbols_;
+            std::vector<uint64_t> hashes_;
+            /// Index into symbols_ of the key in each slot, -1 if none
+            std::vector<int32_t> slots_;
+            std::vector<uint32_t> displacements_;
+            /// Symbols have been added since the hash was made
+            bool stale_ = false;
+
+            bool matches( int32_t index, std::string_view awk_namespace, std::string_view awk_name, uint64_t hash ) {
+                return hashes_[index] == hash
+                    && view( symbols_[index]->awk_name_ ) == awk_name
+                    && view( symbols_[index]->awk_namespace_ ) == awk_namespace;
+            }
+            int32_t lookup( std::string_view awk_namespace, std::string_view awk_name, uint64_t hash ) {
+                if( slots_.empty() )
+                    return -1;
+                uint32_t displacement = displacements_[hash % displacements_.size()];
+                int32_t index = slots_[displace( hash, displacement ) & ( slots_.size() - 1 )];
+                return index >= 0 && matches( index, awk_namespace, awk_name, hash ) ? index : -1;
+            }
+            /// While loading, before there is a hash to look in
+            int32_t scan( std::string_view awk_namespace, std::string_view awk_name, uint64_t hash ) {
+                for( size_t i = 0; i < symbols_.size(); ++i )
+                    if( matches( i, awk_namespace, awk_name, hash ) )
+                        return i;
+                return -1;
+            }
+            void rebuild() {
+                stale_ = false;
+                size_t size = 1;
+                while( size < symbols_.size() + symbols_.size() / 4 + 1 )
+                    size *= 2;
+                while( ! place( size ) )
+                    size *= 2;
+            }
+            bool place( size_t size ) {
+                size_t bucket_count = symbols_.size() / 2 + 1;
+                std::vector<std::vector<int32_t> > buckets( bucket_count );
+                for( size_t i = 0; i < symbols_.size(); ++i )
+                    buckets[hashes_[i] % bucket_count].push_back( i );
+                std::vector<size_t> order( bucket_count );
+                for( size_t b = 0; b < bucket_count; ++b )
+                    order[b] = b;
+                std::stable_sort( order.begin(), order.end(), [&buckets]( size_t left, size_t right ) {
+                    return buckets[left].size() > buckets[right].size();
+                } );
+                slots_.assign( size, -1 );
+                displacements_.assign( bucket_count, 0 );
+                std::vector<size_t> taken;
+                for( size_t b : order ) {
+                    auto & bucket = buckets[b];
+                    if( bucket.empty() )
+                        break;
+                    for( uint32_t displacement = 0; ; ++displacement ) {
+                        if( displacement == max_displacement_ )
+                            return false;
+                        taken.clear();
+                        for( int32_t index : bucket ) {
+                            size_t slot = displace( hashes_[index], displacement ) & ( size - 1 );
+                            if( slots_[slot] >= 0 || std::find( taken.begin(), taken.end(), slot ) != taken.end() )
+                                break;
+                            taken.push_back( slot );
+                        }
+                        if( taken.size() == bucket.size() ) {
+                            for( size_t k = 0; k < taken.size(); ++k )
+                                slots_[taken[k]] = bucket[k];
+                            displacements_[b] = displacement;
+                            break;
+                        }
+                    }
+                }
+                return true;
+            }
+    };
+
+    /// A user symbol's namespace & name, viewing the Symbol's own text
+    struct user_key {
+        std::string_view awk_namespace_;
+        std::string_view awk_name_;
+        uint64_t hash_;
+        bool operator == ( const user_key & other ) const {
+            return awk_name_ == other.awk_name_ && awk_namespace_ == other.awk_namespace_;
+        }
+    };
+    struct user_key_hash {
+        size_t operator()( const user_key & key ) const {
+            return key.hash_;
+        }
+    };
 }
+
+/**
+ * Keywords, operators & builtins are found in a perfect hash, the names
+ * the program makes up in a hash table keyed by namespace & name, so a
+ * lookup costs the same however large the script.
+*/
 class SymbolTableImpl : public SymbolTable {
     public:
-        map_t sym_table_;
+        fixed_symbols fixed_;
+        std::unordered_map<user_key, jclib::CountedPointer<Symbol>, user_key_hash> user_symbols_;
+
         virtual void insert(jclib::CountedPointer<Symbol>s) {
-            sym_table_[s->awk_name_] = s;
+            fixed_.insert( s );
         }
         
         virtual Symbol * insert(
@@ -53,16 +221,23 @@ class SymbolTableImpl : public SymbolTable {
             const char * returns = "",
             const char * include = "" ) {
             Symbol * sym = new Symbol( awk_namespace, awk_name, c_name, token, type, is_built_in, args, returns, include );
-            sym_table_[sym->awk_name_] = sym;
+            fixed_.insert( sym );
             return sym;
         }
 
         virtual Symbol * find( jclib::jString &awk_namespace, jclib::jString &awk_name ) {
-            jclib::jString str = ( awk_namespace.len( ) == 0 )
-                ? ( awk_namespace + "::" + awk_name )
-                : awk_name;
-            auto search = sym_table_.find(str);
-            if (search == sym_table_.end()) {
+            return find( view( awk_namespace ), view( awk_name ) );
+        }
+
+        virtual Symbol * find( std::string_view awk_namespace, std::string_view awk_name ) {
+            return find( awk_namespace, awk_name, hash_symbol( awk_namespace, awk_name ) );
+        }
+
+        Symbol * find( std::string_view awk_namespace, std::string_view awk_name, uint64_t hash ) {
+            if( Symbol * fixed = fixed_.find( awk_namespace, awk_name, hash ) )
+                return fixed;
+            auto search = user_symbols_.find( user_key{ awk_namespace, awk_name, hash } );
+            if (search == user_symbols_.end()) {
                 return nullptr;
             }
             return search->second.get();
@@ -77,26 +252,41 @@ class SymbolTableImpl : public SymbolTable {
                 int token,
                 bool namespace_required, /// true if forced by code
                 SymbolType type = VARIABLE) {
+            return get( view( awk_namespace ), view( name ), token, namespace_required, type, &awk_namespace, &name );
+        }
+
+        virtual Symbol * get( 
+                std::string_view awk_namespace,
+                std::string_view name,
+                int token,
+                bool namespace_required,
+                SymbolType type = VARIABLE) {
+            return get( awk_namespace, name, token, namespace_required, type, nullptr, nullptr );
+        }
+
+        /**
+         * The strings a new symbol keeps are made only when it is new,
+         * from namespace_string & name_string if the caller has them
+        */
+        Symbol * get( 
+                std::string_view awk_namespace,
+                std::string_view name,
+                int token,
+                bool namespace_required,
+                SymbolType type,
+                const jclib::jString * namespace_string,
+                const jclib::jString * name_string ) {
             if( ! namespace_required )
-                if( Symbol * exact = find(Empty_Str,name) )
-                    return exact;
-            auto parts = name.split("::",1);
-            auto size = parts.size();
-            jString namespace_;
-            jString c_name;
-            if( size == 1 ) {
-                /*
-                    c_name = jString("Awk::")+name;
-                    name = jString("Awk::")+name;
-                */
-               namespace_ = awk_namespace;
-            } else {
-                // c_name = parts[0]+jString("::")+parts[1];
-                namespace_ = parts[0];
-            }
-            if( Symbol * answer = find(namespace_,name) )
+                if( Symbol * global = find( std::string_view(), name, hash_symbol( std::string_view(), name ) ) )
+                    return global;
+            uint64_t hash = hash_symbol( awk_namespace, name );
+            if( Symbol * answer = find( awk_namespace, name, hash ) )
                 return answer;
-            return insert( namespace_, name, name, token, type, false );
+            jclib::jString stored_namespace = namespace_string ? *namespace_string : to_string( awk_namespace );
+            jclib::jString stored_name = name_string ? *name_string : to_string( name );
+            jclib::CountedPointer<Symbol> sym = new Symbol( stored_namespace, stored_name, stored_name, token, type, false );
+            user_symbols_.emplace( user_key{ view( sym->awk_namespace_ ), view( sym->awk_name_ ), hash }, sym );
+            return sym.get();
         }
         static SymbolTable * the_table_;
         static SymbolTable & instance() {
@@ -119,7 +309,7 @@ class SymbolTableImpl : public SymbolTable {
 
         virtual void load(std::initializer_list<struct _Symbol_loader> input) {
             for( auto i : input) {
-                insert( i.awk_namespace_, i.awk_name_, i.c_name_, i.token_, i.type_, i.is_built_in_, i.returns_, i.args_, i.include_ );
+                insert( i.awk_namespace_, i.awk_name_, i.c_name_, i.token_, i.type_, i.is_built_in_, i.args_, i.returns_, i.include_ );
             }
         }
 
@@ -145,7 +335,7 @@ class SymbolTableImpl : public SymbolTable {
                 //strcpy(c_target,i.name_);
                 jclib::jString cname = i.name_;
                 cname = cname + "_";
-                insert( namespace_name, i.name_, cname, i.token_, i.type_, false);
+                insert( namespace_name, i.name_, cname, i.token_, i.type_, i.is_built_in_ );
             }
             if( also_load_global )
                 loadnamespace("Awk",false,input);
@@ -169,7 +359,7 @@ SymbolTable & SymbolTable::reset_instance() {
 // interface to musami generated parser
 // TODO: make the parser a class
 
-#define ParseTOKENTYPE jclib::CountedPointer<ast_node>
+#define ParseTOKENTYPE ast_node_ptr
 typedef void *(*malloc_t(size_t));
 typedef void *(*free_t(void *));
 void ParseTrace(FILE *stream, char *zPrefix);
@@ -177,17 +367,190 @@ int PARSER_char_to_token( char chr );
 
 // Lexer implementation. The generated Lexer::lex is in lexer.c++
 
-void Lexer::parse(int token_code, SymbolType type ) {
-	size_t stringlen=buf_-tok_;
-    token_ = jString(tok_,buf_);
-    auto sym=symbol_table_->get(Empty_Str, token_, false, token_code, type);
-    auto ast = new awkccc::ast_node(Expression, sym );
+Lexer_source::Lexer_source( const char * text, size_t buffer_size )
+: text_( text )
+, text_left_( std::strlen( text ) )
+, buffer_( buffer_size )
+{}
+
+size_t Lexer_source::read( char * into, size_t size ) {
+    if( file_ )
+        return std::fread( into, 1, size, file_ );
+    size = std::min( size, text_left_ );
+    std::memcpy( into, text_, size );
+    text_ += size;
+    text_left_ -= size;
+    return size;
+}
+
+bool Lexer::fill( size_t need ) {
+    if( sources_.empty() )
+        return false;
+    Lexer_source & in = *sources_.back();
+    if( in.eof_ )
+        return false;
+    // Every token before the one being scanned has been parsed, so only
+    // this one is kept, moved to the start of the buffer
+    size_t kept = lim_ - tok_;
+    size_t cursor = buf_ - tok_;
+    size_t marker = mar_ >= tok_ && mar_ <= lim_ ? mar_ - tok_ : 0;
+    size_t size = std::max( buffer_size_, kept + need + padding_ );
+    if( in.buffer_.size() < size ) {
+        std::vector<char> bigger( std::max( size, in.buffer_.size() * 2 ) );
+        if( kept > 0 )
+            std::memcpy( bigger.data(), tok_, kept );
+        in.buffer_.swap( bigger );
+    } else if( kept > 0 ) {
+        std::memmove( in.buffer_.data(), tok_, kept );
+    }
+    tok_ = in.buffer_.data();
+    buf_ = tok_ + cursor;
+    mar_ = tok_ + marker;
+    lim_ = tok_ + kept;
+    size_t room = in.buffer_.size() - padding_ - kept;
+    size_t got = in.read( lim_, room );
+    lim_ += got;
+    if( got < room ) {
+        in.eof_ = true;
+        std::memset( lim_, 0, padding_ );
+        lim_ += padding_;
+    }
+    return true;
+}
+
+void Lexer::push_source( Lexer_source * source ) {
+    if( ! sources_.empty() ) {
+        sources_.back()->resume_cursor_ = buf_;
+        sources_.back()->resume_limit_ = lim_;
+    }
+    sources_.emplace_back( source );
+    tok_ = buf_ = lim_ = mar_ = source->buffer_.data();
+}
+
+void Lexer::push_text( const char * text ) {
+    push_source( new Lexer_source( text, buffer_size_ ) );
+}
+
+std::FILE * Lexer::open_include( const jString & name, jString & path ) {
+    path = name;
+    std::FILE * file = std::fopen( path, "r" );
+    if( ! file ) {
+        path = name + jString( ".awk" );
+        file = std::fopen( path, "r" );
+    }
+    return file;
+}
+
+namespace {
+    /// The device & inode of an open file, false if fstat fails
+    bool file_identity( std::FILE * file, std::pair<dev_t, ino_t> & id ) {
+        struct stat status;
+        if( fstat( fileno( file ), &status ) != 0 )
+            return false;
+        id = std::pair<dev_t, ino_t>( status.st_dev, status.st_ino );
+        return true;
+    }
+}
+
+bool Lexer::first_inclusion( std::FILE * file ) {
+    Lexer & program = program_lexer();
+    std::pair<dev_t, ino_t> id;
+    if( ! file_identity( file, id ) )
+        return true;
+    if( std::find( program.included_.begin(), program.included_.end(), id ) != program.included_.end() ) {
+        ++program.skipped_includes_;
+        return false;
+    }
+    program.included_.push_back( id );
+    return true;
+}
+
+bool Lexer::was_included( const jString & name ) {
+    jString path;
+    std::FILE * file = open_include( name, path );
+    if( ! file )
+        return false;
+    Lexer & program = program_lexer();
+    std::pair<dev_t, ino_t> id;
+    bool found = file_identity( file, id )
+        && std::find( program.included_.begin(), program.included_.end(), id ) != program.included_.end();
+    std::fclose( file );
+    return found;
+}
+
+void Lexer::note_included( const jString & name ) {
+    jString path;
+    std::FILE * file = open_include( name, path );
+    if( ! file )
+        return;
+    Lexer & program = program_lexer();
+    std::pair<dev_t, ino_t> id;
+    if( file_identity( file, id )
+     && std::find( program.included_.begin(), program.included_.end(), id ) == program.included_.end() )
+        program.included_.push_back( id );
+    std::fclose( file );
+}
+
+bool Lexer::include_file( const jString & name ) {
+    jString path;
+    std::FILE * file = open_include( name, path );
+    if( ! file )
+        return false;
+    if( ! first_inclusion( file ) ) {
+        std::fclose( file );
+        return true;
+    }
+    push_source( new Lexer_source( path, file, buffer_size_ ) );
+    return true;
+}
+
+bool Lexer::end_of_source() {
+    // The last source stays, so the end token's text is still there to parse
+    if( sources_.size() < 2 )
+        return false;
+    sources_.pop_back();
+    buf_ = sources_.back()->resume_cursor_;
+    lim_ = sources_.back()->resume_limit_;
+    return true;
+}
+
+void Lexer::pass_to_parser( Symbol * sym ) {
+    auto ast = awkccc::ast_arena::current().token( sym );
     parser_->parse( sym->token_, ast, & ast_out  );
     allow_regex_ = false; 
 }
 
+void Lexer::parse(int token_code, SymbolType type ) {
+    pass_to_parser( symbol_table_->get( std::string_view(), token_text(), token_code, false, type ) );
+}
+
 void Lexer::include_filename(int token_code, SymbolType type) { // @include ((whitespace)) >>filename<<
       expect_include_filename_ = false;
+      // Drop the quotes, or the quote & newline of an unterminated string
+      std::string_view text = token_text();
+      text.remove_prefix( 1 );
+      if( ! text.empty() && ( text.back() == '"' || text.back() == '\n' ) )
+          text.remove_suffix( 1 );
+      jString name( text.data(), text.data() + text.size() );
+      if( ast_cache_ ) {
+          // A file lexed already is skipped before the cache is asked, as
+          // include_file() skips it, & handed on as an @include of nothing
+          jString path;
+          if( std::FILE * file = open_include( name, path ) ) {
+              bool first = first_inclusion( file );
+              std::fclose( file );
+              if( ! first ) {
+                  parser_->parse( PARSER_INCLUDED, empty_node( "item_list" ), & ast_out );
+                  return;
+              }
+          }
+          ast_node_ptr items = ast_cache_->include( name, *this );
+          if( items.isset() )
+              parser_->parse( PARSER_INCLUDED, items, & ast_out );
+          else
+              std::cerr << "cannot open or parse @include file " << name << "\n";
+      } else if( ! include_file( name ) )
+          std::cerr << "cannot open @include file " << name << "\n";
 }
 
 void Lexer::parse_string(int token_code, SymbolType type) { // @include((whitespace)) filename
@@ -198,32 +561,29 @@ void Lexer::parse_string(int token_code, SymbolType type) { // @include((whitesp
 }
 
 void Lexer::start_namespace(int token_code, SymbolType type) { // @namespace ((whitespace)) >>name<<
-    token_ = jString(tok_,buf_);
-    awk_namespace_prefix_ = token_+jclib::jString("::");
-    namespace_prefix_ = token_+jclib::jString("__");
+    jString name(tok_,buf_);
+    awk_namespace_prefix_ = name+jclib::jString("::");
+    namespace_prefix_ = name+jclib::jString("__");
     expect_namespacename_ = false;
 }
 
 void Lexer::parsequalified(int token_code, SymbolType type) { // (Not "@") identifier"::"identifier
-        token_=jString(tok_,buf_);
-         jString token = jString(tok_,buf_);
-         auto bits = token.split("::",1);
-        auto sym=symbol_table_->get(bits[0],bits[1], true,PARSER_NAME);
-        auto ast = new awkccc::ast_node(Expression, sym );
-        parser_->parse( sym->token_, ast, & ast_out  );
-        allow_regex_ = false; 
+        std::string_view token = token_text();
+        size_t colons = token.find( "::" );
+        pass_to_parser( symbol_table_->get( token.substr( 0, colons ), token.substr( colons + 2 ), PARSER_NAME, true ) );
 }
 
-Symbol * Lexer::unqualified_to_sym( int token_code, jString & token ) {
+Symbol * Lexer::unqualified_to_sym( int token_code, std::string_view token ) {
         // What do we have here?
         // All caps -> Awk::
         // AWK keyword -> Awk::
         // namespace == Awk:: -> no prefix
         // else namespace__token
-        if( ( namespace_prefix_.len()==0) || ( token.isalpha() && token.isupper() ) )
-            return symbol_table_->get(Awk, token, token_code, false, VARIABLE );
+        bool all_caps = std::all_of( token.begin(), token.end(), []( char c ) { return c >= 'A' && c <= 'Z'; } );
+        if( ( namespace_prefix_.len()==0) || all_caps )
+            return symbol_table_->get(view(Awk), token, token_code, false, VARIABLE );
         
-        auto sym=symbol_table_->find(namespace_prefix_,token);
+        auto sym=symbol_table_->find(view(namespace_prefix_),token);
         if( sym ) {
             // "Magic" types
             switch( sym->type_ ) {
@@ -233,21 +593,14 @@ Symbol * Lexer::unqualified_to_sym( int token_code, jString & token ) {
                     return sym;
             }
         }
-        return symbol_table_->get(namespace_prefix_,token, token_code, false, VARIABLE );
+        return symbol_table_->get(view(namespace_prefix_),token, token_code, false, VARIABLE );
 }
 
 void Lexer::parseunqualified(int token_code, SymbolType type) { // identifier
     if( expect_namespacename_)
         start_namespace(token_code, type);
-    else {
-        size_t stringlen=buf_-tok_;
-        token_ = jString(tok_,buf_);
-        auto sym=unqualified_to_sym(token_code, token_);
-        token_ = sym->awk_name_;
-        auto ast = new awkccc::ast_node(Expression, sym );
-        parser_->parse( sym->token_, ast, & ast_out  );
-        allow_regex_ = false; 
-    }
+    else
+        pass_to_parser( unqualified_to_sym( token_code, token_text() ) );
 }
 
 void Lexer::parsechr(char char_code) {
@@ -351,7 +704,8 @@ void Lexer::initialise_symbol_table() {
         {Empty_Str, "toupper","toupper", FUNCTION,PARSER_BUILTIN_FUNC_NAME,true,false, "", "F",""}, // FIXME
         {Empty_Str, "sprintf","sprintf",FUNCTION,PARSER_BUILTIN_FUNC_NAME,true,false, "", "S",""}, // FIXME
         {Empty_Str, "close","close",FUNCTION,PARSER_BUILTIN_FUNC_NAME,true,false, "", "I",""}, // FIXME
-        {Empty_Str, "system","std::system",FUNCTION,PARSER_BUILTIN_FUNC_NAME,true,false, "S", "I","<stdlib>"},});
+        {Empty_Str, "system","system",FUNCTION,PARSER_BUILTIN_FUNC_NAME,true,false, "S", "I",""}, // Awkccc_runtime::system flushes output first
+    });
 
     symbol_table_->loadnamespace("Awk",false,{
         {"BEGIN",KEYWORD,PARSER_Begin},
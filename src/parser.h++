@@ -38,17 +38,18 @@
 #   define PARSER_While                           61
 #   define PARSER_BUILTIN_FUNC_NAME               62
 #   define PARSER_GETLINE                         63
-#   define PARSER_APPEND                          64
-#   define PARSER_LE                              65
-#   define PARSER_NE                              66
-#   define PARSER_EQ                              67
-#   define PARSER_GE                              68
-#   define PARSER_NO_MATCH                        69
-#   define PARSER_INCR                            70
-#   define PARSER_DECR                            71
+#   define PARSER_INCLUDED                        64
+#   define PARSER_APPEND                          65
+#   define PARSER_LE                              66
+#   define PARSER_NE                              67
+#   define PARSER_EQ                              68
+#   define PARSER_GE                              69
+#   define PARSER_NO_MATCH                        70
+#   define PARSER_INCR                            71
+#   define PARSER_DECR                            72
     int PARSER_char_to_token( char chr );
 
-#define PARSER_TOKENTYPE jclib::CountedPointer<awkccc::ast_node>
+#define PARSER_TOKENTYPE awkccc::ast_node_ptr
 #define PARSER_ARG_PDECL ,PARSER_TOKENTYPE * pAbc
 
 class PARSER_Parser {
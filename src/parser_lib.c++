@@ -17,13 +17,87 @@
 ** limitations under the License.
 ***/
 
+#include <new>
 #include "../include/jString.hpp"
 #include "../include/Save.hpp"
 #include "../include/awkccc_ast.hpp"
 using namespace jclib;
 
 namespace awkccc {
-    ast_node * ast_node::add_children( std::initializer_list< jclib::CountedPointer<ast_node> > adoptees) {
+    ast_arena * ast_arena::current_ = nullptr;
+
+    ast_arena::ast_arena()
+        : previous_( current_ )
+    {
+        current_ = this;
+    }
+
+    ast_arena::~ast_arena() {
+        for( auto node = nodes_.rbegin(); node != nodes_.rend(); ++node )
+            (*node)->~ast_node();
+        current_ = previous_;
+    }
+
+    ast_arena & ast_arena::current() {
+        if( current_ == nullptr ) {
+            // Never destroyed, like the symbol table the nodes point into
+            static ast_arena * process_arena = new ast_arena();
+            return *process_arena;
+        }
+        return *current_;
+    }
+
+    void * ast_arena::allocate_node( size_t size ) {
+        void * memory = memory_.allocate( size );
+        nodes_.push_back( static_cast<ast_node *>( memory ) );
+        return memory;
+    }
+
+    void ast_arena::abandon_node( void * memory ) {
+        if( ! nodes_.empty() && nodes_.back() == memory )
+            nodes_.pop_back();
+    }
+
+    bool ast_arena::is_shared_token( const jString & name ) {
+        static const char * const shared[] = { "\n", ";", ",", "(", ")", "[", "]", "{", "}", ":", "@@@" };
+        for( auto text : shared )
+            if( name == text )
+                return true;
+        return false;
+    }
+
+    ast_node * ast_arena::token( Symbol * sym, node_types type ) {
+        // Names, numbers & keywords are never shared: don't compare their text
+        bool punctuation = sym->type_ == OPERATOR || sym->type_ == OTHER;
+        if( ! punctuation || ! is_shared_token( sym->awk_name_ ) )
+            return new ast_node( type, sym );
+        ast_node * & shared = shared_tokens_[sym];
+        if( shared == nullptr )
+            shared = new ast_node( type, sym );
+        return shared;
+    }
+
+    ast_node_list & ast_node_list::operator = ( const ast_node_list & other ) {
+        if( this != &other ) {
+            clear();
+            if( other.size_ > capacity_ )
+                grow( other.size_ );
+            for( auto node : other )
+                items_[size_++] = node;
+        }
+        return *this;
+    }
+
+    void ast_node_list::grow( uint32_t capacity ) {
+        void * memory = ast_arena::current().allocate( capacity * sizeof( ast_node_ptr ) );
+        ast_node_ptr * items = static_cast<ast_node_ptr *>( memory );
+        for( uint32_t i = 0; i < capacity; ++i )
+            new( items + i ) ast_node_ptr( i < size_ ? items_[i] : nullptr );
+        items_ = items;
+        capacity_ = capacity;
+    }
+
+    ast_node * ast_node::add_children( std::initializer_list< ast_node_ptr > adoptees) {
         for( auto i : adoptees )
             add_child(i);
         return this;;
@@ -32,7 +106,7 @@ namespace awkccc {
     class ast_printer: public ast_node_visitor {
         public:
             struct printer_ctl {
-                CountedPointer<ast_node> node_;
+                ast_node_ptr node_;
                 jclib::jString padding_;
                 bool include_children_;
                 bool include_siblings_;
@@ -237,7 +311,7 @@ namespace awkccc {
                 // Add children's siblings. 
                 // A bit complex as we may be inserting in the middle of the child array
                 // We solve this by copying to a temporary
-                std::vector<jclib::CountedPointer<ast_node> > temp_children(child_nodes_);
+                ast_node_list temp_children(child_nodes_);
                 child_nodes_.clear();
                 for( auto child : temp_children ) {
                     child_nodes_.push_back(child);
@@ -258,7 +332,7 @@ namespace awkccc {
                 }
             }
             if( empty_children_exist ) {
-                std::vector<jclib::CountedPointer<ast_node> > temp_children(child_nodes_);
+                ast_node_list temp_children(child_nodes_);
                 child_nodes_.clear();
                 for( auto child : temp_children) {
                     if( (!child->dummy_) || (!child->child_nodes_.empty()) || (! child->sibling_nodes_.empty()))
@@ -36,6 +36,13 @@ SOFTWARE.
 #include "../include/awkccc_ast.hpp"
 #include "../include/awkccc_lexer.hpp"
 #include "../include/generate_cpp.h++"
+#include "../include/awkccc_analysis.h++"
+#include "../include/awkccc_ere.h++"
+#include "../include/awkccc_ast_cache.h++"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
 using namespace jclib;
 using namespace awkccc;
 
@@ -45,7 +52,7 @@ using namespace jclib;
 using namespace awkccc;
 typedef void *(*malloc_t(size_t));
 typedef void *(*free_t(void *));
-#define ParseTOKENTYPE jclib::CountedPointer<ast_node>
+#define ParseTOKENTYPE ast_node_ptr
 /*
 // This character to token table is a cut-n-paste from the 
 // generated parser.c++ file.
@@ -81,7 +88,7 @@ PARSER_Parser* get_parser( ) {
     return PARSER_Parser::Create();
 }
 
-void Parse(void *pParser, int tokenCode, ParseTOKENTYPE token_, jclib::CountedPointer<awkccc::ast_node> *pAbc) {
+void Parse(void *pParser, int tokenCode, ParseTOKENTYPE token_, awkccc::ast_node_ptr *pAbc) {
     PARSER_Parser * parser = static_cast<PARSER_Parser *>(pParser);
     parser->parse( tokenCode, token_, pAbc );
 }
@@ -129,6 +136,21 @@ public:
         delete_buffer();
         return node;
     }
+    /// The printed tree of code, translated with its @include files
+    /// parsed by, or found in, cache
+    std::string lex_printed( const char * code, ast_cache & cache ) {
+        Lexer * lexer = create_lexer( code );
+        lexer->ast_cache_ = &cache;
+        lexer->lex();
+        std::ostringstream printed;
+        if( Lexer::ast_out.isset()) {
+            Lexer::ast_out->clean_tree(nullptr);
+            print_ast( printed, Lexer::ast_out );
+        }
+        delete lexer;
+        delete_buffer();
+        return printed.str();
+    }
     std::vector< postream> code_;
     std::ostringstream output_;
     void generate_cpp( const char * template_txt, ast_node_ptr node) {
@@ -146,6 +168,18 @@ public:
     void generate_cpp( jclib::jString & template_txt, ast_node_ptr node) {
         generate_cpp( (const char *)template_txt, node );
     }
+    /// The variables & procedures generated for program, as members of a
+    /// runtime class such as the program template declares
+    std::string program_class( const char * program ) {
+        generate_cpp( "%includes;\n", lex( program ) );
+        return code_[template_INCLUDES]->str()
+            + "#include \"awkccc_runtime.h++\"\n"
+            + "#include \"awkccc_parallel.h++\"\n"
+            + "struct Program : public Awkccc_runtime {\n"
+            + code_[template_VARS]->str()
+            + code_[template_PROCS]->str()
+            + "};\n";
+    }
 
 private:
     void testBegin() {
@@ -154,6 +188,328 @@ private:
         std::cout << code_[template_BEGIN]->str() << "\n";
         std::cout << code_[template_body]->str() << "\n";
     }
+    void testFieldUsageConstant() {
+        ast_node_ptr node = lex("{ print $1, $3; x = $2 }\n");
+        Awkccc_field_usage usage = analyse_field_usage( node );
+        CPPUNIT_ASSERT( usage.max_field_ == 3 );
+        CPPUNIT_ASSERT( ! usage.uses_nf_ );
+        CPPUNIT_ASSERT( ! usage.dynamic_field_ );
+    }
+    void testFieldUsageDynamic() {
+        ast_node_ptr node = lex("{ print $NF; print $(i+1) }\n");
+        Awkccc_field_usage usage = analyse_field_usage( node );
+        CPPUNIT_ASSERT( usage.uses_nf_ );
+        CPPUNIT_ASSERT( usage.dynamic_field_ );
+    }
+    const Awkccc_reducer * reducer( const Awkccc_parallel_plan & plan, const char * name ) {
+        for( auto & reducer : plan.reducers_ )
+            if( reducer.name_ == name )
+                return &reducer;
+        return nullptr;
+    }
+    void testParallelReductions() {
+        ast_node_ptr node = lex("{ c[$1]++; s[$2] += $5; if( $3 > big ) big = $3 }\nEND { for( k in c ) print k, c[k], s[k]; print big }\n");
+        Awkccc_parallel_plan plan = analyse_parallel( node );
+        CPPUNIT_ASSERT( plan.safe_ );
+        CPPUNIT_ASSERT( plan.reducers_.size() == 3 );
+        CPPUNIT_ASSERT( reducer( plan, "c" )->reduction_ == Reduce_Sum && reducer( plan, "c" )->is_array_ );
+        CPPUNIT_ASSERT( reducer( plan, "s" )->reduction_ == Reduce_Sum );
+        CPPUNIT_ASSERT( reducer( plan, "big" )->reduction_ == Reduce_Max );
+    }
+    void testParallelNativeAccumulators() {
+        std::string code = program_class( "{ n++; s += $2; if( $3 > big ) big = $3; last = $4 + 0 }\n" );
+        CPPUNIT_ASSERT( code.find( "int64_t n = 0;" ) != std::string::npos );
+        CPPUNIT_ASSERT( code.find( "double s = 0;" ) != std::string::npos );
+        // A last value has to be able to say the shard never assigned it
+        CPPUNIT_ASSERT( code.find( "awkccc::Awkccc_last_variable last;" ) != std::string::npos );
+        // Each shard starts every reducer & the merge folds in each one
+        CPPUNIT_ASSERT( code.find( "void start_shard() {\n"
+                                   "    awkccc::start_reduction( n, awkccc::Reduce_Sum );\n"
+                                   "    awkccc::start_reduction( s, awkccc::Reduce_Sum );\n"
+                                   "    awkccc::start_reduction( big, awkccc::Reduce_Max );\n"
+                                   "    awkccc::start_reduction( last, awkccc::Reduce_Last );\n"
+                                   "}\n" ) != std::string::npos );
+        CPPUNIT_ASSERT( code.find( "void merge_shard( const Program & shard ) {\n"
+                                   "    awkccc::reduce( n, shard.n, awkccc::Reduce_Sum );\n"
+                                   "    awkccc::reduce( s, shard.s, awkccc::Reduce_Sum );\n"
+                                   "    awkccc::reduce( big, shard.big, awkccc::Reduce_Max );\n"
+                                   "    awkccc::reduce( last, shard.last, awkccc::Reduce_Last );\n"
+                                   "}\n" ) != std::string::npos );
+    }
+    void testParallelRefusesCrossRecord() {
+        ast_node_ptr node = lex("{ s[$1] = last; last = $2 }\n");
+        CPPUNIT_ASSERT( ! analyse_parallel( node ).safe_ );
+        node = lex("{ print $1 > \"out\" }\n");
+        CPPUNIT_ASSERT( ! analyse_parallel( node ).safe_ );
+        node = lex("{ n++; if( n > 10 ) t += $1 }\n");
+        CPPUNIT_ASSERT( ! analyse_parallel( node ).safe_ );
+    }
+    void testParallelFilter() {
+        ast_node_ptr node = lex("$3 > 10 { print $1, $2 * 2 }\n$1 == \"x\"\n");
+        Awkccc_parallel_plan plan = analyse_parallel( node );
+        CPPUNIT_ASSERT( plan.safe_ );
+        CPPUNIT_ASSERT( plan.ordered_output_ );
+        CPPUNIT_ASSERT( plan.reducers_.empty() );
+        node = lex("{ n++ }\n");
+        CPPUNIT_ASSERT( ! analyse_parallel( node ).ordered_output_ );
+    }
+    Awkccc_static_type type_of( const char * code, const char * name ) {
+        ast_node_ptr node = lex( code );
+        for( auto & variable : analyse_variable_types( node ) )
+            if( variable.name_ == name )
+                return variable.type_;
+        return Static_Unset;
+    }
+    void testVariableTypes() {
+        CPPUNIT_ASSERT( type_of( "BEGIN {\n    for( varName=1; varName < 10; varName++ ) {\n        print varName;\n    }\n"
+                                 "    for( ; varName < 20; ) {\n        varName += 5;\n        print varName;\n    }\n}\n",
+                                 "varName" ) == Static_Integer );
+        // Printed uninitialised if there is no input
+        CPPUNIT_ASSERT( type_of( "{ sum += $1 }\nEND { print sum }\n", "sum" ) == Static_Dynamic );
+        CPPUNIT_ASSERT( type_of( "BEGIN { sum = 0 }\n{ sum += $1 }\nEND { print sum }\n", "sum" ) == Static_Number );
+        // Only used as a number, where uninitialised is 0 anyway
+        CPPUNIT_ASSERT( type_of( "{ n++ }\nEND { print n / 2 }\n", "n" ) == Static_Integer );
+        CPPUNIT_ASSERT( type_of( "{ line = line sep $1; sep = \",\" }\nEND { print line }\n", "line" ) == Static_String );
+        CPPUNIT_ASSERT( type_of( "{ x = $1 }\n", "x" ) == Static_Dynamic );
+        CPPUNIT_ASSERT( type_of( "BEGIN { y = 1; y = \"a\" }\n", "y" ) == Static_Dynamic );
+        CPPUNIT_ASSERT( type_of( "{ c[$1]++ }\n", "c" ) == Static_Array );
+        CPPUNIT_ASSERT( type_of( "BEGIN { if( $1 ) t = 1; print t }\n", "t" ) == Static_Dynamic );
+    }
+    void testFlattenConcatenations() {
+        ast_node_ptr node = lex( "{ x = a b c d; print \"n=\" n \":\" (m \"z\"); getline line }\n" );
+        flatten_concatenations( node );
+        ast_node * assignment = node->child_nodes_[0];
+        ast_node * chain = assignment->child_nodes_[1];
+        CPPUNIT_ASSERT( is_operator( operator_of( chain ), "@@@" ) && chain->child_nodes_.size() == 4 );
+        ast_node * print = node->child_nodes_[1];
+        CPPUNIT_ASSERT( print->child_nodes_.size() == 1 && print->child_nodes_[0]->child_nodes_.size() == 5 );
+        // getline var is written with @@@ too, but isn't a concatenation
+        ast_node * getline = node->child_nodes_[2];
+        CPPUNIT_ASSERT( getline->child_nodes_.size() == 2 && getline->child_nodes_[0]->name_ == "getline" );
+        CPPUNIT_ASSERT( type_of( "BEGIN { x = \"a\" 1 \"b\"; print x }\n", "x" ) == Static_String );
+    }
+    void testAstArena() {
+        ast_arena & outer = ast_arena::current();
+        {
+            ast_arena arena;
+            CPPUNIT_ASSERT( &ast_arena::current() == &arena );
+            ast_node_ptr node = lex( "{ x = (a) (b) }\n" );
+            CPPUNIT_ASSERT( arena.node_count() > 5 );
+            // Both ( tokens are one node, the names aren't
+            ast_node * chain = node->child_nodes_[0]->child_nodes_[1];
+            ast_node * left = chain->child_nodes_[0];
+            ast_node * right = chain->child_nodes_[1];
+            CPPUNIT_ASSERT( is_operator( operator_of( left ), "(" ) && operator_of( left ) == operator_of( right ) );
+            CPPUNIT_ASSERT( left->child_nodes_[0] != right->child_nodes_[0] );
+            ast_node_list list;
+            for( auto child : chain->child_nodes_ )
+                for( int i = 0; i < 3; ++i )
+                    list.push_back( child );
+            ast_node_list copy( list );
+            list.clear();
+            CPPUNIT_ASSERT( copy.size() == 6 && copy[5] == right && list.empty() );
+        }
+        CPPUNIT_ASSERT( &ast_arena::current() == &outer );
+    }
+    void testKeepsFields() {
+        CPPUNIT_ASSERT( keeps_fields( lex( "{ count[$1]++ }\n" ) ) );
+        CPPUNIT_ASSERT( keeps_fields( lex( "{ last = ($3) }\n" ) ) );
+        CPPUNIT_ASSERT( ! keeps_fields( lex( "{ sum += $3; print $1 }\n" ) ) );
+        CPPUNIT_ASSERT( ! keeps_fields( lex( "{ pair[$1,$2]++ }\n" ) ) );
+    }
+    void testSymbolTable() {
+        ast_node_ptr node = lex( "BEGIN { if( x ) print NF, x }\n" );
+        SymbolTable & table = SymbolTable::instance();
+        jclib::jString global, awk( "Awk" ), keyword( "if" ), builtin( "NF" ), user( "x" ), rule( "program" );
+        Symbol * found = table.find( global, keyword );
+        CPPUNIT_ASSERT( found != nullptr && found->type_ == STATEMENT && found->token_ == PARSER_If );
+        found = table.find( awk, builtin );
+        CPPUNIT_ASSERT( found != nullptr && found->is_built_in_ );
+        // The program's names are kept in their namespace, rule names not at all
+        found = table.find( awk, user );
+        CPPUNIT_ASSERT( found != nullptr && found->type_ == VARIABLE );
+        CPPUNIT_ASSERT( table.find( global, user ) == nullptr );
+        CPPUNIT_ASSERT( table.find( global, rule ) == nullptr );
+        CPPUNIT_ASSERT( table.get( awk, user, PARSER_NAME, false ) == found );
+        // The lexer's path, looking up the text where it lies
+        std::string_view text( "{ x }" );
+        CPPUNIT_ASSERT( table.find( std::string_view( "Awk" ), text.substr( 2, 1 ) ) == found );
+        CPPUNIT_ASSERT( table.get( std::string_view( "Awk" ), text.substr( 2, 1 ), PARSER_NAME, false ) == found );
+        CPPUNIT_ASSERT( table.find( std::string_view(), "@@@" )->token_ == PARSER_CONCATENATE );
+    }
+    void testAstCache() {
+        char directory[32];
+        std::strcpy( directory, "/tmp/awkcccXXXXXX" );
+        CPPUNIT_ASSERT( mkdtemp( directory ) != nullptr );
+        std::string library = std::string( directory ) + "/library.awk";
+        const char * text = "function twice(n) { return n * 2 }\nBEGIN { total = 0 }\n";
+        FILE * file = std::fopen( library.c_str(), "w" );
+        std::fputs( text, file );
+        std::fclose( file );
+        std::string code = std::string( "@include \"" ) + directory + "/library\"\n{ total += twice($1) }\n";
+        ast_cache cache( jString( directory ) + jString( "/cache" ) );
+        std::string parsed = lex_printed( code.c_str(), cache );
+        CPPUNIT_ASSERT( cache.misses_ == 1 && cache.hits_ == 0 );
+        CPPUNIT_ASSERT( parsed.find( "twice" ) != std::string::npos );
+        jString entry = cache.entry_name( ast_cache::key( text ) );
+        CPPUNIT_ASSERT( std::filesystem::exists( (const char *) entry ) );
+
+        // From the cache into a fresh symbol table: twice is known to be
+        // a function only because the entry says so
+        SymbolTable::stack_instance();
+        std::string loaded = lex_printed( code.c_str(), cache );
+        CPPUNIT_ASSERT( cache.misses_ == 1 && cache.hits_ == 1 );
+        CPPUNIT_ASSERT( loaded == parsed );
+        Symbol * twice = SymbolTable::instance().find( std::string_view( "Awk" ), "twice" );
+        CPPUNIT_ASSERT( twice != nullptr && twice->type_ == FUNCTION );
+
+        // An entry for other text, or a damaged one, is no entry at all
+        std::string saved;
+        file = std::fopen( entry, "rb" );
+        char chunk[4096];
+        size_t got;
+        while( ( got = std::fread( chunk, 1, sizeof chunk, file ) ) > 0 )
+            saved.append( chunk, got );
+        std::fclose( file );
+        uint64_t key = ast_cache::key( text );
+        size_t size = std::strlen( text );
+        CPPUNIT_ASSERT( ast_cache::load( saved, key + 1, size, SymbolTable::instance() ) == nullptr );
+        CPPUNIT_ASSERT( ast_cache::load( saved.substr( 0, saved.size() / 2 ), key, size, SymbolTable::instance() ) == nullptr );
+        CPPUNIT_ASSERT( ast_cache::load( saved, key, size, SymbolTable::instance() ) != nullptr );
+        std::filesystem::remove_all( directory );
+    }
+    void testAstCacheNestedInclude() {
+        char directory[32];
+        std::strcpy( directory, "/tmp/awkcccXXXXXX" );
+        CPPUNIT_ASSERT( mkdtemp( directory ) != nullptr );
+        std::string inner = std::string( directory ) + "/inner.awk";
+        std::string outer = std::string( directory ) + "/outer.awk";
+        auto write = []( const std::string & name, const std::string & text ) {
+            FILE * file = std::fopen( name.c_str(), "w" );
+            std::fputs( text.c_str(), file );
+            std::fclose( file );
+        };
+        write( inner, "function twice(n) { return n * 2 }\n" );
+        write( outer, "@include \"" + inner + "\"\nfunction quad(n) { return twice(twice(n)) }\n" );
+        std::string code = "@include \"" + outer + "\"\n{ print quad($1) }\n";
+        ast_cache cache( jString( directory ) + jString( "/cache" ) );
+        std::string parsed = lex_printed( code.c_str(), cache );
+        CPPUNIT_ASSERT( cache.misses_ == 2 && cache.hits_ == 0 );
+        SymbolTable::stack_instance();
+        CPPUNIT_ASSERT( lex_printed( code.c_str(), cache ) == parsed );
+        CPPUNIT_ASSERT( cache.misses_ == 2 && cache.hits_ == 1 );
+
+        // outer.awk is unchanged, but what it includes isn't
+        write( inner, "function twice(n) { return halve(n * 4) }\nfunction halve(n) { return n / 2 }\n" );
+        SymbolTable::stack_instance();
+        std::string edited = lex_printed( code.c_str(), cache );
+        CPPUNIT_ASSERT( cache.misses_ == 4 && cache.hits_ == 1 );
+        CPPUNIT_ASSERT( edited.find( "halve" ) != std::string::npos );
+        SymbolTable::stack_instance();
+        CPPUNIT_ASSERT( lex_printed( code.c_str(), cache ) == edited );
+        CPPUNIT_ASSERT( cache.misses_ == 4 && cache.hits_ == 2 );
+        std::filesystem::remove_all( directory );
+    }
+    void testAstCacheIncludesOnce() {
+        char directory[32];
+        std::strcpy( directory, "/tmp/awkcccXXXXXX" );
+        CPPUNIT_ASSERT( mkdtemp( directory ) != nullptr );
+        std::string library = std::string( directory ) + "/library.awk";
+        std::string outer = std::string( directory ) + "/outer.awk";
+        auto write = []( const std::string & name, const std::string & text ) {
+            FILE * file = std::fopen( name.c_str(), "w" );
+            std::fputs( text.c_str(), file );
+            std::fclose( file );
+        };
+        auto count = []( const std::string & text, const std::string & word ) {
+            size_t found = 0;
+            for( size_t at = text.find( word ); at != std::string::npos; at = text.find( word, at + 1 ) )
+                ++found;
+            return found;
+        };
+        write( library, "function twice(n) { return n * 2 }\n" );
+        write( outer, "@include \"" + library + "\"\nfunction quad(n) { return twice(twice(n)) }\n" );
+        // library.awk comes in with outer.awk, whose entry holds it, & again on its own
+        std::string code = "@include \"" + outer + "\"\n@include \"" + library + "\"\n"
+                           "@include \"" + library + "\"\n{ print quad($1) }\n";
+        ast_cache cache( jString( directory ) + jString( "/cache" ) );
+        std::string parsed = lex_printed( code.c_str(), cache );
+        CPPUNIT_ASSERT( cache.misses_ == 2 && cache.hits_ == 0 );
+        CPPUNIT_ASSERT( count( parsed, "quad" ) == 2 && count( parsed, "twice" ) == 3 );
+        SymbolTable::stack_instance();
+        CPPUNIT_ASSERT( lex_printed( code.c_str(), cache ) == parsed );
+        CPPUNIT_ASSERT( cache.misses_ == 2 && cache.hits_ == 1 );
+
+        // With library.awk first, outer.awk's entry would bring it in again,
+        // so outer.awk is parsed without it & that isn't cached
+        std::string library_first = "@include \"" + library + "\"\n@include \"" + outer + "\"\n{ print quad($1) }\n";
+        SymbolTable::stack_instance();
+        std::string reparsed = lex_printed( library_first.c_str(), cache );
+        CPPUNIT_ASSERT( cache.misses_ == 3 && cache.hits_ == 2 );
+        CPPUNIT_ASSERT( count( reparsed, "quad" ) == 2 && count( reparsed, "twice" ) == 3 );
+        SymbolTable::stack_instance();
+        CPPUNIT_ASSERT( lex_printed( library_first.c_str(), cache ) == reparsed );
+        CPPUNIT_ASSERT( cache.misses_ == 4 && cache.hits_ == 3 );
+        std::filesystem::remove_all( directory );
+    }
+    void testEreToRe2c() {
+        Awkccc_re2c_regex regex;
+        std::string why;
+        CPPUNIT_ASSERT( ere_to_re2c( "ab+c", regex, why ) );
+        CPPUNIT_ASSERT( regex.regex_ == "\"a\" \"b\"+ \"c\"" );
+        CPPUNIT_ASSERT( ! regex.anchored_start_ && ! regex.anchored_end_ );
+        CPPUNIT_ASSERT( ere_to_re2c( "^a.b$", regex, why ) );
+        CPPUNIT_ASSERT( regex.regex_ == "\"a\" [^] \"b\"" );
+        CPPUNIT_ASSERT( regex.anchored_start_ && regex.anchored_end_ );
+        CPPUNIT_ASSERT( ere_to_re2c( "[[:digit:]]{2,3}x", regex, why ) );
+        CPPUNIT_ASSERT( regex.regex_ == "[\\x30-\\x39]{2,3} \"x\"" );
+        CPPUNIT_ASSERT( ere_to_re2c( "(foo|)bar", regex, why ) );
+        CPPUNIT_ASSERT( regex.regex_ == "(\"f\" \"o\" \"o\" | \"\") \"b\" \"a\" \"r\"" );
+        // Left to the runtime
+        CPPUNIT_ASSERT( ! ere_to_re2c( "a$b", regex, why ) );
+        CPPUNIT_ASSERT( ! ere_to_re2c( "^a|b", regex, why ) );
+        CPPUNIT_ASSERT( ! ere_to_re2c( "\\y", regex, why ) );
+    }
+    void testEreLiteralShapes() {
+        Awkccc_ere_literal literal;
+        CPPUNIT_ASSERT( ere_literal( "ERROR", literal ) );
+        CPPUNIT_ASSERT( literal.shape_ == Ere_Literal && literal.literal_ == "ERROR" );
+        CPPUNIT_ASSERT( ere_literal( "^GET ", literal ) );
+        CPPUNIT_ASSERT( literal.shape_ == Ere_Prefix && literal.literal_ == "GET " );
+        CPPUNIT_ASSERT( ere_literal( "\\.gz$", literal ) );
+        CPPUNIT_ASSERT( literal.shape_ == Ere_Suffix && literal.literal_ == ".gz" );
+        CPPUNIT_ASSERT( ere_literal( "^yes$", literal ) );
+        CPPUNIT_ASSERT( literal.shape_ == Ere_Exact && literal.literal_ == "yes" );
+        // Prefilters for EREs that need the DFA
+        CPPUNIT_ASSERT( ere_literal( "x(ab)*yz", literal ) );
+        CPPUNIT_ASSERT( literal.shape_ == Ere_General && literal.literal_ == "yz" );
+        CPPUNIT_ASSERT( ere_literal( "ab?cd", literal ) );
+        CPPUNIT_ASSERT( literal.literal_ == "cd" );
+        CPPUNIT_ASSERT( ere_literal( "abc|d", literal ) );
+        CPPUNIT_ASSERT( literal.literal_.empty() );
+        std::string code, why;
+        CPPUNIT_ASSERT( ere_matcher( "ERROR", "m", code, why ) );
+        CPPUNIT_ASSERT( code.find( "memmem" ) != std::string::npos );
+        CPPUNIT_ASSERT( code.find( "re2c" ) == std::string::npos );
+    }
+    void testEreMatcherCode() {
+        std::string code = program_class( "$2 ~ /^[0-9]+x?$/ { m++ }\n" );
+        CPPUNIT_ASSERT( code.find( "bool awkccc_ere_0( std::string_view text )" ) != std::string::npos );
+        // A block for re2c, anchored at both ends as the ERE is
+        CPPUNIT_ASSERT( code.find( "    /*!re2c\n" ) != std::string::npos );
+        CPPUNIT_ASSERT( code.find( "        ([\\x30-\\x39]+ \"x\"?) { return YYCURSOR == YYLIMIT; }\n" ) != std::string::npos );
+        CPPUNIT_ASSERT( code.find( "[^]*" ) == std::string::npos );
+        // Without re2c the block is a comment & the regex cache matches
+        CPPUNIT_ASSERT( code.find( "    return awkccc::regex_cache().matches( text, \"^[0-9]+x?$\" );\n" ) != std::string::npos );
+        CPPUNIT_ASSERT( code.find( "#include <string_view>" ) < code.find( "awkccc_ere_0" ) );
+    }
+    void testFindEreLiterals() {
+        ast_node_ptr node = lex("/err/ { n++ }\n$2 ~ /^[0-9]+$/ { m++ }\n/err/\n");
+        std::vector<std::string> eres = find_ere_literals( node );
+        CPPUNIT_ASSERT( eres.size() == 2 );
+        CPPUNIT_ASSERT( eres[0] == "err" );
+        CPPUNIT_ASSERT( eres[1] == "^[0-9]+$" );
+    }
 /*
     void test1CharOp() {
         lex("*\n");
@@ -237,6 +593,24 @@ private:
     */
     CPPUNIT_TEST_SUITE(GeneratorTestClass);
         CPPUNIT_TEST(testBegin);
+        CPPUNIT_TEST(testFieldUsageConstant);
+        CPPUNIT_TEST(testFieldUsageDynamic);
+        CPPUNIT_TEST(testParallelReductions);
+        CPPUNIT_TEST(testParallelNativeAccumulators);
+        CPPUNIT_TEST(testParallelRefusesCrossRecord);
+        CPPUNIT_TEST(testParallelFilter);
+        CPPUNIT_TEST(testVariableTypes);
+        CPPUNIT_TEST(testFlattenConcatenations);
+        CPPUNIT_TEST(testKeepsFields);
+        CPPUNIT_TEST(testAstArena);
+        CPPUNIT_TEST(testSymbolTable);
+        CPPUNIT_TEST(testAstCache);
+        CPPUNIT_TEST(testAstCacheNestedInclude);
+        CPPUNIT_TEST(testAstCacheIncludesOnce);
+        CPPUNIT_TEST(testEreToRe2c);
+        CPPUNIT_TEST(testEreLiteralShapes);
+        CPPUNIT_TEST(testFindEreLiterals);
+        CPPUNIT_TEST(testEreMatcherCode);
     /*
         CPPUNIT_TEST(test1CharOp);
         CPPUNIT_TEST(testRegex);
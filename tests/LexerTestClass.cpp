@@ -32,6 +32,10 @@ SOFTWARE.
 #include <cppunit/ui/text/TestRunner.h>
 #endif
 #include <cppunit/extensions/HelperMacros.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
 #include "../include/jString.hpp"
 #include "../include/awkccc_ast.hpp"
 #include "../include/awkccc_lexer.hpp"
@@ -44,7 +48,7 @@ using namespace jclib;
 using namespace awkccc;
 typedef void *(*malloc_t(size_t));
 typedef void *(*free_t(void *));
-#define ParseTOKENTYPE jclib::CountedPointer<ast_node>
+#define ParseTOKENTYPE ast_node_ptr
 // This character to token table is a cut-n-paste from the 
 // generated parser.c++ file.
 // If the original table changes, it will need recopying.
@@ -73,12 +77,12 @@ namespace LexerTestClassNS {
     typedef struct parser_trace {
         int TokenCode_;
         ParseTOKENTYPE token_;
-        jclib::CountedPointer<awkccc::ast_node> *pAbc_;
+        awkccc::ast_node_ptr *pAbc_;
     } ParseTrace;
     typedef class parser_mock : public PARSER_Parser {
         public: 
             std::vector<ParseTrace> trace_;
-            void parse( int tokenCode, ParseTOKENTYPE token_, jclib::CountedPointer<awkccc::ast_node> *pAbc ) {
+            void parse( int tokenCode, ParseTOKENTYPE token_, awkccc::ast_node_ptr *pAbc ) {
                 trace_.push_back( {tokenCode, token_, pAbc} );
             }
             virtual int char_to_token(char chr) {
@@ -96,7 +100,7 @@ PARSER_Parser* get_parser( ) {
     return & the_parser;
 }
 
-void Parse(void *pParser, int tokenCode, ParseTOKENTYPE token_, jclib::CountedPointer<awkccc::ast_node> *pAbc) {
+void Parse(void *pParser, int tokenCode, ParseTOKENTYPE token_, awkccc::ast_node_ptr *pAbc) {
     ParserMock * parser = static_cast<ParserMock *>(pParser);
     parser->parse( tokenCode, token_, pAbc );
 }
@@ -107,11 +111,20 @@ void ParseTrace(FILE *stream, char *zPrefix) {
 class LexerTestClass : public CPPUNIT_NS::TestFixture {
 public:
     char * buf_ = nullptr;
+    char filename_[32];
     LexerTestClass() {}
     virtual ~LexerTestClass() {}
     void setUp(){
+        std::strcpy( filename_, "/tmp/awkcccXXXXXX" );
+        ::close( mkstemp( filename_ ) );
     }
     void tearDown(){
+        std::remove( filename_ );
+    }
+    void write_file( const char * text ) {
+        FILE * file = std::fopen( filename_, "w" );
+        std::fputs( text, file );
+        std::fclose( file );
     }
     void delete_buffer() {
         delete buf_;
@@ -141,6 +154,18 @@ public:
         delete lexer;
         delete_buffer();
     }
+    /// Lex filename_, reading it buffer_size bytes at a time
+    void lex_file( size_t buffer_size ) {
+        PARSER_Parser * pParser=get_parser();
+        ParserMock * parser = static_cast<ParserMock *>(pParser);
+        parser->trace_.clear();
+        Lexer * lexer = new Lexer( nullptr,nullptr,nullptr,nullptr,nullptr,0,&SymbolTable::instance(),parser);
+        lexer->buffer_size_ = buffer_size;
+        CPPUNIT_ASSERT( lexer->include_file( filename_ ) );
+        lexer->initialise_symbol_table();
+        lexer->lex();
+        delete lexer;
+    }
 private:
     void testBegin() {
         lex("BEGIN\n");
@@ -225,6 +250,44 @@ private:
         auto sym = token->sym_;
         CPPUNIT_ASSERT( sym->c_name_ ==  "xxx::ABC");
     }
+    void testLongScript() {
+        // Far more than one buffer, & more than the 25 KB once read whole
+        std::string script;
+        for( int i = 0; i < 10000; ++i )
+            script += "abc += 12\n";
+        write_file( script.c_str() );
+        lex_file( 256 );
+        CPPUNIT_ASSERT( the_parser.trace_.size() == 40001 );
+        CPPUNIT_ASSERT( the_parser.trace_[39998].TokenCode_ == PARSER_NUMBER );
+        CPPUNIT_ASSERT( the_parser.trace_[40000].TokenCode_ == 0 );
+    }
+    void testInclude() {
+        write_file( "BEGIN\n" );
+        std::string code = std::string( "@include \"" ) + filename_ + "\"\n+=";
+        lex( code.c_str() );
+        // The included file's tokens, then the rest of the including one
+        size_t size = the_parser.trace_.size();
+        CPPUNIT_ASSERT( the_parser.trace_[0].TokenCode_ == PARSER_Begin );
+        CPPUNIT_ASSERT( the_parser.trace_[size - 2].TokenCode_ == PARSER_ADD_ASSIGN );
+        CPPUNIT_ASSERT( the_parser.trace_[size - 1].TokenCode_ == 0 );
+    }
+    void testIncludeOnce() {
+        // A file including itself is lexed once, as is one included twice
+        std::string include = std::string( "@include \"" ) + filename_ + "\"\n";
+        write_file( ( include + "BEGIN\n" ).c_str() );
+        lex_file( 256 );
+        size_t begins = 0;
+        for( auto & token : the_parser.trace_ )
+            begins += token.TokenCode_ == PARSER_Begin;
+        CPPUNIT_ASSERT( begins == 1 );
+        write_file( "BEGIN\n" );
+        lex( ( include + include + "+=" ).c_str() );
+        begins = 0;
+        for( auto & token : the_parser.trace_ )
+            begins += token.TokenCode_ == PARSER_Begin;
+        CPPUNIT_ASSERT( begins == 1 );
+        CPPUNIT_ASSERT( the_parser.trace_[the_parser.trace_.size() - 2].TokenCode_ == PARSER_ADD_ASSIGN );
+    }
     CPPUNIT_TEST_SUITE(LexerTestClass);
         CPPUNIT_TEST(testBegin);
         CPPUNIT_TEST(test1CharOp);
@@ -239,6 +302,9 @@ private:
         CPPUNIT_TEST(testNamespaceIgnoredByAllUppercase);
         CPPUNIT_TEST(testNamespaceIgnoredByReservedWord);
         CPPUNIT_TEST(testNamespaceOverrideAllUppercase);
+        CPPUNIT_TEST(testLongScript);
+        CPPUNIT_TEST(testInclude);
+        CPPUNIT_TEST(testIncludeOnce);
     CPPUNIT_TEST_SUITE_END();
 };
 
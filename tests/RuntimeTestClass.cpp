@@ -0,0 +1,910 @@
+/*
+Copyright (c) 2024 Julia Ingleby Clement
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+ */
+/*
+ * File:   RuntimeTestClass.cpp
+ * Author: Julia Clement <Julia at Clement dot nz>
+ *
+ * Created on 17/10/2026, 10:02:14
+ */
+
+#ifdef ONE_FIXTURE
+#include <cppunit/CompilerOutputter.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#endif
+#include <cppunit/extensions/HelperMacros.h>
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/awkccc_runtime.h++"
+#include "../include/awkccc_parallel.h++"
+using namespace jclib;
+using namespace awkccc;
+
+/// What the generator emits for { count[$1]++; total += $2 }
+struct Counting_program : public Awkccc_runtime {
+    std::map<std::string, Awkccc_variable> count;
+    Awkccc_variable total;
+    void main_rules() {
+        count[std::string( field( 1 ) )]++;
+        total = Awkccc_variable( double( total ) + std::atof( std::string( field( 2 ) ).c_str() ) );
+    }
+    void start_shard() {
+        awkccc::start_reduction( count, awkccc::Reduce_Sum );
+        awkccc::start_reduction( total, awkccc::Reduce_Sum );
+    }
+    template< typename Program >
+    void merge_shard( const Program & shard ) {
+        awkccc::reduce( count, shard.count, awkccc::Reduce_Sum );
+        awkccc::reduce( total, shard.total, awkccc::Reduce_Sum );
+    }
+};
+
+/// What the generator emits for $2 % 3 == 0 { print $2, $1; n++ }
+struct Filter_program : public Counting_program {
+    void main_rules() {
+        if( std::atoi( std::string( field( 2 ) ).c_str() ) % 3 == 0 ) {
+            print( field( 2 ), field( 1 ) );
+            total = Awkccc_variable( double( total ) + 1 );
+        }
+    }
+    void start_shard() {
+        awkccc::start_reduction( total, awkccc::Reduce_Sum );
+    }
+    template< typename Program >
+    void merge_shard( const Program & shard ) {
+        awkccc::reduce( total, shard.total, awkccc::Reduce_Sum );
+    }
+};
+
+/// What the generator emits for { last = $3 }
+struct Last_program : public Awkccc_runtime {
+    awkccc::Awkccc_last_variable last;
+    void main_rules() {
+        last = field_value( 3 );
+    }
+    void start_shard() {
+        awkccc::start_reduction( last, awkccc::Reduce_Last );
+    }
+    template< typename Program >
+    void merge_shard( const Program & shard ) {
+        awkccc::reduce( last, shard.last, awkccc::Reduce_Last );
+    }
+};
+
+class RuntimeTestClass : public CPPUNIT_NS::TestFixture {
+public:
+    char filename_[32];
+    RuntimeTestClass() {}
+    virtual ~RuntimeTestClass() {}
+    void setUp(){
+        std::strcpy( filename_, "/tmp/awkcccXXXXXX" );
+        ::close( mkstemp( filename_ ) );
+    }
+    void tearDown(){
+        std::remove( filename_ );
+    }
+    void write_file( const char * text ) {
+        FILE * file = std::fopen( filename_, "w" );
+        std::fputs( text, file );
+        std::fclose( file );
+    }
+private:
+    void testReadMappedFile() {
+        write_file( "one two\nthree\n\nlast" );
+        Awkccc_record_reader reader;
+        std::string_view record;
+        CPPUNIT_ASSERT( reader.open( filename_ ) );
+        CPPUNIT_ASSERT( reader.is_mapped() );
+        CPPUNIT_ASSERT( reader.next_record( record ) && record == "one two" );
+        CPPUNIT_ASSERT( reader.next_record( record ) && record == "three" );
+        CPPUNIT_ASSERT( reader.next_record( record ) && record == "" );
+        CPPUNIT_ASSERT( reader.next_record( record ) && record == "last" );
+        CPPUNIT_ASSERT( ! reader.next_record( record ) );
+    }
+    void testReadPipe() {
+        int fds[2];
+        CPPUNIT_ASSERT( pipe( fds ) == 0 );
+        // Longer than the initial buffer so the reader has to grow it
+        std::string long_line( Awkccc_record_reader::initial_buffer_size_ + 10, 'x' );
+        std::string text = "first\n" + long_line + "\nafter";
+        if( fork() == 0 ) {
+            ::close( fds[0] );
+            ssize_t written = write( fds[1], text.data(), text.size() );
+            _exit( written == (ssize_t)text.size() ? 0 : 1 );
+        }
+        ::close( fds[1] );
+        Awkccc_record_reader reader;
+        std::string_view record;
+        CPPUNIT_ASSERT( reader.open_fd( fds[0], true ) );
+        CPPUNIT_ASSERT( ! reader.is_mapped() );
+        CPPUNIT_ASSERT( reader.next_record( record ) && record == "first" );
+        CPPUNIT_ASSERT( reader.next_record( record ) && record == long_line );
+        CPPUNIT_ASSERT( reader.next_record( record ) && record == "after" );
+        CPPUNIT_ASSERT( ! reader.next_record( record ) );
+    }
+    void testParagraphMode() {
+        write_file( "\n\nline1\nline2\n\n\n\npara2\n\n" );
+        Awkccc_record_reader reader;
+        std::string_view record;
+        reader.set_separator( "" );
+        CPPUNIT_ASSERT( reader.open( filename_ ) );
+        CPPUNIT_ASSERT( reader.next_record( record ) && record == "line1\nline2" );
+        CPPUNIT_ASSERT( reader.next_record( record ) && record == "para2" );
+        CPPUNIT_ASSERT( ! reader.next_record( record ) );
+    }
+    void testReadSyntheticFile() {
+        // A regular file whose size is 0 until it is read
+        Awkccc_record_reader reader;
+        std::string_view record;
+        CPPUNIT_ASSERT( reader.open( "/proc/self/status" ) );
+        CPPUNIT_ASSERT( ! reader.is_mapped() );
+        CPPUNIT_ASSERT( reader.next_record( record ) && record.substr( 0, 5 ) == "Name:" );
+    }
+    void testDefaultRuntimeReads() {
+        // RS, FS & the counts start as awk's own, without the program setting them
+        write_file( "a b\n\nc\n" );
+        Awkccc_runtime runtime;
+        CPPUNIT_ASSERT( runtime.open_input( filename_ ) );
+        CPPUNIT_ASSERT( runtime.next_record() && runtime.record() == "a b" );
+        CPPUNIT_ASSERT( runtime.field( 2 ) == "b" );
+        CPPUNIT_ASSERT( runtime.next_record() && runtime.record() == "" );
+        CPPUNIT_ASSERT( runtime.next_record() && runtime.record() == "c" );
+        CPPUNIT_ASSERT( ! runtime.next_record() );
+        CPPUNIT_ASSERT( runtime.Awk__NR == 3 && runtime.Awk__FNR == 3 );
+        Awkccc_number_format::text buf;
+        CPPUNIT_ASSERT( runtime.Awk__OFS.text( buf ) == " " && runtime.Awk__ORS.text( buf ) == "\n" );
+    }
+    void testRuntimeCountsRecords() {
+        write_file( "a\nb\n" );
+        Awkccc_runtime runtime;
+        runtime.Awk__NR = 0;
+        runtime.Awk__RS = Awkccc_variable( jString( "\n" ) );
+        CPPUNIT_ASSERT( runtime.open_input( filename_ ) );
+        CPPUNIT_ASSERT( runtime.next_record() && runtime.record() == "a" );
+        CPPUNIT_ASSERT( ! runtime.record_modified_ );
+        runtime.set_record( "changed" );
+        CPPUNIT_ASSERT( runtime.record() == "changed" );
+        CPPUNIT_ASSERT( runtime.next_record() && runtime.record() == "b" );
+        CPPUNIT_ASSERT( ! runtime.next_record() );
+        CPPUNIT_ASSERT( runtime.Awk__NR == 2 );
+        CPPUNIT_ASSERT( runtime.Awk__FNR == 2 );
+    }
+    void testArenaTemporaries() {
+        Awkccc_arena arena( 256 );
+        Awkccc_variable temporary = Awkccc_variable::from_input( "a long field value", 0.0, false, arena );
+        CPPUNIT_ASSERT( temporary.is_temporary() && temporary.string_value() == "a long field value" );
+        CPPUNIT_ASSERT( ! Awkccc_variable::from_input( "short", 0.0, false, arena ).is_temporary() );
+        Awkccc_variable number = Awkccc_variable::from_input( "  123456.5", 123456.5, true, arena );
+        CPPUNIT_ASSERT( number.data_type() == Numeric_String && double( number ) == 123456.5 );
+        // Moving keeps it in the arena, copying & assigning promote it
+        Awkccc_variable moved( std::move( temporary ) );
+        CPPUNIT_ASSERT( moved.is_temporary() );
+        Awkccc_variable copied( moved ), assigned;
+        assigned = std::move( moved );
+        Awkccc_array array;
+        array[assigned] = Awkccc_variable::from_input( "another long value", 0.0, false, arena );
+        CPPUNIT_ASSERT( ! copied.is_temporary() && ! assigned.is_temporary() );
+        // Reuse the arena's memory: nothing kept may have pointed into it
+        arena.reset();
+        std::memset( arena.allocate( 200 ), 'x', 200 );
+        CPPUNIT_ASSERT( copied.string_value() == "a long field value" && copied == assigned );
+        CPPUNIT_ASSERT( array.keys()[0] == "a long field value" );
+        CPPUNIT_ASSERT( array["a long field value"].string_value() == "another long value" );
+        // Records after the first reuse its chunks
+        std::string text;
+        for( int i = 0; i < 1000; ++i )
+            text += "first_field_" + std::to_string( i ) + " second_field_" + std::to_string( i ) + "\n";
+        Awkccc_runtime runtime;
+        runtime.Awk__RS = Awkccc_variable( jString( "\n" ) );
+        runtime.Awk__FS = Awkccc_variable( jString( " " ) );
+        runtime.open_memory( text );
+        runtime.fields_.set_usage( usage( 2, false, false ) );
+        CPPUNIT_ASSERT( runtime.next_record() );
+        Awkccc_variable kept = runtime.field_value( 1 );
+        CPPUNIT_ASSERT( kept.is_temporary() );
+        kept.promote();
+        runtime.temporary( concatenate( runtime.field_value( 1 ), ":", runtime.field_value( 2 ) ) );
+        size_t capacity = runtime.arena_.capacity();
+        while( runtime.next_record() ) {
+            Awkccc_variable key = runtime.temporary( concatenate( runtime.field_value( 1 ), ":", runtime.field_value( 2 ) ) );
+            CPPUNIT_ASSERT( key.is_temporary() && key.string_value().substr( 0, 12 ) == "first_field_" );
+        }
+        CPPUNIT_ASSERT( runtime.arena_.capacity() == capacity );
+        CPPUNIT_ASSERT( kept.string_value() == "first_field_0" );
+    }
+    void testGetlineKeepsTemporaries() {
+        // function f(x) { getline; print x } called as f($1): x is still
+        // the first record's field
+        std::string text = "a_long_first_field 1\nanother_long_field 2\n";
+        Awkccc_runtime runtime;
+        runtime.open_memory( text );
+        runtime.fields_.set_usage( usage( 2, false, false ) );
+        CPPUNIT_ASSERT( runtime.next_record() );
+        Awkccc_variable x = runtime.field_value( 1 );
+        CPPUNIT_ASSERT( x.is_temporary() );
+        CPPUNIT_ASSERT( runtime.read_record() && runtime.record() == "another_long_field 2" );
+        runtime.temporary( concatenate( runtime.field_value( 1 ), runtime.field_value( 1 ) ) );
+        std::memset( runtime.arena_.allocate( 200 ), 'x', 200 );
+        CPPUNIT_ASSERT( x.string_value() == "a_long_first_field" );
+        CPPUNIT_ASSERT( double( runtime.Awk__NR ) == 2 );
+    }
+    Awkccc_field_usage usage( int max_field, bool uses_nf, bool dynamic_field ) {
+        Awkccc_field_usage usage;
+        usage.max_field_ = max_field;
+        usage.uses_nf_ = uses_nf;
+        usage.dynamic_field_ = dynamic_field;
+        return usage;
+    }
+    void testFieldsSplitLazily() {
+        Awkccc_fields fields;
+        fields.set_usage( usage( 0, false, true ) );
+        fields.reset( "  one two\tthree  four five " );
+        CPPUNIT_ASSERT( fields.split_so_far() == 0 );
+        CPPUNIT_ASSERT( fields.get( 2 ) == "two" );
+        CPPUNIT_ASSERT( fields.split_so_far() == 2 );
+        CPPUNIT_ASSERT( fields.get( 1 ) == "one" );
+        CPPUNIT_ASSERT( fields.get( 4 ) == "four" );
+        CPPUNIT_ASSERT( fields.split_so_far() == 4 );
+        CPPUNIT_ASSERT( fields.get( 9 ) == "" );
+        CPPUNIT_ASSERT( fields.count() == 5 );
+    }
+    void testFieldNumbersCachedPerRecord() {
+        Awkccc_fields fields;
+        fields.set_usage( usage( 0, false, true ) );
+        fields.reset( " 12 abc 3.5e1 7x " );
+        CPPUNIT_ASSERT( fields.number( 1 ).numeric_ && fields.number( 1 ).value_ == 12 );
+        CPPUNIT_ASSERT( ! fields.number( 2 ).numeric_ && fields.number( 2 ).value_ == 0 );
+        CPPUNIT_ASSERT( fields.number( 3 ).numeric_ && fields.number( 3 ).value_ == 35 );
+        CPPUNIT_ASSERT( ! fields.number( 4 ).numeric_ && fields.number( 4 ).value_ == 7 );
+        CPPUNIT_ASSERT( fields.number( 5 ).missing_ );
+        CPPUNIT_ASSERT( ! fields.number( 0 ).numeric_ );
+        fields.reset( "99" );
+        CPPUNIT_ASSERT( fields.number( 1 ).value_ == 99 );
+        CPPUNIT_ASSERT( fields.number( 3 ).missing_ );
+        CPPUNIT_ASSERT( fields.number( 0 ).numeric_ );
+    }
+    void testFieldsSplitToHighestConstant() {
+        Awkccc_fields fields;
+        fields.set_usage( usage( 3, false, false ) );
+        fields.reset( "a b c d e f g" );
+        CPPUNIT_ASSERT( fields.split_so_far() == 3 );
+        CPPUNIT_ASSERT( fields.get( 3 ) == "c" );
+        fields.set_usage( usage( 3, true, false ) );
+        fields.reset( "a b c d e f g" );
+        CPPUNIT_ASSERT( fields.split_so_far() == 7 );
+    }
+    void testFieldsSingleCharacterFS() {
+        Awkccc_fields fields;
+        fields.set_usage( usage( 0, true, false ) );
+        fields.set_separator( "," );
+        fields.reset( "a,,b c," );
+        CPPUNIT_ASSERT( fields.count() == 4 );
+        CPPUNIT_ASSERT( fields.get( 2 ) == "" );
+        CPPUNIT_ASSERT( fields.get( 3 ) == "b c" );
+        CPPUNIT_ASSERT( fields.get( 4 ) == "" );
+        fields.reset( "" );
+        CPPUNIT_ASSERT( fields.count() == 0 );
+    }
+    /// Straightforward split to check the kernels against
+    std::vector<std::string> reference_split( const std::string & record, char separator ) {
+        std::vector<std::string> result;
+        if( separator == ' ' ) {
+            size_t i = 0;
+            for(;;) {
+                while( i < record.size() && ( record[i] == ' ' || record[i] == '\t' || record[i] == '\n' ) )
+                    ++i;
+                if( i == record.size() )
+                    break;
+                size_t start = i;
+                while( i < record.size() && ! ( record[i] == ' ' || record[i] == '\t' || record[i] == '\n' ) )
+                    ++i;
+                result.push_back( record.substr( start, i - start ) );
+            }
+        } else if( ! record.empty() ) {
+            size_t start = 0, found;
+            while( ( found = record.find( separator, start ) ) != std::string::npos ) {
+                result.push_back( record.substr( start, found - start ) );
+                start = found + 1;
+            }
+            result.push_back( record.substr( start ) );
+        }
+        return result;
+    }
+
+    void testSplitKernelsAgree() {
+        const char alphabet[] = "ab \t\n,,x";
+        unsigned seed = 12345;
+        Awkccc_split_isa best = Awkccc_split_kernels::best_isa();
+        for( int isa = Split_Scalar; isa <= best; ++isa ) {
+            for( int trial = 0; trial < 400; ++trial ) {
+                std::string record;
+                size_t length = trial % 100;
+                for( size_t i = 0; i < length; ++i ) {
+                    seed = seed * 1103515245 + 12345;
+                    record += alphabet[( seed >> 16 ) % ( sizeof alphabet - 1 )];
+                }
+                for( const char * FS : { " ", "," } ) {
+                    std::vector<std::string> expected = reference_split( record, FS[0] );
+                    Awkccc_fields fields;
+                    fields.set_usage( usage( 0, false, true ) );
+                    fields.set_kernels( Awkccc_split_isa( isa ) );
+                    fields.set_separator( FS );
+                    // Lazily, one field at a time
+                    fields.reset( record );
+                    for( size_t n = 1; n <= expected.size(); ++n )
+                        CPPUNIT_ASSERT( fields.get( n ) == expected[n - 1] );
+                    CPPUNIT_ASSERT( fields.get( expected.size() + 1 ) == "" );
+                    CPPUNIT_ASSERT( fields.count() == expected.size() );
+                    // All at once
+                    fields.reset( record );
+                    CPPUNIT_ASSERT( fields.count() == expected.size() );
+                    for( size_t n = 1; n <= expected.size(); ++n )
+                        CPPUNIT_ASSERT( fields.get( n ) == expected[n - 1] );
+                }
+            }
+        }
+    }
+
+    void testFieldsRegexFS() {
+        Awkccc_fields fields;
+        fields.set_separator( "[:;]+" );
+        fields.reset( "a:;b;c" );
+        CPPUNIT_ASSERT( fields.count() == 3 );
+        CPPUNIT_ASSERT( fields.get( 2 ) == "b" );
+        // Awk's escapes, as FS = "\\t|\\/" gives
+        fields.set_separator( "\\t|\\/" );
+        fields.reset( "a\tb/c" );
+        CPPUNIT_ASSERT( fields.count() == 3 );
+        CPPUNIT_ASSERT( fields.get( 3 ) == "c" );
+    }
+
+    void testPlanShardsAtSeparators() {
+        std::string_view input = "aaaa\nbb\ncccccc\nd\n";
+        std::vector<Awkccc_shard> shards = plan_shards( input, '\n', 3 );
+        CPPUNIT_ASSERT( shards.size() == 3 );
+        CPPUNIT_ASSERT( shards[0].begin_ == 0 );
+        for( size_t i = 0; i < shards.size(); ++i ) {
+            CPPUNIT_ASSERT( input[shards[i].end_ - 1] == '\n' );
+            if( i > 0 )
+                CPPUNIT_ASSERT( shards[i].begin_ == shards[i - 1].end_ );
+        }
+        CPPUNIT_ASSERT( shards.back().end_ == input.size() );
+        // More shards than records
+        CPPUNIT_ASSERT( plan_shards( "x\n", '\n', 8 ).size() == 1 );
+    }
+    void testReductions() {
+        Awkccc_variable total( 5.0 );
+        reduce( total, Awkccc_variable( 3.0 ), Reduce_Sum );
+        CPPUNIT_ASSERT( double( total ) == 8.0 );
+        reduce( total, Awkccc_variable( 2.0 ), Reduce_Max );
+        CPPUNIT_ASSERT( double( total ) == 8.0 );
+        reduce( total, Awkccc_variable( 2.0 ), Reduce_Min );
+        CPPUNIT_ASSERT( double( total ) == 2.0 );
+        // An array element a shard holds was assigned there, even if to ""
+        reduce( total, Awkccc_variable(), Reduce_Last );
+        CPPUNIT_ASSERT( total.data_type() == Uninitialised );
+        // A last value is taken from the last shard to assign it, whatever it assigned
+        Awkccc_last_variable last, first, second, third( 9.0 );
+        start_reduction( first, Reduce_Last );
+        first = Awkccc_variable( 1.0 );
+        start_reduction( second, Reduce_Last );
+        second = Awkccc_variable();
+        start_reduction( third, Reduce_Last );
+        reduce( last, first, Reduce_Last );
+        CPPUNIT_ASSERT( double( last ) == 1.0 );
+        reduce( last, second, Reduce_Last );
+        CPPUNIT_ASSERT( last.data_type() == Uninitialised );
+        reduce( last, third, Reduce_Last );
+        CPPUNIT_ASSERT( last.data_type() == Uninitialised );
+        std::map<std::string, Awkccc_variable> all = { { "a", Awkccc_variable( 1.0 ) } };
+        std::map<std::string, Awkccc_variable> shard = { { "a", Awkccc_variable( 2.0 ) }, { "b", Awkccc_variable( 4.0 ) } };
+        reduce( all, shard, Reduce_Sum );
+        CPPUNIT_ASSERT( double( all["a"] ) == 3.0 );
+        CPPUNIT_ASSERT( double( all["b"] ) == 4.0 );
+        // A sum no shard touched stays uninitialised, as it would sequentially
+        Awkccc_variable untouched;
+        Awkccc_variable copy( 7.0 );
+        start_reduction( copy, Reduce_Sum );
+        CPPUNIT_ASSERT( copy.data_type() == Uninitialised );
+        reduce( untouched, copy, Reduce_Sum );
+        CPPUNIT_ASSERT( untouched.data_type() == Uninitialised );
+        reduce( untouched, Awkccc_variable( 2.0 ), Reduce_Sum );
+        CPPUNIT_ASSERT( double( untouched ) == 2.0 );
+    }
+    void testParallelSumNeverIncremented() {
+        // { if( $2 % 3 == 0 ) n++ } END { print n } with no such record prints ""
+        write_file( "a 1\nb 2\nc 4\nd 5\n" );
+        Awkccc_writer output( Awkccc_writer::memory_ );
+        Filter_program program;
+        program.output_ = &output;
+        CPPUNIT_ASSERT( Awkccc_ordered_driver<Filter_program>::run_file( program, filename_, 4, 4 ) );
+        CPPUNIT_ASSERT( program.Awk__NR == 4 );
+        CPPUNIT_ASSERT( program.total.data_type() == Uninitialised );
+    }
+    void testParallelLastAssignedUninitialised() {
+        // { last = $3 } where the final record has no $3: last ends up "",
+        // though earlier shards assigned it numbers
+        std::string text;
+        for( int i = 0; i < 1000; ++i )
+            text += "a b " + std::to_string( i ) + "\n";
+        text += "a b\n";
+        write_file( text.c_str() );
+        for( unsigned threads : { 1, 4 } ) {
+            Last_program program;
+            program.fields_.set_usage( usage( 3, false, false ) );
+            CPPUNIT_ASSERT( Awkccc_parallel_driver<Last_program>::run_file( program, filename_, threads ) );
+            CPPUNIT_ASSERT( program.Awk__NR == 1001 );
+            CPPUNIT_ASSERT( program.last.data_type() == Uninitialised );
+        }
+    }
+    void testParallelMatchesSequential() {
+        std::string text;
+        for( int i = 0; i < 1000; ++i )
+            text += std::string( 1, char( 'a' + i % 7 ) ) + " " + std::to_string( i ) + "\n";
+        write_file( text.c_str() );
+        Counting_program results[2];
+        for( unsigned threads : { 1, 4 } ) {
+            Counting_program & program = results[threads == 1 ? 0 : 1];
+            program.Awk__NR = 0;
+            program.Awk__RS = Awkccc_variable( jString( "\n" ) );
+            program.Awk__FS = Awkccc_variable( jString( " " ) );
+            CPPUNIT_ASSERT( Awkccc_parallel_driver<Counting_program>::run_file( program, filename_, threads ) );
+        }
+        CPPUNIT_ASSERT( results[1].Awk__NR == 1000 );
+        CPPUNIT_ASSERT( double( results[1].total ) == double( results[0].total ) );
+        CPPUNIT_ASSERT( results[1].count.size() == 7 );
+        for( auto & element : results[0].count )
+            CPPUNIT_ASSERT( double( results[1].count[element.first] ) == double( element.second ) );
+        CPPUNIT_ASSERT( results[1].record() == "f 999" );
+    }
+    void testOrderedOutputMatchesSequential() {
+        std::string text;
+        for( int i = 0; i < 5000; ++i )
+            text += std::string( 1, char( 'a' + i % 7 ) ) + " " + std::to_string( i ) + "\n";
+        write_file( text.c_str() );
+        Awkccc_writer output[2] = { Awkccc_writer( Awkccc_writer::memory_ ), Awkccc_writer( Awkccc_writer::memory_ ) };
+        Filter_program results[2];
+        for( int run = 0; run < 2; ++run ) {
+            Filter_program & program = results[run];
+            program.Awk__NR = 0;
+            program.Awk__RS = Awkccc_variable( jString( "\n" ) );
+            program.Awk__FS = Awkccc_variable( jString( " " ) );
+            program.output_ = &output[run];
+            // Small chunks so that there are many more chunks than threads
+            CPPUNIT_ASSERT( Awkccc_ordered_driver<Filter_program>::run_file( program, filename_, run == 0 ? 1 : 4, 1000 ) );
+        }
+        CPPUNIT_ASSERT( output[0].text().size() > 0 );
+        CPPUNIT_ASSERT( output[1].text() == output[0].text() );
+        CPPUNIT_ASSERT( double( results[1].total ) == 1667.0 );
+        CPPUNIT_ASSERT( results[1].Awk__NR == 5000 );
+    }
+    std::string read_file() {
+        std::string text;
+        FILE * file = std::fopen( filename_, "r" );
+        for( int c; ( c = std::fgetc( file ) ) != EOF; )
+            text += char( c );
+        std::fclose( file );
+        return text;
+    }
+    void testWriterBuffersUntilFull() {
+        int fd = ::open( filename_, O_WRONLY | O_TRUNC );
+        {
+            Awkccc_writer writer( fd, 16 );
+            writer.print( " ", "\n", "%.6g", std::string_view( "abc" ), std::string_view( "de" ) );
+            CPPUNIT_ASSERT( read_file() == "" );
+            writer.write( "012345678" );
+            CPPUNIT_ASSERT( read_file() == "" );
+            // The buffer is full, so this flushes it
+            writer.put( '9' );
+            CPPUNIT_ASSERT( read_file() == "abc de\n012345678" );
+            // Too big to copy: written beside the buffer
+            writer.write( std::string( 40, 'x' ) );
+            CPPUNIT_ASSERT( read_file() == "abc de\n0123456789" + std::string( 40, 'x' ) );
+            writer.put( '!' );
+        }
+        ::close( fd );
+        CPPUNIT_ASSERT( read_file() == "abc de\n0123456789" + std::string( 40, 'x' ) + "!" );
+    }
+    void testWriterFormatsNumbers() {
+        Awkccc_writer writer( Awkccc_writer::memory_, 8 );
+        Awkccc_variable text( jString( "t" ) );
+        writer.print( ",", ";", "%.6g", 42.0, 0.5, -7.0, text, 1e20 );
+        CPPUNIT_ASSERT( writer.text() == "42,0.5,-7,t,1e+20;" );
+        writer.clear();
+        writer.format( "%5.1f|%s", 3.14159, "long enough to need more room" );
+        CPPUNIT_ASSERT( writer.text() == "  3.1|long enough to need more room" );
+    }
+    void testConcatenateOnce() {
+        Awkccc_variable half( 0.5 );
+        Awkccc_variable joined = concatenate( "n=", 42, ", h=", half, jString( "!" ) ).value();
+        CPPUNIT_ASSERT( joined.string_value() == "n=42, h=0.5!" );
+        CPPUNIT_ASSERT( joined.data_type() == String );
+        // Short enough to be held inline
+        Awkccc_variable small = concatenate( "a", 1 );
+        CPPUNIT_ASSERT( small.string_value() == "a1" );
+        // Numbers in a concatenation go through CONVFMT, not OFMT
+        Awkccc_writer writer( Awkccc_writer::memory_, 8 );
+        writer.print( " ", "\n", "%.2f", 0.125, concatenate( "x", 0.125, std::string_view( "y" ) ) );
+        CPPUNIT_ASSERT( writer.text() == "0.12 x0.125y\n" );
+    }
+    void testSystemStatus() {
+        Awkccc_runtime runtime;
+        CPPUNIT_ASSERT( runtime.system( "exit 0" ) == 0 );
+        CPPUNIT_ASSERT( runtime.system( "exit 3" ) == 3 );
+        CPPUNIT_ASSERT( runtime.system( "kill -TERM $$" ) == 256 + SIGTERM );
+    }
+    void testConvfmtAssignment() {
+        // BEGIN { CONVFMT = "%.2f"; x = 3.14159 "" }
+        Awkccc_runtime runtime;
+        runtime.Awk__CONVFMT = "%.2f";
+        CPPUNIT_ASSERT( concatenate( 3.14159, "" ).value().string_value() == "3.14" );
+        // Another thread's runtime has a CONVFMT of its own
+        std::string other;
+        std::thread shard( [&other]() {
+            Awkccc_runtime runtime;
+            runtime.Awk__CONVFMT = Awkccc_variable( "%.4e" );
+            other = std::string( concatenate( 3.14159, "" ).value().string_value() );
+        } );
+        shard.join();
+        CPPUNIT_ASSERT( other == "3.1416e+00" );
+        CPPUNIT_ASSERT( concatenate( 3.14159, "" ).value().string_value() == "3.14" );
+        runtime.Awk__CONVFMT = "%.6g";
+        CPPUNIT_ASSERT( concatenate( 3.14159, "" ).value().string_value() == "3.14159" );
+    }
+    std::string read_file( const std::string & name ) {
+        std::string text;
+        FILE * file = std::fopen( name.c_str(), "r" );
+        if( file == nullptr )
+            return "<missing>";
+        for( int c; ( c = std::fgetc( file ) ) != EOF; )
+            text += char( c );
+        std::fclose( file );
+        return text;
+    }
+    void testOutputTableEvictsLeastRecentlyUsed() {
+        std::string base( filename_ );
+        {
+            Awkccc_output_table table( 2 );
+            for( int round = 0; round < 3; ++round ) {
+                for( int i = 0; i < 5; ++i ) {
+                    Awkccc_writer * writer = table.get( base + "." + std::to_string( i ), Redirect_Truncate );
+                    CPPUNIT_ASSERT( writer != nullptr );
+                    writer->print( " ", "\n", "%.6g", double( round ), double( i ) );
+                    CPPUNIT_ASSERT( table.open_count() <= 2 );
+                }
+            }
+            CPPUNIT_ASSERT( table.close( base + ".4" ) == 0 );
+            CPPUNIT_ASSERT( table.close( base + ".4" ) == -1 );
+        }
+        for( int i = 0; i < 5; ++i ) {
+            std::string name = base + "." + std::to_string( i );
+            std::string expected;
+            for( int round = 0; round < 3; ++round )
+                expected += std::to_string( round ) + " " + std::to_string( i ) + "\n";
+            CPPUNIT_ASSERT( read_file( name ) == expected );
+            std::remove( name.c_str() );
+        }
+    }
+    void testOutputTablePipe() {
+        Awkccc_output_table table;
+        std::string command = std::string( "cat > " ) + filename_;
+        Awkccc_writer * writer = table.get( command, Redirect_Pipe );
+        CPPUNIT_ASSERT( writer != nullptr );
+        writer->write( "piped\n" );
+        CPPUNIT_ASSERT( table.close( command ) == 0 );
+        CPPUNIT_ASSERT( read_file() == "piped\n" );
+
+        // A command started later sees what was printed to a file before
+        std::string log = std::string( filename_ ) + ".log";
+        Awkccc_writer * earlier = table.get( log, Redirect_Truncate );
+        CPPUNIT_ASSERT( earlier != nullptr );
+        earlier->write( "first\n" );
+        command = "cat " + log + " > " + filename_;
+        CPPUNIT_ASSERT( table.get( command, Redirect_Pipe ) != nullptr );
+        CPPUNIT_ASSERT( table.close( command ) == 0 );
+        CPPUNIT_ASSERT( read_file() == "first\n" );
+        table.close( log );
+        std::remove( log.c_str() );
+    }
+    void testStandardStreamRedirection() {
+        Awkccc_runtime runtime;
+        Awkccc_writer output( Awkccc_writer::memory_, 64 );
+        runtime.output_ = &output;
+        size_t open = output_table().open_count();
+        CPPUNIT_ASSERT( runtime.print_to( "/dev/stdout", Redirect_Truncate, "a" ) );
+        CPPUNIT_ASSERT( runtime.print_to( "-", Redirect_Append, "b" ) );
+        CPPUNIT_ASSERT( runtime.print_formatted_to( "/dev/stdout", Redirect_Truncate, "%d\n", 3 ) );
+        CPPUNIT_ASSERT( output.text() == "a\nb\n3\n" );
+        CPPUNIT_ASSERT( output_table().open_count() == open );
+        CPPUNIT_ASSERT( runtime.close( "/dev/stdout" ) == 0 );
+        // Standard error is written at once, with nothing left buffered
+        fflush( stderr );
+        int saved = dup( STDERR_FILENO );
+        int file = ::open( filename_, O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+        dup2( file, STDERR_FILENO );
+        ::close( file );
+        CPPUNIT_ASSERT( runtime.print_to( "/dev/stderr", Redirect_Truncate, "oops" ) );
+        std::string written = read_file();
+        dup2( saved, STDERR_FILENO );
+        ::close( saved );
+        CPPUNIT_ASSERT( written == "oops\n" );
+        CPPUNIT_ASSERT( output_table().open_count() == open );
+    }
+    void testRegexCacheReusesCompiled() {
+        Awkccc_regex_cache cache( 2 );
+        CPPUNIT_ASSERT( cache.matches( "hello world", "o.w" ) );
+        CPPUNIT_ASSERT( ! cache.matches( "hello", "^l+$" ) );
+        CPPUNIT_ASSERT( cache.matches( "hello world", "o.w" ) );
+        CPPUNIT_ASSERT( cache.compiled() == 2 );
+        // The third pattern pushes out the least recently used, ^l+$
+        CPPUNIT_ASSERT( cache.matches( "abc", "[[:alpha:]]{3}" ) );
+        CPPUNIT_ASSERT( cache.size() == 2 );
+        CPPUNIT_ASSERT( cache.matches( "hello world", "o.w" ) );
+        CPPUNIT_ASSERT( cache.compiled() == 3 );
+        CPPUNIT_ASSERT( cache.matches( "lll", "^l+$" ) );
+        CPPUNIT_ASSERT( cache.compiled() == 4 );
+    }
+    void testRegexCacheLiteralsSkipCompiling() {
+        Awkccc_regex_cache cache;
+        CPPUNIT_ASSERT( cache.matches( "an ERROR here", "ERROR" ) );
+        CPPUNIT_ASSERT( ! cache.matches( "all well", "ERROR" ) );
+        CPPUNIT_ASSERT( cache.matches( "GET /index", "^GET " ) );
+        CPPUNIT_ASSERT( ! cache.matches( "POST /GET ", "^GET " ) );
+        size_t start, length;
+        CPPUNIT_ASSERT( cache.search( "an ERROR", "ERROR", start, length ) );
+        CPPUNIT_ASSERT( start == 3 && length == 5 );
+        CPPUNIT_ASSERT( ! cache.search( "POST", "^GET", start, length ) );
+        CPPUNIT_ASSERT( cache.compiled() == 0 );
+    }
+    void testRegexCacheAwkEscapes() {
+        Awkccc_regex_cache cache;
+        CPPUNIT_ASSERT( cache.matches( "a\tb", "a\\tb" ) );
+        CPPUNIT_ASSERT( cache.matches( "x/y", "x\\/y" ) );
+        CPPUNIT_ASSERT( cache.matches( "say \"hi\"", "\\\"hi\\\"$" ) );
+        CPPUNIT_ASSERT( ! cache.matches( "a b", "a\\tb" ) );
+    }
+    void testBadRegexIsFatal() {
+        int fds[2];
+        CPPUNIT_ASSERT( pipe( fds ) == 0 );
+        pid_t child = fork();
+        if( child == 0 ) {
+            dup2( fds[1], STDERR_FILENO );
+            Awkccc_regex_cache cache;
+            cache.matches( "a(b", "a(b" );
+            _exit( 0 );
+        }
+        ::close( fds[1] );
+        std::string written;
+        char chunk[256];
+        ssize_t got;
+        while( ( got = read( fds[0], chunk, sizeof chunk ) ) > 0 )
+            written.append( chunk, got );
+        ::close( fds[0] );
+        int status = 0;
+        CPPUNIT_ASSERT( waitpid( child, &status, 0 ) == child );
+        CPPUNIT_ASSERT( WIFEXITED( status ) && WEXITSTATUS( status ) == 2 );
+        CPPUNIT_ASSERT( written.find( "fatal: invalid regular expression /a(b/" ) != std::string::npos );
+    }
+    void testRuntimeMatchSetsRstart() {
+        Awkccc_runtime runtime;
+        CPPUNIT_ASSERT( runtime.match( "foobar", "o+b" ) == 2 );
+        CPPUNIT_ASSERT( double( runtime.Awk__RSTART ) == 2 );
+        CPPUNIT_ASSERT( runtime.Awk__RLENGTH == 3 );
+        CPPUNIT_ASSERT( runtime.match( "foobar", "z" ) == 0 );
+        CPPUNIT_ASSERT( double( runtime.Awk__RSTART ) == 0 );
+        CPPUNIT_ASSERT( runtime.Awk__RLENGTH == -1 );
+        CPPUNIT_ASSERT( runtime.matches( "foobar", "b.r$" ) );
+    }
+    void testArraySubscripts() {
+        Awkccc_array array;
+        array[1] = Awkccc_variable( 10.0 );
+        array["1"]++;
+        CPPUNIT_ASSERT( double( array[1.0] ) == 11 );
+        // "01" is a different subscript from 1
+        CPPUNIT_ASSERT( ! array.contains( "01" ) );
+        array["01"] = Awkccc_variable( 5.0 );
+        array[-1] = Awkccc_variable( 6.0 );
+        CPPUNIT_ASSERT( array.contains( "-1" ) );
+        array[0.5] = Awkccc_variable( 7.0 );
+        CPPUNIT_ASSERT( array.contains( "0.5" ) );
+        CPPUNIT_ASSERT( array.size() == 4 );
+        CPPUNIT_ASSERT( array.erase( 1.0 ) );
+        CPPUNIT_ASSERT( ! array.erase( "1" ) );
+        CPPUNIT_ASSERT( array.size() == 3 );
+        std::vector<std::string> keys = array.keys();
+        std::sort( keys.begin(), keys.end() );
+        CPPUNIT_ASSERT( keys.size() == 3 && keys[0] == "-1" && keys[1] == "0.5" && keys[2] == "01" );
+        array.clear();
+        CPPUNIT_ASSERT( array.empty() && ! array.contains( "01" ) );
+    }
+    void testArrayTupleSubscripts() {
+        Awkccc_array array;
+        Awkccc_variable row( 2.0 );
+        array[ subscripts( "\034", row, "x" ) ] = Awkccc_variable( 5.0 );
+        array[ subscripts( "\034", 2, "x" ) ]++;
+        CPPUNIT_ASSERT( array.size() == 1 );
+        // Stored under the joined key, as for( k in arr ) & split() see it
+        CPPUNIT_ASSERT( double( array["2\034x"] ) == 6 );
+        CPPUNIT_ASSERT( array.contains( subscripts( "\034", 2.0, "x" ) ) );
+        CPPUNIT_ASSERT( ! array.contains( subscripts( "\034", "2x", "" ) ) );
+        CPPUNIT_ASSERT( array.keys()[0] == "2\034x" );
+        array[ subscripts( ":", 0.5, 1, "y" ) ] = Awkccc_variable( 1.0 );
+        CPPUNIT_ASSERT( array.contains( "0.5:1:y" ) );
+        CPPUNIT_ASSERT( array.erase( subscripts( ":", 0.5, 1, "y" ) ) );
+        CPPUNIT_ASSERT( ! array.erase( subscripts( ":", 0.5, 1, "y" ) ) );
+        // A separator of digits can join into an integer subscript
+        array[ subscripts( "", 1, 2 ) ] = Awkccc_variable( 7.0 );
+        CPPUNIT_ASSERT( array.contains( 12 ) && array.size() == 2 );
+    }
+    void testArrayKeyFromSameArray() {
+        // a[a["x"]] adds an element keyed by text the array holds, while
+        // growing the table moves it
+        for( const char * text : { "new", "a new & longer subscript" } ) {
+            Awkccc_array array;
+            array["x"] = Awkccc_variable( text );
+            for( int i = 0; i < 11; ++i )
+                array[ "key " + std::to_string( i ) ] = Awkccc_variable( double( i ) );
+            array[ array["x"] ] = Awkccc_variable( 1.0 );
+            CPPUNIT_ASSERT( array.size() == 13 && array.contains( text ) );
+            CPPUNIT_ASSERT( double( array[text] ) == 1 );
+        }
+    }
+    void testInternTable() {
+        Awkccc_intern_table table;
+        Awkccc_variable first = table.intern( "somewhere.example.com" );
+        Awkccc_variable again = table.intern( "somewhere.example.com" );
+        Awkccc_variable other = Awkccc_variable::from_input( "somewhere.example.com" );
+        CPPUNIT_ASSERT( first.same_text( again ) && ! first.same_text( other ) );
+        CPPUNIT_ASSERT( first == other && first.compare( again ) == 0 );
+        CPPUNIT_ASSERT( table.size() == 1 );
+        // Numeric strings stay numeric, short texts aren't held
+        Awkccc_variable number = table.intern( "12345678.5" );
+        CPPUNIT_ASSERT( number.data_type() == Numeric_String && double( number ) == 12345678.5 );
+        table.intern( "short" );
+        CPPUNIT_ASSERT( table.size() == 2 );
+        // Keys are found by shared text or by comparing it
+        Awkccc_array array;
+        array[first]++;
+        array[again]++;
+        array[other]++;
+        array["somewhere.example.com"]++;
+        CPPUNIT_ASSERT( array.size() == 1 && double( array[first] ) == 4 );
+        // A full table still makes values, just not shared ones
+        Awkccc_intern_table tiny( 1 );
+        for( int i = 0; i < 100; ++i )
+            tiny.intern( "key number " + std::to_string( i ) );
+        CPPUNIT_ASSERT( tiny.size() <= Awkccc_intern_table::shard_count_ );
+        CPPUNIT_ASSERT( tiny.intern( "key number 99" ).string_value() == "key number 99" );
+    }
+    void testArrayMatchesMap() {
+        // Random inserts & deletes, with integer keys both inside & far
+        // outside the vector's range, must leave the same elements as std::map
+        Awkccc_array array;
+        std::map<std::string, double> expected;
+        unsigned seed = 12345;
+        auto next = [&]() {
+            seed = seed * 1103515245 + 12345;
+            return ( seed >> 8 ) & 0xFFFF;
+        };
+        for( int step = 0; step < 20000; ++step ) {
+            unsigned r = next();
+            std::string key;
+            switch( r % 4 ) {
+                case 0: key = std::to_string( r % 300 ); break;
+                case 1: key = std::to_string( r * 1000 ); break;
+                case 2: key = "k" + std::to_string( r % 500 ); break;
+                default: key = "0" + std::to_string( r % 20 ); break;
+            }
+            if( next() % 3 == 0 ) {
+                CPPUNIT_ASSERT( array.erase( key ) == ( expected.erase( key ) == 1 ) );
+            } else {
+                array[key]++;
+                expected[key]++;
+            }
+        }
+        CPPUNIT_ASSERT( array.size() == expected.size() );
+        for( auto & element : expected ) {
+            const Awkccc_variable * found = array.find( element.first );
+            CPPUNIT_ASSERT( found != nullptr && double( *found ) == element.second );
+        }
+        size_t visited = 0;
+        array.for_each( [&]( std::string_view key, const Awkccc_variable & ) {
+            CPPUNIT_ASSERT( expected.count( std::string( key ) ) == 1 );
+            ++visited;
+        } );
+        CPPUNIT_ASSERT( visited == expected.size() );
+    }
+    void testParseParallelOption() {
+        char arg0[] = "prog", arg1[] = "--parallel=3", arg2[] = "file", arg3[] = "--", arg4[] = "--parallel";
+        char * argv[] = { arg0, arg1, arg2, arg3, arg4, nullptr };
+        int argc = 5;
+        CPPUNIT_ASSERT( parse_parallel_option( argc, argv ) == 3 );
+        CPPUNIT_ASSERT( argc == 4 );
+        CPPUNIT_ASSERT( std::string( argv[1] ) == "file" );
+        CPPUNIT_ASSERT( std::string( argv[3] ) == "--parallel" );
+    }
+
+    CPPUNIT_TEST_SUITE(RuntimeTestClass);
+        CPPUNIT_TEST(testReadMappedFile);
+        CPPUNIT_TEST(testReadPipe);
+        CPPUNIT_TEST(testParagraphMode);
+        CPPUNIT_TEST(testRuntimeCountsRecords);
+        CPPUNIT_TEST(testReadSyntheticFile);
+        CPPUNIT_TEST(testDefaultRuntimeReads);
+        CPPUNIT_TEST(testArenaTemporaries);
+        CPPUNIT_TEST(testGetlineKeepsTemporaries);
+        CPPUNIT_TEST(testFieldsSplitLazily);
+        CPPUNIT_TEST(testFieldsSplitToHighestConstant);
+        CPPUNIT_TEST(testFieldNumbersCachedPerRecord);
+        CPPUNIT_TEST(testFieldsSingleCharacterFS);
+        CPPUNIT_TEST(testFieldsRegexFS);
+        CPPUNIT_TEST(testSplitKernelsAgree);
+        CPPUNIT_TEST(testPlanShardsAtSeparators);
+        CPPUNIT_TEST(testReductions);
+        CPPUNIT_TEST(testParallelSumNeverIncremented);
+        CPPUNIT_TEST(testParallelLastAssignedUninitialised);
+        CPPUNIT_TEST(testParallelMatchesSequential);
+        CPPUNIT_TEST(testParseParallelOption);
+        CPPUNIT_TEST(testOrderedOutputMatchesSequential);
+        CPPUNIT_TEST(testWriterBuffersUntilFull);
+        CPPUNIT_TEST(testWriterFormatsNumbers);
+        CPPUNIT_TEST(testConcatenateOnce);
+        CPPUNIT_TEST(testConvfmtAssignment);
+        CPPUNIT_TEST(testSystemStatus);
+        CPPUNIT_TEST(testOutputTableEvictsLeastRecentlyUsed);
+        CPPUNIT_TEST(testOutputTablePipe);
+        CPPUNIT_TEST(testStandardStreamRedirection);
+        CPPUNIT_TEST(testRegexCacheReusesCompiled);
+        CPPUNIT_TEST(testRegexCacheLiteralsSkipCompiling);
+        CPPUNIT_TEST(testRegexCacheAwkEscapes);
+        CPPUNIT_TEST(testBadRegexIsFatal);
+        CPPUNIT_TEST(testRuntimeMatchSetsRstart);
+        CPPUNIT_TEST(testArraySubscripts);
+        CPPUNIT_TEST(testArrayTupleSubscripts);
+        CPPUNIT_TEST(testArrayKeyFromSameArray);
+        CPPUNIT_TEST(testInternTable);
+        CPPUNIT_TEST(testArrayMatchesMap);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RuntimeTestClass);
+
+#ifdef ONE_FIXTURE
+int main(int argc, char* argv[])
+{
+    // Get the top level suite from the registry
+    CPPUNIT_NS::Test *suite = CPPUNIT_NS::TestFactoryRegistry::getRegistry().makeTest();
+
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(suite);
+    bool wasSucessful = runner.run();
+    char* c = (char*) malloc(10 * sizeof (char));
+    //scanf (c,"%c");
+    return wasSucessful ? 0 : 1;
+}
+#endif
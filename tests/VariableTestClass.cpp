@@ -33,6 +33,9 @@ SOFTWARE.
 #endif
 #include <cppunit/extensions/HelperMacros.h>
 #include <cmath>
+#include <cstdlib>
+#include <new>
+#include <utility>
 #include "../include/awkccc_variable.h++"
 using namespace jclib;
 using namespace awkccc;
@@ -40,6 +43,21 @@ using namespace awkccc;
 using namespace jclib;
 using namespace awkccc;
 
+/// Heap allocations so far, for the tests that expect none
+static size_t allocations = 0;
+void * operator new( size_t size ) {
+    ++allocations;
+    if( void * memory = std::malloc( size ? size : 1 ) )
+        return memory;
+    throw std::bad_alloc();
+}
+void operator delete( void * memory ) noexcept {
+    std::free( memory );
+}
+void operator delete( void * memory, size_t ) noexcept {
+    std::free( memory );
+}
+
 class VariableTestClass : public CPPUNIT_NS::TestFixture {
 public:
     VariableTestClass() {}
@@ -51,46 +69,111 @@ public:
 private:
     void testCreateEmpty() {
         Awkccc_variable var;
-        CPPUNIT_ASSERT( var.number_is_valid_ );
-        CPPUNIT_ASSERT( var.string_is_valid_ );
+        CPPUNIT_ASSERT( var.number_is_valid() );
+        CPPUNIT_ASSERT( var.string_is_valid() );
         CPPUNIT_ASSERT(fabs(var.number_) < Awkccc_variable::epsilon_ );
-        CPPUNIT_ASSERT(var.string_ == "" );
+        CPPUNIT_ASSERT(var.string_value() == "" );
     }
     void testCreateInt() {
         Awkccc_variable var(6);
-        CPPUNIT_ASSERT( var.number_is_valid_ );
-        CPPUNIT_ASSERT( ! var.string_is_valid_ );
+        CPPUNIT_ASSERT( var.number_is_valid() );
+        CPPUNIT_ASSERT( ! var.string_is_valid() );
         CPPUNIT_ASSERT(fabs(var.number_ - 6) < Awkccc_variable::epsilon_ );
     }
     void testCreateDouble() {
         Awkccc_variable var(6.1);
-        CPPUNIT_ASSERT( var.number_is_valid_ );
-        CPPUNIT_ASSERT( ! var.string_is_valid_ );
+        CPPUNIT_ASSERT( var.number_is_valid() );
+        CPPUNIT_ASSERT( ! var.string_is_valid() );
         CPPUNIT_ASSERT(fabs(var.number_ - 6.1) < Awkccc_variable::epsilon_ );
     }
     void testCreateString() {
         Awkccc_variable var("6x1");
-        CPPUNIT_ASSERT(! var.number_is_valid_ );
-        CPPUNIT_ASSERT( var.string_is_valid_ );
+        CPPUNIT_ASSERT(! var.number_is_valid() );
+        CPPUNIT_ASSERT( var.string_is_valid() );
         // FIXME need compare Awkccc_variable
-        CPPUNIT_ASSERT(var.string_ == "6x1" );
+        CPPUNIT_ASSERT(var.string_value() == "6x1" );
     }
     void testCreateNumericString() {
         Awkccc_variable var("7",7.0);
-        CPPUNIT_ASSERT( var.number_is_valid_ );
-        CPPUNIT_ASSERT( var.string_is_valid_ );
+        CPPUNIT_ASSERT( var.number_is_valid() );
+        CPPUNIT_ASSERT( var.string_is_valid() );
         CPPUNIT_ASSERT(fabs(var.number_)-7.0 < Awkccc_variable::epsilon_ );
-        CPPUNIT_ASSERT(var.string_ == "7" );
+        CPPUNIT_ASSERT(var.string_value() == "7" );
     }
     void testCastStringToNumber() {
         Awkccc_variable var("7");
-        CPPUNIT_ASSERT( !var.number_is_valid_ );
-        CPPUNIT_ASSERT( var.string_is_valid_ );
-        CPPUNIT_ASSERT(var.string_ == "7" );
+        CPPUNIT_ASSERT( !var.number_is_valid() );
+        CPPUNIT_ASSERT( var.string_is_valid() );
+        CPPUNIT_ASSERT(var.string_value() == "7" );
         CPPUNIT_ASSERT(fabs((double)var)-7.0 < Awkccc_variable::epsilon_ );
-        CPPUNIT_ASSERT( var.number_is_valid_ );
+        CPPUNIT_ASSERT( var.number_is_valid() );
         CPPUNIT_ASSERT(fabs(var.number_)-7.0 < Awkccc_variable::epsilon_ );
-        CPPUNIT_ASSERT(var.string_ == "7" ); // unchanged
+        CPPUNIT_ASSERT(var.string_value() == "7" ); // unchanged
+    }
+    void testCompactLayout() {
+        CPPUNIT_ASSERT( sizeof( Awkccc_variable ) == 16 );
+        Awkccc_variable shorter("abcdef"), longer("abcdefg, and more");
+        CPPUNIT_ASSERT( shorter.string_value() == "abcdef" );
+        CPPUNIT_ASSERT( longer.string_value() == "abcdefg, and more" );
+        Awkccc_variable copy( longer );
+        // Copies share the text
+        CPPUNIT_ASSERT( copy.string_value().data() == longer.string_value().data() );
+        longer = shorter;
+        CPPUNIT_ASSERT( longer.string_value() == "abcdef" );
+        CPPUNIT_ASSERT( copy.string_value() == "abcdefg, and more" );
+        CPPUNIT_ASSERT( copy.data_type() == String );
+        CPPUNIT_ASSERT( Awkccc_variable( "12", 12.0 ).data_type() == Numeric_String );
+        CPPUNIT_ASSERT( jString( copy ) == "abcdefg, and more" );
+    }
+    void testScanNumber() {
+        double value;
+        CPPUNIT_ASSERT( scan_number( " 1234567890123 ", value ) && value == 1234567890123.0 );
+        CPPUNIT_ASSERT( scan_number( "-2.5e2", value ) && value == -250 );
+        CPPUNIT_ASSERT( scan_number( "+.5", value ) && value == 0.5 );
+        CPPUNIT_ASSERT( ! scan_number( "12abc", value ) && value == 12 );
+        CPPUNIT_ASSERT( ! scan_number( "1e", value ) && value == 1 );
+        CPPUNIT_ASSERT( ! scan_number( "", value ) && value == 0 );
+        CPPUNIT_ASSERT( ! scan_number( "0x1A", value ) && value == 0 );
+    }
+    void testNumberFormat() {
+        Awkccc_number_format::text buf;
+        CPPUNIT_ASSERT( Awkccc_number_format( "%.6g" ).format( 3.14159265, buf ) == "3.14159" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "%.6g" ).format( 1e20 + 4096, buf ) == "1e+20" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "%.2f" ).format( 2.675, buf ) == "2.67" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "%.3e" ).format( 12345.6, buf ) == "1.235e+04" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "%d" ).format( -7.9, buf ) == "-7" );
+        // Integral values are integers whatever the format
+        CPPUNIT_ASSERT( Awkccc_number_format( "%.2f" ).format( -42, buf ) == "-42" );
+        // Anything else is printf's
+        CPPUNIT_ASSERT( Awkccc_number_format( "%6.1f" ).format( 2.25, buf ) == "   2.2" );
+        // Integer conversions are given a long long, whatever their flags & width
+        CPPUNIT_ASSERT( Awkccc_number_format( "%5d" ).format( 3.5, buf ) == "    3" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "%-4i|" ).format( -2.5, buf ) == "-2  |" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "%x" ).format( 255.5, buf ) == "ff" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "%#o" ).format( 8.5, buf ) == "010" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "%c" ).format( 65.5, buf ) == "A" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "<%-8.2f>" ).format( 0.125, buf ) == "<0.12    >" );
+        // Text around the conversion & %% are kept
+        CPPUNIT_ASSERT( Awkccc_number_format( "%.1f%%" ).format( 12.25, buf ) == "12.2%" );
+        // No numeric conversion, or more than one, is %.6g
+        CPPUNIT_ASSERT( Awkccc_number_format( "%s" ).format( 0.5, buf ) == "0.5" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "%n" ).format( 0.5, buf ) == "0.5" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "%f %f" ).format( 1.0 / 3, buf ) == "0.333333" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "none" ).format( 0.25, buf ) == "0.25" );
+        CPPUNIT_ASSERT( Awkccc_number_format( "%*d" ).format( 0.25, buf ) == "0.25" );
+        Awkccc_number_format format;
+        format.update( "%.2f" );
+        CPPUNIT_ASSERT( format.spec() == "%.2f" && format.format( 0.125, buf ) == "0.12" );
+    }
+    void testInputIsNumericString() {
+        Awkccc_variable field = Awkccc_variable::from_input( " 10 " );
+        Awkccc_variable word = Awkccc_variable::from_input( "10x" );
+        CPPUNIT_ASSERT( field.data_type() == Numeric_String && field.number_is_valid() );
+        CPPUNIT_ASSERT( word.data_type() == String && double( word ) == 10 );
+        // Numeric strings compare as numbers, other strings as strings
+        CPPUNIT_ASSERT( field > Awkccc_variable( 9.0 ) );
+        CPPUNIT_ASSERT( word < Awkccc_variable( 9.0 ) );
+        CPPUNIT_ASSERT( Awkccc_variable( "10" ) < Awkccc_variable( 9.0 ) );
     }
     void testCompareNumeric() {
         Awkccc_variable one(1);
@@ -136,8 +219,8 @@ private:
     }
     void testCastIntegerToString() {
         Awkccc_variable var(7);
-        CPPUNIT_ASSERT( var.number_is_valid_ );
-        CPPUNIT_ASSERT( !var.string_is_valid_ );
+        CPPUNIT_ASSERT( var.number_is_valid() );
+        CPPUNIT_ASSERT( !var.string_is_valid() );
         jString ans = (jString)var.format();
         CPPUNIT_ASSERT(ans == "7");
         CPPUNIT_ASSERT(fabs(var.number_)-7.0 < Awkccc_variable::epsilon_ ); // unchanged
@@ -145,8 +228,8 @@ private:
 
     void testCastNegIntegerToString() {
         Awkccc_variable var(-7);
-        CPPUNIT_ASSERT( var.number_is_valid_ );
-        CPPUNIT_ASSERT( !var.string_is_valid_ );
+        CPPUNIT_ASSERT( var.number_is_valid() );
+        CPPUNIT_ASSERT( !var.string_is_valid() );
         jString ans = (jString)var.format();
         CPPUNIT_ASSERT(ans == "-7");
         CPPUNIT_ASSERT(fabs(var.number_)-7.0 < Awkccc_variable::epsilon_ ); // unchanged
@@ -154,8 +237,8 @@ private:
 
     void testCastNumberToString() {
         Awkccc_variable var(7.5);
-        CPPUNIT_ASSERT( var.number_is_valid_ );
-        CPPUNIT_ASSERT( !var.string_is_valid_ );
+        CPPUNIT_ASSERT( var.number_is_valid() );
+        CPPUNIT_ASSERT( !var.string_is_valid() );
         jString ans = (jString)var.format();
         CPPUNIT_ASSERT(ans == "7.5");
         CPPUNIT_ASSERT(fabs(var.number_)-7.5 < Awkccc_variable::epsilon_ ); // unchanged
@@ -163,8 +246,8 @@ private:
 
     void testCastNegNumberToString() {
         Awkccc_variable var(-7.5);
-        CPPUNIT_ASSERT( var.number_is_valid_ );
-        CPPUNIT_ASSERT( !var.string_is_valid_ );
+        CPPUNIT_ASSERT( var.number_is_valid() );
+        CPPUNIT_ASSERT( !var.string_is_valid() );
         jString ans = (jString)var.format();
         CPPUNIT_ASSERT(ans == "-7.5");
         CPPUNIT_ASSERT(fabs(var.number_)-7.5 < Awkccc_variable::epsilon_ ); // unchanged
@@ -202,6 +285,34 @@ private:
         CPPUNIT_ASSERT(fabs(ans.number_)-5.5 < Awkccc_variable::epsilon_);
     }
 
+    void testMove() {
+        Awkccc_variable longer("a string too long to be inline");
+        const char * text = longer.string_value().data();
+        size_t before = allocations;
+        Awkccc_variable moved( std::move( longer ) );
+        CPPUNIT_ASSERT( moved.string_value().data() == text );
+        CPPUNIT_ASSERT( longer.data_type() == Uninitialised && longer.string_value() == "" );
+        Awkccc_variable target(1.0);
+        target = std::move( moved );
+        CPPUNIT_ASSERT( target.string_value().data() == text );
+        CPPUNIT_ASSERT( allocations == before );
+    }
+    void testArithmeticDoesNotAllocate() {
+        Awkccc_variable a("1234567.5"), b("2"), c(3.0), d("a long string, worth 0"), ans;
+        double ignored = a + b;     // Convert the strings once, outside the count
+        ignored += double( d );
+        size_t before = allocations;
+        ans = a + b * c - d;
+        CPPUNIT_ASSERT( fabs( double( ans ) - 1234573.5 ) < Awkccc_variable::epsilon_ );
+        ans = ( a - 7.5 ) / b + 1;
+        CPPUNIT_ASSERT( fabs( double( ans ) - 617281 ) < Awkccc_variable::epsilon_ );
+        ans += c;
+        ans *= 2;
+        CPPUNIT_ASSERT( fabs( double( ans ) - 1234568 ) < Awkccc_variable::epsilon_ );
+        CPPUNIT_ASSERT( a % 10 == 7 );
+        CPPUNIT_ASSERT( allocations == before );
+        CPPUNIT_ASSERT( ans.data_type() == Number && ! ans.string_is_valid() );
+    }
     void testIncDec() {
         Awkccc_variable countup("13");
         CPPUNIT_ASSERT(countup ++ - 13 < Awkccc_variable::epsilon_);
@@ -222,6 +333,10 @@ private:
         CPPUNIT_TEST(testCreateString);
         CPPUNIT_TEST(testCreateNumericString);
         CPPUNIT_TEST(testCastStringToNumber);
+        CPPUNIT_TEST(testCompactLayout);
+        CPPUNIT_TEST(testScanNumber);
+        CPPUNIT_TEST(testNumberFormat);
+        CPPUNIT_TEST(testInputIsNumericString);
         CPPUNIT_TEST(testCompareNumeric);
         CPPUNIT_TEST(testCompareString);
         CPPUNIT_TEST(testCompareStringOps);
@@ -232,6 +347,8 @@ private:
         CPPUNIT_TEST(testCastNegNumberToString);
         CPPUNIT_TEST(testBasicMath);
         CPPUNIT_TEST(testIncDec);
+        CPPUNIT_TEST(testMove);
+        CPPUNIT_TEST(testArithmeticDoesNotAllocate);
     CPPUNIT_TEST_SUITE_END();
 };
 